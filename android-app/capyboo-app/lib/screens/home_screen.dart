@@ -77,7 +77,7 @@ class _HomeScreenState extends State<HomeScreen> with TickerProviderStateMixin {
     }
   }
 
-  Future<void> _sendTime(BleService bleService) async {
+  String _timeCommand() {
     final now = DateTime.now();
     final hour = now.hour.toString().padLeft(2, '0');
     final minute = now.minute.toString().padLeft(2, '0');
@@ -86,22 +86,17 @@ class _HomeScreenState extends State<HomeScreen> with TickerProviderStateMixin {
     final month = now.month.toString().padLeft(2, '0');
     final year = now.year.toString();
 
-    final timeCommand = 'time:$hour:$minute:$second $date/$month/$year';
-    final success = await bleService.sendCommand(timeCommand);
-    if (mounted) {
-      _showCuteSnackBar(
-        success ? '⏰ Time synced!' : '😢 Failed to sync time',
-        success,
-      );
-    }
+    return 'time:$hour:$minute:$second $date/$month/$year';
   }
 
-  Future<void> _sendWeather(BleService bleService) async {
+  /// The weather: command for the current location, or null (after telling
+  /// the user) if it could not be put together
+  Future<String?> _weatherCommand() async {
     try {
       final location = await _getCurrentLocation();
       if (location == null) {
         if (mounted) _showCuteSnackBar('📍 Could not get location', false);
-        return;
+        return null;
       }
 
       final cityName = await _getCityName(
@@ -116,17 +111,10 @@ class _HomeScreenState extends State<HomeScreen> with TickerProviderStateMixin {
       final description =
           weatherData?['weather']?[0]?['description'] ?? 'Unknown';
 
-      final weatherCommand =
-          'weather:$cityName:$temp:$feelsLike:$humidity:$description';
-      final success = await bleService.sendCommand(weatherCommand);
-      if (mounted) {
-        _showCuteSnackBar(
-          success ? '☀️ Weather sent for $cityName!' : '😢 Failed',
-          success,
-        );
-      }
+      return 'weather:$cityName:$temp:$feelsLike:$humidity:$description';
     } catch (e) {
       if (mounted) _showCuteSnackBar('😢 Error: $e', false);
+      return null;
     }
   }
 
@@ -762,15 +750,18 @@ class _HomeScreenState extends State<HomeScreen> with TickerProviderStateMixin {
               command: mode['command'] as String,
               colors: mode['colors'] as List<Color>,
               onTap: () async {
+                // Data for the mode and the switch itself go out together
+                // and are acknowledged in one round trip
+                final commands = <String>[];
                 if (mode['command'] == 'mode:weather') {
-                  await _sendWeather(bleService);
+                  final weather = await _weatherCommand();
+                  if (weather != null) commands.add(weather);
                 } else if (mode['command'] == 'mode:clock') {
-                  await _sendTime(bleService);
+                  commands.add(_timeCommand());
                 }
-                await Future.delayed(const Duration(milliseconds: 500));
-                final success = await bleService.sendCommand(
-                  mode['command'] as String,
-                );
+                commands.add(mode['command'] as String);
+                final results = await bleService.sendBatch(commands);
+                final success = results.every((ok) => ok);
                 if (mounted) {
                   _showCuteSnackBar(
                     success
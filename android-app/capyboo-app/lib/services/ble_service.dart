@@ -1,5 +1,7 @@
 import 'dart:async';
 import 'dart:convert';
+import 'dart:math';
+import 'dart:typed_data';
 import 'package:flutter/foundation.dart';
 import 'package:flutter_blue_plus/flutter_blue_plus.dart';
 
@@ -11,11 +13,173 @@ class BleUuids {
       "0000fff1-0000-1000-8000-00805f9b34fb"; // ESP32 TX (we read)
   static const String rxCharUuid =
       "0000fff2-0000-1000-8000-00805f9b34fb"; // ESP32 RX (we write)
+  static const String bulkCharUuid =
+      "0000fff3-0000-1000-8000-00805f9b34fb"; // Asset uploads (we write)
+  static const String streamCharUuid =
+      "0000fff4-0000-1000-8000-00805f9b34fb"; // Live frames (we write)
 
   // Short UUIDs (16-bit) for matching
   static const String serviceShort = "fff0";
   static const String txCharShort = "fff1";
   static const String rxCharShort = "fff2";
+  static const String bulkCharShort = "fff3";
+  static const String streamCharShort = "fff4";
+}
+
+/// Binary command framing understood by the firmware (ble_frame.h):
+/// 0x02, payload length (u16 little-endian), UTF-8 payload, then the
+/// CRC-16/CCITT-FALSE of the length bytes and payload (u16 little-endian).
+/// The ESP32 runs a framed command as soon as its last byte arrives,
+/// instead of waiting for a newline or 100 ms of silence.
+class BleFrame {
+  static const int start = 0x02;
+  static const int maxPayload = 256;
+
+  static int crc16(List<int> data, [int crc = 0xFFFF]) {
+    for (final byte in data) {
+      crc ^= byte << 8;
+      for (int bit = 0; bit < 8; bit++) {
+        crc = (crc & 0x8000) != 0 ? ((crc << 1) ^ 0x1021) : (crc << 1);
+        crc &= 0xFFFF;
+      }
+    }
+    return crc;
+  }
+
+  /// Wrap a command in a frame. Throws if it is too long for the firmware.
+  static List<int> encode(String command) {
+    final payload = utf8.encode(command);
+    if (payload.length > maxPayload) {
+      throw ArgumentError("Command too long (${payload.length} bytes)");
+    }
+    final header = [payload.length & 0xFF, payload.length >> 8];
+    final crc = crc16(payload, crc16(header));
+    return [start, ...header, ...payload, crc & 0xFF, crc >> 8];
+  }
+}
+
+/// Animation uploads (asset_upload.h). The file is sent to the bulk
+/// characteristic in chunks: offset (u32 little-endian), CRC-16 of the
+/// data (u16 little-endian), then the data. The firmware acks progress
+/// with "asset:ack:<offset>" and asks for a resend with
+/// "asset:resend:<offset>"; the file as a whole is checked with CRC-32.
+class AssetUpload {
+  static const int frameBytes = 1024; // 128x64, 1 bit per pixel
+  static const int chunkHeader = 6;
+  static const int maxWrite = 512; // Largest write the firmware takes
+  static const Duration ackTimeout = Duration(seconds: 3);
+  static const int maxRetries = 5;
+
+  static final List<int> _crc32Table = List.generate(256, (i) {
+    int crc = i;
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc & 1) != 0 ? (crc >> 1) ^ 0xEDB88320 : crc >> 1;
+    }
+    return crc;
+  });
+
+  /// CRC-32 (IEEE, as zlib computes it)
+  static int crc32(List<int> data) {
+    int crc = 0xFFFFFFFF;
+    for (final byte in data) {
+      crc = (crc >> 8) ^ _crc32Table[(crc ^ byte) & 0xFF];
+    }
+    return crc ^ 0xFFFFFFFF;
+  }
+
+  /// One bulk write: [length] bytes of [file] from [offset], with header
+  static List<int> chunk(Uint8List file, int offset, int length) {
+    final data = file.sublist(offset, offset + length);
+    final crc = BleFrame.crc16(data);
+    return [
+      offset & 0xFF,
+      (offset >> 8) & 0xFF,
+      (offset >> 16) & 0xFF,
+      (offset >> 24) & 0xFF,
+      crc & 0xFF,
+      crc >> 8,
+      ...data,
+    ];
+  }
+}
+
+/// Live frames for mode:stream (frame_stream.h). Each frame is the XOR
+/// against the previous one, run-length coded, split into writes of
+/// frame number, flags, start byte (u16 little-endian) and whole runs:
+/// 00nnnnnn skips n+1 bytes, 01nnnnnn b XORs b into n+1 bytes and
+/// 1nnnnnnn XORs in the n+1 bytes that follow. Every run fits in one write
+/// on its own, so no write is ever just a header or longer than [maxWrite].
+class FrameStreamEncoder {
+  static const int frameBytes = 1024; // 128x64 in the panel's page layout
+  static const int header = 4;
+  static const int flagKey = 0x01;
+  static const int flagEnd = 0x02;
+
+  /// The writes for [frame] against [previous]; without one it is a key
+  /// frame, coded against a blank screen
+  static List<List<int>> encode(
+    Uint8List? previous,
+    Uint8List frame,
+    int number,
+    int maxWrite,
+  ) {
+    final delta = Uint8List(frameBytes);
+    for (int i = 0; i < frameBytes; i++) {
+      delta[i] = frame[i] ^ (previous?[i] ?? 0);
+    }
+    final flags = previous == null ? flagKey : 0;
+
+    // Room for runs in one write. Skips (1 byte) and repeats (2) always
+    // fit; literals are cut to fit
+    assert(maxWrite >= header + 2);
+    final room = maxWrite - header;
+    final maxLiteral = min(128, room - 1);
+
+    final writes = <List<int>>[];
+    List<int> startWrite(int start) =>
+        [number & 0xFF, flags, start & 0xFF, start >> 8];
+    var write = startWrite(0);
+    int i = 0;
+    while (i < frameBytes) {
+      final start = i;
+      final run = <int>[];
+      int n = 1;
+      while (i + n < frameBytes && n < 64 && delta[i + n] == delta[i]) {
+        n++;
+      }
+      if (delta[i] == 0) {
+        run.add(n - 1);
+        i += n;
+      } else if (n >= 3) {
+        run.addAll([0x40 | (n - 1), delta[i]]);
+        i += n;
+      } else {
+        // Literal bytes up to the next unchanged byte or repeat
+        n = 0;
+        while (i + n < frameBytes &&
+            n < maxLiteral &&
+            delta[i + n] != 0 &&
+            !(i + n + 2 < frameBytes &&
+                delta[i + n + 1] == delta[i + n] &&
+                delta[i + n + 2] == delta[i + n])) {
+          n++;
+        }
+        if (n == 0) n = 1;
+        run.add(0x80 | (n - 1));
+        run.addAll(delta.sublist(i, i + n));
+        i += n;
+      }
+
+      if (write.length + run.length > maxWrite && write.length > header) {
+        writes.add(write);
+        write = startWrite(start);
+      }
+      write.addAll(run);
+    }
+    write[1] |= flagEnd;
+    writes.add(write);
+    return writes;
+  }
 }
 
 /// Connection state enum
@@ -28,6 +192,8 @@ class BleService extends ChangeNotifier {
   BluetoothDevice? _connectedDevice;
   BluetoothCharacteristic? _rxCharacteristic;
   BluetoothCharacteristic? _txCharacteristic;
+  BluetoothCharacteristic? _bulkCharacteristic;
+  BluetoothCharacteristic? _streamCharacteristic;
   StreamSubscription<List<int>>? _notificationSubscription;
   StreamSubscription<BluetoothConnectionState>? _connectionSubscription;
   StreamSubscription<List<ScanResult>>? _scanSubscription;
@@ -35,6 +201,35 @@ class BleService extends ChangeNotifier {
   BleConnectionState _connectionState = BleConnectionState.disconnected;
   String _statusMessage = "Not connected";
   String _lastResponse = "";
+  // Notification bytes not yet ending in a newline. The firmware packs
+  // several replies into one notification and may split a long one.
+  final List<int> _responseBuffer = [];
+
+  // Sequenced commands waiting for the firmware's ack/nack, by ID
+  static const Duration ackTimeout = Duration(seconds: 5);
+  int _nextSequence = 1;
+  final Map<int, Completer<bool>> _pendingAcks = {};
+
+  // "asset:" replies for the upload in progress, oldest first
+  bool _uploading = false;
+  final List<String> _assetReplies = [];
+  Completer<void>? _assetReplyWaiter;
+
+  // Live streaming: at most streamWindow frames unacknowledged; a frame
+  // that cannot go out yet is replaced by the next one (skipped)
+  static const int streamWindow = 3;
+  static const Duration streamTimeout = Duration(seconds: 1);
+  bool _streaming = false;
+  bool _streamSending = false;
+  bool _streamNeedKey = true;
+  int _streamNumber = 0;
+  int _streamAcked = 0;
+  DateTime _streamProgressAt = DateTime.now();
+  Uint8List? _streamReference; // Last frame sent
+  Uint8List? _streamPending; // Newest frame not sent yet
+  int _streamFramesSent = 0;
+  int _streamFramesSkipped = 0;
+
   final List<BluetoothDevice> _scannedDevices = [];
 
   // Getters
@@ -44,6 +239,9 @@ class BleService extends ChangeNotifier {
   List<BluetoothDevice> get scannedDevices => _scannedDevices;
   bool get isConnected => _connectionState == BleConnectionState.connected;
   BluetoothDevice? get connectedDevice => _connectedDevice;
+  bool get isStreaming => _streaming;
+  int get streamFramesSent => _streamFramesSent;
+  int get streamFramesSkipped => _streamFramesSkipped;
 
   /// Initialize BLE and check adapter state
   Future<bool> initialize() async {
@@ -239,6 +437,12 @@ class BleService extends ChangeNotifier {
         } else if (_uuidMatches(uuid, BleUuids.txCharShort)) {
           _txCharacteristic = characteristic;
           debugPrint(">>> Found TX characteristic: $uuid");
+        } else if (_uuidMatches(uuid, BleUuids.bulkCharShort)) {
+          _bulkCharacteristic = characteristic;
+          debugPrint(">>> Found bulk characteristic: $uuid");
+        } else if (_uuidMatches(uuid, BleUuids.streamCharShort)) {
+          _streamCharacteristic = characteristic;
+          debugPrint(">>> Found stream characteristic: $uuid");
         }
       }
 
@@ -255,9 +459,7 @@ class BleService extends ChangeNotifier {
           value,
         ) {
           if (value.isNotEmpty) {
-            _lastResponse = utf8.decode(value);
-            debugPrint("Received from ESP32: $_lastResponse");
-            notifyListeners();
+            _receiveResponse(value);
           }
         });
       }
@@ -275,8 +477,269 @@ class BleService extends ChangeNotifier {
     }
   }
 
+  /// Split notification bytes into newline-terminated replies
+  void _receiveResponse(List<int> value) {
+    _responseBuffer.addAll(value);
+    final end = _responseBuffer.lastIndexOf(0x0A);
+    if (end < 0) return;
+
+    final text = utf8.decode(
+      _responseBuffer.sublist(0, end),
+      allowMalformed: true,
+    );
+    _responseBuffer.removeRange(0, end + 1);
+    for (final raw in text.split("\n")) {
+      final line = raw.trim();
+      if (line.isEmpty) continue;
+      if (line.startsWith("ack:")) {
+        _completeAcks(line.substring(4), true);
+      } else if (line.startsWith("nack:")) {
+        _completeAcks(line.substring(5), false);
+      } else {
+        // Replies to sequenced commands carry a "#<id> " prefix
+        final reply = line.startsWith("#") && line.contains(" ")
+            ? line.substring(line.indexOf(" ") + 1)
+            : line;
+        if (_uploading && reply.startsWith("asset:")) {
+          _assetReply(reply);
+          continue;
+        }
+        if (_streaming && reply.startsWith("stream:")) {
+          _streamReply(reply);
+          continue;
+        }
+        _lastResponse = reply;
+        debugPrint("Received from ESP32: $line");
+      }
+    }
+    notifyListeners();
+  }
+
+  /// Resolve the commands listed in an ack/nack: "1-3,7"
+  void _completeAcks(String ids, bool ok) {
+    for (final part in ids.split(",")) {
+      final range = part.split("-");
+      final first = int.tryParse(range.first);
+      final last = range.length > 1 ? int.tryParse(range.last) : first;
+      if (first == null || last == null) continue;
+      for (int id = first; id <= last; id++) {
+        _pendingAcks.remove(id)?.complete(ok);
+      }
+    }
+  }
+
+  /// Fail everything still waiting for an ack (the link went away)
+  void _failPendingAcks() {
+    for (final completer in _pendingAcks.values) {
+      completer.complete(false);
+    }
+    _pendingAcks.clear();
+  }
+
+  void _assetReply(String reply) {
+    _assetReplies.add(reply);
+    _assetReplyWaiter?.complete();
+    _assetReplyWaiter = null;
+  }
+
+  /// Next "asset:" reply, or null if none comes within [timeout]
+  Future<String?> _nextAssetReply(Duration timeout) async {
+    if (_assetReplies.isEmpty) {
+      final waiter = Completer<void>();
+      _assetReplyWaiter = waiter;
+      try {
+        await waiter.future.timeout(timeout);
+      } on TimeoutException {
+        _assetReplyWaiter = null;
+        return null;
+      }
+    }
+    return _assetReplies.removeAt(0);
+  }
+
+  /// Upload an animation: [frames] holds whole 1024-byte frames in the
+  /// layout drawBitmap() takes. An upload of the same name, size and
+  /// content that was cut off carries on where it stopped. True once the
+  /// firmware has checked and stored it; it can then be played with
+  /// "mood:<name>".
+  Future<bool> uploadAsset(
+    String name,
+    Uint8List frames, {
+    int frameDelay = 100,
+    void Function(double progress)? onProgress,
+  }) async {
+    if (!isConnected || _bulkCharacteristic == null || _uploading) {
+      return false;
+    }
+    if (frames.isEmpty || frames.length % AssetUpload.frameBytes != 0) {
+      throw ArgumentError(
+        "Frames must be whole ${AssetUpload.frameBytes}-byte bitmaps",
+      );
+    }
+
+    _uploading = true;
+    _assetReplies.clear();
+    try {
+      final crc = AssetUpload.crc32(frames).toRadixString(16);
+      if (!await sendCommand(
+        "asset:upload:$name:${frames.length}:$crc:$frameDelay",
+      )) {
+        return false;
+      }
+      final ready = await _nextAssetReply(ackTimeout);
+      final readyFields = ready?.split(":") ?? [];
+      if (readyFields.length != 4 || readyFields[1] != "ready") return false;
+
+      final chunkSize = min(
+        (_connectedDevice?.mtuNow ?? 23) - 3,
+        AssetUpload.maxWrite,
+      ) - AssetUpload.chunkHeader;
+      int acked = int.parse(readyFields[2]);
+      int next = acked;
+      final windowBytes = int.parse(readyFields[3]) * chunkSize;
+      int retries = 0;
+
+      while (isConnected) {
+        // Keep the window full
+        while (next < frames.length && next - acked < windowBytes) {
+          final length = min(chunkSize, frames.length - next);
+          await _bulkCharacteristic!.write(
+            AssetUpload.chunk(frames, next, length),
+            withoutResponse: true,
+          );
+          next += length;
+        }
+
+        final reply = await _nextAssetReply(AssetUpload.ackTimeout);
+        if (reply == null) {
+          // Nothing heard: go back to the last acked byte
+          if (++retries > AssetUpload.maxRetries) return false;
+          next = acked;
+          continue;
+        }
+        final fields = reply.split(":");
+        final offset = fields.length > 2 ? int.tryParse(fields[2]) : null;
+        switch (fields.length > 1 ? fields[1] : "") {
+          case "ack" when offset != null:
+            if (offset > acked) retries = 0;
+            acked = max(acked, offset);
+            onProgress?.call(acked / frames.length);
+          case "resend" when offset != null:
+            acked = max(acked, offset);
+            next = offset;
+          case "done":
+            return true;
+          case "failed":
+            debugPrint("Asset upload failed: $reply");
+            return false;
+        }
+      }
+      return false;
+    } catch (e) {
+      debugPrint("Asset upload error: $e");
+      return false;
+    } finally {
+      _uploading = false;
+      _assetReplies.clear();
+    }
+  }
+
+  /// Switch the robot to mode:stream; frames then go to [streamFrame]
+  Future<bool> startStream() async {
+    if (!isConnected || _streamCharacteristic == null) return false;
+    _streamNeedKey = true;
+    _streamReference = null;
+    _streamPending = null;
+    _streamAcked = _streamNumber;
+    _streamFramesSent = 0;
+    _streamFramesSkipped = 0;
+    _streaming = await sendCommand("mode:stream");
+    return _streaming;
+  }
+
+  /// Stop sending frames and put the robot back on its animations
+  Future<bool> stopStream() async {
+    _streaming = false;
+    _streamPending = null;
+    return await sendCommand("mode:animation");
+  }
+
+  /// Show [frame] (1024 bytes, 128x64 in the panel's page layout) as
+  /// soon as the link allows. Call it at the rate frames are produced;
+  /// when the link falls behind, frames are skipped rather than queued.
+  void streamFrame(Uint8List frame) {
+    if (!_streaming) return;
+    if (frame.length != FrameStreamEncoder.frameBytes) {
+      throw ArgumentError("Frames are ${FrameStreamEncoder.frameBytes} bytes");
+    }
+    if (_streamPending != null) _streamFramesSkipped++;
+    _streamPending = Uint8List.fromList(frame);
+    _pumpStream();
+  }
+
+  void _streamReply(String reply) {
+    if (reply.startsWith("stream:ack:")) {
+      final number = int.tryParse(reply.substring(11));
+      if (number == null) return;
+      _streamAcked = number;
+      _streamProgressAt = DateTime.now();
+    } else if (reply == "stream:key") {
+      // The robot lost track; resend the current picture whole
+      _streamNeedKey = true;
+      _streamPending ??= _streamReference;
+    }
+    _pumpStream();
+  }
+
+  /// Send the pending frame if the window has room
+  Future<void> _pumpStream() async {
+    if (_streamSending) return;
+    _streamSending = true;
+    try {
+      while (_streaming && _streamPending != null && isConnected) {
+        final inFlight = (_streamNumber - _streamAcked) & 0xFF;
+        if (inFlight >= streamWindow) {
+          if (DateTime.now().difference(_streamProgressAt) < streamTimeout) {
+            break;
+          }
+          // No acks for a while: assume frames were lost, start over
+          _streamAcked = _streamNumber;
+          _streamNeedKey = true;
+        }
+
+        final frame = _streamPending!;
+        _streamPending = null;
+        _streamNumber = (_streamNumber + 1) & 0xFF;
+        if (inFlight == 0) _streamProgressAt = DateTime.now();
+        final maxWrite = min(
+          (_connectedDevice?.mtuNow ?? 23) - 3,
+          AssetUpload.maxWrite,
+        );
+        final writes = FrameStreamEncoder.encode(
+          _streamNeedKey ? null : _streamReference,
+          frame,
+          _streamNumber,
+          maxWrite,
+        );
+        _streamNeedKey = false;
+        _streamReference = frame;
+        for (final write in writes) {
+          await _streamCharacteristic!.write(write, withoutResponse: true);
+        }
+        _streamFramesSent++;
+      }
+    } catch (e) {
+      debugPrint("Stream error: $e");
+      _streamNeedKey = true;
+    } finally {
+      _streamSending = false;
+    }
+  }
+
   /// Disconnect from current device
   Future<void> disconnect() async {
+    _responseBuffer.clear();
+    _failPendingAcks();
     try {
       await _notificationSubscription?.cancel();
       _notificationSubscription = null;
@@ -293,15 +756,23 @@ class BleService extends ChangeNotifier {
       _connectedDevice = null;
       _rxCharacteristic = null;
       _txCharacteristic = null;
+      _bulkCharacteristic = null;
+      _streamCharacteristic = null;
+      _streaming = false;
       _updateState(BleConnectionState.disconnected, "Disconnected");
     }
   }
 
   /// Handle unexpected disconnection
   void _handleDisconnection() {
+    _failPendingAcks();
+    if (_uploading) _assetReply("asset:failed:disconnected");
     _connectedDevice = null;
     _rxCharacteristic = null;
     _txCharacteristic = null;
+    _bulkCharacteristic = null;
+    _streamCharacteristic = null;
+    _streaming = false;
     _notificationSubscription?.cancel();
     _notificationSubscription = null;
     _updateState(BleConnectionState.disconnected, "Device disconnected");
@@ -322,10 +793,7 @@ class BleService extends ChangeNotifier {
       debugPrint("Sending command: wifi:$ssid:****");
 
       // Send command
-      await _rxCharacteristic!.write(
-        utf8.encode(command),
-        withoutResponse: _rxCharacteristic!.properties.writeWithoutResponse,
-      );
+      await _writeFramed(command);
 
       _updateState(BleConnectionState.connected, "WiFi credentials sent!");
       return true;
@@ -336,22 +804,63 @@ class BleService extends ChangeNotifier {
     }
   }
 
-  /// Send a generic command to ESP32
+  /// Send a generic command to ESP32; true once the firmware acks it
   Future<bool> sendCommand(String command) async {
+    final results = await sendBatch([command]);
+    return results.first;
+  }
+
+  /// Send several commands without waiting between them. Each carries a
+  /// sequence ID ("#<id> <command>"); the firmware runs them in order and
+  /// acknowledges them together, so the whole batch costs one round trip.
+  /// Results are in the order of [commands].
+  Future<List<bool>> sendBatch(List<String> commands) async {
     if (!isConnected || _rxCharacteristic == null) {
-      return false;
+      return List.filled(commands.length, false);
     }
 
+    final acks = <Future<bool>>[];
     try {
-      debugPrint("Sending command: $command");
+      for (final command in commands) {
+        final id = _nextSequence;
+        _nextSequence = _nextSequence % 65535 + 1;
+        final completer = Completer<bool>();
+        _pendingAcks[id] = completer;
+        acks.add(
+          completer.future.timeout(
+            ackTimeout,
+            onTimeout: () {
+              _pendingAcks.remove(id);
+              return false;
+            },
+          ),
+        );
+
+        debugPrint("Sending command #$id: $command");
+        await _writeFramed("#$id $command");
+      }
+    } catch (e) {
+      debugPrint("Send command error: $e");
+      while (acks.length < commands.length) {
+        acks.add(Future.value(false));
+      }
+    }
+    return Future.wait(acks);
+  }
+
+  /// Frame a command and write it, split into MTU-sized writes if needed
+  /// (the firmware reassembles frames across writes)
+  Future<void> _writeFramed(String command) async {
+    final frame = BleFrame.encode(command);
+    final chunkSize = (_connectedDevice?.mtuNow ?? 23) - 3;
+    for (int offset = 0; offset < frame.length; offset += chunkSize) {
+      final end = (offset + chunkSize < frame.length)
+          ? offset + chunkSize
+          : frame.length;
       await _rxCharacteristic!.write(
-        utf8.encode(command),
+        frame.sublist(offset, end),
         withoutResponse: _rxCharacteristic!.properties.writeWithoutResponse,
       );
-      return true;
-    } catch (e) {
-      debugPrint("Send command error: $e");
-      return false;
     }
   }
 
@@ -0,0 +1,67 @@
+import 'dart:math';
+import 'dart:typed_data';
+
+import 'package:flutter_test/flutter_test.dart';
+
+import 'package:capyboo_app/services/ble_service.dart';
+
+// Applies writes the way frame_stream.h does, which drops a frame whose
+// next write does not start where the last one ended
+Uint8List decode(List<List<int>> writes, Uint8List? previous) {
+  final frame = Uint8List.fromList(
+    previous ?? Uint8List(FrameStreamEncoder.frameBytes),
+  );
+  int position = 0;
+  for (final write in writes) {
+    expect(write[2] | (write[3] << 8), equals(position));
+    int i = FrameStreamEncoder.header;
+    while (i < write.length) {
+      final control = write[i++];
+      if (control & 0x80 != 0) {
+        final n = (control & 0x7F) + 1;
+        for (int k = 0; k < n; k++) {
+          frame[position++] ^= write[i++];
+        }
+      } else if (control & 0x40 != 0) {
+        final n = (control & 0x3F) + 1;
+        final b = write[i++];
+        for (int k = 0; k < n; k++) {
+          frame[position++] ^= b;
+        }
+      } else {
+        position += control + 1;
+      }
+    }
+  }
+  return frame;
+}
+
+void main() {
+  test('every write fits and carries runs, down to the minimum MTU', () {
+    final random = Random(1);
+    for (final maxWrite in [6, 20, 21, 100, 509]) {
+      for (int round = 0; round < 20; round++) {
+        final previous = round.isOdd
+            ? Uint8List.fromList(List.generate(1024, (_) => random.nextInt(256)))
+            : null;
+        // Noise mixed with unchanged and repeated stretches
+        final frame = Uint8List.fromList(List.generate(1024, (i) {
+          if (random.nextBool()) return random.nextInt(256);
+          return random.nextBool() ? (previous?[i] ?? 0) : 0xFF;
+        }));
+
+        final writes = FrameStreamEncoder.encode(previous, frame, 7, maxWrite);
+        for (final write in writes) {
+          expect(write.length, lessThanOrEqualTo(maxWrite));
+          expect(write.length, greaterThan(FrameStreamEncoder.header));
+          expect(write[0], equals(7));
+          expect(write[1] & FrameStreamEncoder.flagKey,
+              previous == null ? isNonZero : isZero);
+          expect(write[1] & FrameStreamEncoder.flagEnd,
+              identical(write, writes.last) ? isNonZero : isZero);
+        }
+        expect(decode(writes, previous), equals(frame));
+      }
+    }
+  });
+}
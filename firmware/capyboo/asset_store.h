@@ -0,0 +1,170 @@
+#ifndef ASSET_STORE_H
+#define ASSET_STORE_H
+
+#include <Arduino.h>
+#include <esp_partition.h>
+#include "tokenizer.h"
+
+// Animations uploaded at run time, kept in flash.
+//
+// The firmware has no file system, so the SPIFFS data partition that the
+// Arduino partition schemes reserve is used raw, split into fixed slots
+// of ASSET_SLOT_SIZE. A slot starts with an AssetHeader; the frames
+// follow, each a 128x64 1-bit bitmap exactly as drawBitmap() takes it.
+// The header's `committed` word stays erased while the frames are being
+// written and is programmed last, after the CRC of the whole file has
+// been checked, so a slot that lost its client or its power half way is
+// never taken for an animation. At boot the slots are scanned once into
+// the `assets` index; uploads and deletes keep it up to date, so a new
+// animation can be played without a reboot.
+
+#define ASSET_SLOT_SIZE     0x10000     // 64 KB per animation
+#define ASSET_MAX_SLOTS     16
+#define ASSET_HEADER_SIZE   64          // Frames start this far into a slot
+#define ASSET_FRAME_BYTES   1024        // 128 x 64 pixels, 1 bit each
+#define ASSET_MAX_FRAMES    ((ASSET_SLOT_SIZE - ASSET_HEADER_SIZE) / ASSET_FRAME_BYTES)
+#define ASSET_NAME_LENGTH   15
+#define ASSET_MAX_FRAME_DELAY 500       // ms; longer is a slideshow, not an animation
+#define ASSET_SECTOR_SIZE   4096        // Flash erase unit
+#define ASSET_MAGIC         0x41594243  // "CBYA"
+#define ASSET_COMMITTED     0x4B4F4B4F  // Any value other than erased flash
+
+struct AssetHeader {
+    uint32_t magic;
+    char name[ASSET_NAME_LENGTH + 1];
+    uint32_t size;              // Bytes of frame data
+    uint32_t crc;               // CRC-32 of the frame data
+    uint16_t frameDelay;        // ms each frame stays up
+    uint16_t reserved;
+    uint32_t committed;         // ASSET_COMMITTED once complete
+};
+static_assert(sizeof(AssetHeader) <= ASSET_HEADER_SIZE, "asset header does not fit");
+
+// What loop() needs to play an asset, by slot
+struct AssetInfo {
+    bool valid;
+    char name[ASSET_NAME_LENGTH + 1];
+    uint8_t frames;
+    uint16_t frameDelay;
+};
+
+const esp_partition_t* assetPartition = nullptr;
+uint8_t assetSlotCount = 0;
+AssetInfo assets[ASSET_MAX_SLOTS];
+
+// CRC-32 (IEEE, as zlib computes it), with the table built at compile
+// time like the CRC-16 in ble_frame.h
+struct Crc32Table {
+    uint32_t entries[256];
+};
+
+constexpr Crc32Table crc32BuildTable() {
+    Crc32Table table{};
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t crc = i;
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320u : crc >> 1;
+        }
+        table.entries[i] = crc;
+    }
+    return table;
+}
+
+constexpr Crc32Table CRC32_TABLE = crc32BuildTable();
+
+// Pass the previous result to continue a running CRC
+uint32_t crc32Update(const uint8_t* data, size_t length, uint32_t crc = 0) {
+    crc = ~crc;
+    for (size_t i = 0; i < length; i++) {
+        crc = (crc >> 8) ^ CRC32_TABLE.entries[(crc ^ data[i]) & 0xFF];
+    }
+    return ~crc;
+}
+
+inline uint32_t assetSlotAddress(uint8_t slot) {
+    return (uint32_t)slot * ASSET_SLOT_SIZE;
+}
+
+// Asset names are 1-15 characters of a-z, 0-9 and '_'
+bool assetNameValid(TextSpan name) {
+    if (name.length == 0 || name.length > ASSET_NAME_LENGTH) return false;
+    for (uint16_t i = 0; i < name.length; i++) {
+        char c = name.data[i];
+        if (!((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '_')) return false;
+    }
+    return true;
+}
+
+// Slot holding the named asset, or -1
+int assetFind(TextSpan name) {
+    for (uint8_t slot = 0; slot < assetSlotCount; slot++) {
+        if (assets[slot].valid && spanEquals(name, assets[slot].name)) return slot;
+    }
+    return -1;
+}
+
+uint8_t assetCount() {
+    uint8_t count = 0;
+    for (uint8_t slot = 0; slot < assetSlotCount; slot++) {
+        if (assets[slot].valid) count++;
+    }
+    return count;
+}
+
+// Slot of the n-th valid asset (n < assetCount()), or -1
+int assetNth(uint8_t n) {
+    for (uint8_t slot = 0; slot < assetSlotCount; slot++) {
+        if (assets[slot].valid && n-- == 0) return slot;
+    }
+    return -1;
+}
+
+// Read one frame into `frame` (ASSET_FRAME_BYTES)
+bool assetReadFrame(uint8_t slot, uint8_t index, uint8_t* frame) {
+    if (!assets[slot].valid || index >= assets[slot].frames) return false;
+    uint32_t address = assetSlotAddress(slot) + ASSET_HEADER_SIZE + (uint32_t)index * ASSET_FRAME_BYTES;
+    return esp_partition_read(assetPartition, address, frame, ASSET_FRAME_BYTES) == ESP_OK;
+}
+
+// Put a slot's header into the index if it describes a finished asset
+void assetLoadSlot(uint8_t slot) {
+    AssetHeader header;
+    assets[slot].valid = false;
+    if (esp_partition_read(assetPartition, assetSlotAddress(slot), &header, sizeof(header)) != ESP_OK) return;
+    if (header.magic != ASSET_MAGIC || header.committed != ASSET_COMMITTED) return;
+    if (header.size == 0 || header.size % ASSET_FRAME_BYTES != 0 ||
+        header.size / ASSET_FRAME_BYTES > ASSET_MAX_FRAMES) return;
+
+    header.name[ASSET_NAME_LENGTH] = '\0';
+    memcpy(assets[slot].name, header.name, sizeof(assets[slot].name));
+    assets[slot].frames = header.size / ASSET_FRAME_BYTES;
+    // Uploaded before the limit existed
+    assets[slot].frameDelay = min(header.frameDelay, (uint16_t)ASSET_MAX_FRAME_DELAY);
+    assets[slot].valid = true;
+}
+
+// Find the partition and index what is already in it
+void assetInit() {
+    assetPartition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_DATA_SPIFFS, NULL);
+    if (assetPartition == nullptr) {
+        Serial.println("Assets: no SPIFFS partition, uploads disabled");
+        return;
+    }
+    assetSlotCount = min((uint32_t)ASSET_MAX_SLOTS, (uint32_t)(assetPartition->size / ASSET_SLOT_SIZE));
+    for (uint8_t slot = 0; slot < assetSlotCount; slot++) {
+        assetLoadSlot(slot);
+    }
+    Serial.print("Assets: ");
+    Serial.print(assetCount());
+    Serial.print(" animations, ");
+    Serial.print(assetSlotCount);
+    Serial.println(" slots");
+}
+
+// Erase a slot's header so it no longer counts as an asset
+void assetErase(uint8_t slot) {
+    assets[slot].valid = false;
+    esp_partition_erase_range(assetPartition, assetSlotAddress(slot), ASSET_SECTOR_SIZE);
+}
+
+#endif // ASSET_STORE_H
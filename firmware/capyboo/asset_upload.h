@@ -0,0 +1,316 @@
+#ifndef ASSET_UPLOAD_H
+#define ASSET_UPLOAD_H
+
+#include "asset_store.h"
+#include "ble_frame.h"
+#include "bluetooth.h"
+#include "command_router.h"
+
+// Uploading animations from the phone (asset_store.h keeps them).
+//
+//   asset:upload:<name>:<size>:<crc32 hex>:<frame ms>
+//       Announce a file of <size> bytes, whole 1024-byte frames. The reply
+//       "asset:ready:<offset>:<window>" gives the byte offset to send from
+//       - 0, or how far an interrupted upload of the same file got - and
+//       how many chunks may be in flight without an ack.
+//
+// The file then goes to the bulk characteristic (fff3) as chunks written
+// without response, each as large as the MTU allows:
+//
+//   offset (u32 LE) | CRC-16/CCITT of the data (u16 LE) | data
+//
+// A chunk is taken only if it starts where the previous one ended and its
+// CRC matches, and goes straight to flash; nothing is buffered beyond the
+// chunk itself. "asset:ack:<offset>" on the normal reply channel says how
+// much is safely written, after every ASSET_ACK_EVERY chunks. A refused or
+// lost chunk gets "asset:resend:<offset>" straight away, once per gap, and
+// the client goes back to <offset>. When the last byte is in, the whole
+// file is read back and checked against the announced CRC-32, and the
+// reply is "asset:done:<name>" or "asset:failed:<reason>".
+//
+// A dropped connection leaves the upload where it was; announcing the same
+// name, size and CRC again resumes it. Uploading a name that exists
+// replaces that asset once the new file is done; until then, and if the
+// upload fails or is cancelled, the old one stays. Other commands:
+// asset:status, asset:cancel, asset:list and asset:delete:<name>.
+
+#define ASSET_WINDOW            8       // Chunks in flight; fits BLE_BULK_RING_SIZE
+#define ASSET_ACK_EVERY         4       // Ack this often so the window keeps moving
+#define ASSET_CHUNK_HEADER      6
+#define ASSET_CHUNKS_PER_PASS   8       // Bounds the flash work per loop() pass
+
+struct AssetUpload {
+    bool active;
+    uint8_t slot;
+    char name[ASSET_NAME_LENGTH + 1];
+    uint32_t size;
+    uint32_t crc;
+    uint16_t frameDelay;
+    uint32_t offset;            // Bytes of frame data written so far
+    uint32_t erasedTo;          // Bytes of the slot erased so far
+    int8_t connection;          // BLE client sending it, -1 if none
+    uint16_t session;
+    uint8_t sinceAck;           // Chunks taken since the last ack
+    bool refused;               // Asked for a resend; wait for it
+};
+
+AssetUpload assetUpload;
+uint8_t assetChunk[BLE_RX_MAX_WRITE];
+
+bool assetUploadClientPresent() {
+    return bleConnectionPresent(assetUpload.connection, assetUpload.session);
+}
+
+void assetUploadSend(const String& text) {
+    if (assetUploadClientPresent()) bleSerialPrintlnTo(assetUpload.connection, text);
+}
+
+void assetUploadAck() {
+    assetUploadSend("asset:ack:" + String(assetUpload.offset));
+    assetUpload.sinceAck = 0;
+}
+
+// Ask for everything from the write position again, once per gap
+void assetUploadResend() {
+    if (!assetUpload.refused) assetUploadSend("asset:resend:" + String(assetUpload.offset));
+    assetUpload.refused = true;
+    assetUpload.sinceAck = 0;
+}
+
+// Write at `address` within the upload's slot, erasing sectors ahead of it
+bool assetUploadWrite(uint32_t address, const void* data, uint32_t length) {
+    while (assetUpload.erasedTo < address + length) {
+        if (esp_partition_erase_range(assetPartition, assetSlotAddress(assetUpload.slot) + assetUpload.erasedTo,
+                                      ASSET_SECTOR_SIZE) != ESP_OK) {
+            return false;
+        }
+        assetUpload.erasedTo += ASSET_SECTOR_SIZE;
+    }
+    return esp_partition_write(assetPartition, assetSlotAddress(assetUpload.slot) + address, data, length) == ESP_OK;
+}
+
+void assetUploadFail(const char* reason) {
+    assetUploadSend(String("asset:failed:") + reason);
+    Serial.print("Asset upload failed: ");
+    Serial.println(reason);
+    assetErase(assetUpload.slot);
+    assetUpload.active = false;
+}
+
+// Last byte is in: check the whole file, then mark it complete
+void assetUploadFinish() {
+    uint32_t base = assetSlotAddress(assetUpload.slot) + ASSET_HEADER_SIZE;
+    uint32_t crc = 0;
+    for (uint32_t at = 0; at < assetUpload.size; at += sizeof(assetChunk)) {
+        uint32_t length = min((uint32_t)sizeof(assetChunk), assetUpload.size - at);
+        if (esp_partition_read(assetPartition, base + at, assetChunk, length) != ESP_OK) {
+            assetUploadFail("read");
+            return;
+        }
+        crc = crc32Update(assetChunk, length, crc);
+    }
+    if (crc != assetUpload.crc) {
+        assetUploadFail("crc");
+        return;
+    }
+
+    uint32_t committed = ASSET_COMMITTED;
+    if (!assetUploadWrite(offsetof(AssetHeader, committed), &committed, sizeof(committed))) {
+        assetUploadFail("write");
+        return;
+    }
+    // The new file is safe: drop the version it replaces
+    for (uint8_t slot = 0; slot < assetSlotCount; slot++) {
+        if (slot != assetUpload.slot && assets[slot].valid && strcmp(assets[slot].name, assetUpload.name) == 0) {
+            assetErase(slot);
+        }
+    }
+    assetLoadSlot(assetUpload.slot);
+    assetUpload.active = false;
+    assetUploadSend(String("asset:done:") + assetUpload.name);
+    Serial.print("Asset uploaded: ");
+    Serial.println(assetUpload.name);
+}
+
+// Take one chunk from the bulk channel
+void assetUploadChunk(int8_t connection, uint16_t length) {
+    if (!assetUpload.active || connection != assetUpload.connection || !assetUploadClientPresent()) return;
+
+    bool ok = length > ASSET_CHUNK_HEADER;
+    uint32_t offset = 0;
+    uint16_t dataLength = 0;
+    if (ok) {
+        offset = assetChunk[0] | (uint32_t)assetChunk[1] << 8 | (uint32_t)assetChunk[2] << 16 |
+                 (uint32_t)assetChunk[3] << 24;
+        uint16_t crc = assetChunk[4] | (uint16_t)assetChunk[5] << 8;
+        dataLength = length - ASSET_CHUNK_HEADER;
+        ok = offset == assetUpload.offset && offset + dataLength <= assetUpload.size &&
+             crc16Ccitt(assetChunk + ASSET_CHUNK_HEADER, dataLength) == crc;
+    }
+    if (!ok) {
+        assetUploadResend();
+        return;
+    }
+
+    if (!assetUploadWrite(ASSET_HEADER_SIZE + offset, assetChunk + ASSET_CHUNK_HEADER, dataLength)) {
+        assetUploadFail("write");
+        return;
+    }
+    assetUpload.offset += dataLength;
+    assetUpload.refused = false;
+    assetUpload.sinceAck++;
+    if (assetUpload.offset == assetUpload.size) {
+        assetUploadAck();
+        assetUploadFinish();
+    } else if (assetUpload.sinceAck >= ASSET_ACK_EVERY) {
+        assetUploadAck();
+    }
+}
+
+// Drain the bulk channel (call this in loop)
+void assetUploadPump() {
+    for (uint8_t i = 0; i < ASSET_CHUNKS_PER_PASS; i++) {
+        int8_t connection;
+        uint16_t length = bleBulkRead(connection, assetChunk, sizeof(assetChunk));
+        if (length == 0) break;
+        assetUploadChunk(connection, length);
+    }
+    // Writes lost to a full ring leave a gap; say where to resume from
+    if (bleBulkDropped.exchange(0, std::memory_order_relaxed) > 0 && assetUpload.active) {
+        assetUploadResend();
+    }
+}
+
+// asset:upload:<name>:<size>:<crc32 hex>:<frame ms>
+bool assetUploadBegin(TextSpan args) {
+    TextSpan name;
+    TextSpan crcText;
+    long size = 0;
+    long frameDelay = 0;
+    uint32_t crc = 0;
+    spanSplit(args, ':', name);
+    name = spanTrim(name);
+    bool valid = spanNextLong(args, ':', size) && spanSplit(args, ':', crcText) &&
+                 spanToHex(spanTrim(crcText), crc) && spanNextLong(args, ':', frameDelay) &&
+                 spanExhausted(args);
+    if (!valid || !assetNameValid(name) || size <= 0 || size % ASSET_FRAME_BYTES != 0 ||
+        size / ASSET_FRAME_BYTES > ASSET_MAX_FRAMES || frameDelay < 0 || frameDelay > ASSET_MAX_FRAME_DELAY) {
+        commandReply("Invalid upload. Use: asset:upload:<name>:<bytes, whole 1024-byte frames, up to " +
+                     String(ASSET_MAX_FRAMES) + ">:<crc32 hex>:<frame ms, up to " +
+                     String(ASSET_MAX_FRAME_DELAY) + ">");
+        return false;
+    }
+    if (!commandSourceIsBle(commandSource)) {
+        commandReply("Uploads need the BLE bulk channel");
+        return false;
+    }
+    if (assetPartition == nullptr) {
+        commandReply("No asset partition");
+        return false;
+    }
+
+    uint8_t connection = commandSource - COMMAND_SOURCE_BLE;
+    bool resume = assetUpload.active && spanEquals(name, assetUpload.name) &&
+                  (uint32_t)size == assetUpload.size && crc == assetUpload.crc;
+    if (!resume) {
+        // Take a free slot. An asset of the same name stays playable
+        // until the new one is complete (assetUploadFinish() drops it);
+        // only with no free slot is it overwritten in place. A different
+        // upload that was interrupted gives up its slot.
+        if (assetUpload.active) assetErase(assetUpload.slot);
+        assetUpload.active = false;
+        int slot = -1;
+        for (uint8_t i = 0; slot < 0 && i < assetSlotCount; i++) {
+            if (!assets[i].valid) slot = i;
+        }
+        if (slot < 0) slot = assetFind(name);
+        if (slot < 0) {
+            commandReply("No free asset slot, delete one first");
+            return false;
+        }
+
+        assetUpload.slot = slot;
+        assets[slot].valid = false;
+        spanCopy(name, assetUpload.name, sizeof(assetUpload.name));
+        assetUpload.size = size;
+        assetUpload.crc = crc;
+        assetUpload.frameDelay = frameDelay;
+        assetUpload.offset = 0;
+        assetUpload.erasedTo = 0;
+
+        AssetHeader header = {};
+        header.magic = ASSET_MAGIC;
+        memcpy(header.name, assetUpload.name, sizeof(header.name));
+        header.size = size;
+        header.crc = crc;
+        header.frameDelay = frameDelay;
+        header.committed = 0xFFFFFFFF;      // Left erased until the file checks out
+        if (!assetUploadWrite(0, &header, sizeof(header))) {
+            assetErase(slot);
+            commandReply("Flash write failed");
+            return false;
+        }
+        assetUpload.active = true;
+    }
+
+    assetUpload.connection = connection;
+    assetUpload.session = bleConnectionSession(connection);
+    assetUpload.sinceAck = 0;
+    assetUpload.refused = false;
+    commandReply("asset:ready:" + String(assetUpload.offset) + ":" + String(ASSET_WINDOW));
+    return true;
+}
+
+bool assetCommand(TextSpan args) {
+    TextSpan action;
+    spanSplit(args, ':', action);
+    action = spanTrim(action);
+
+    if (spanEquals(action, "upload")) {
+        return assetUploadBegin(args);
+    }
+    if (spanEquals(action, "status")) {
+        if (!assetUpload.active) {
+            commandReply("No upload in progress");
+        } else {
+            commandReply(String("Uploading ") + assetUpload.name + ": " + assetUpload.offset + "/" +
+                         assetUpload.size + " bytes" + (assetUploadClientPresent() ? "" : " (paused)"));
+        }
+        return true;
+    }
+    if (spanEquals(action, "cancel")) {
+        if (!assetUpload.active) {
+            commandReply("No upload in progress");
+            return false;
+        }
+        assetErase(assetUpload.slot);
+        assetUpload.active = false;
+        commandReply("Upload cancelled");
+        return true;
+    }
+    if (spanEquals(action, "list")) {
+        String list;
+        for (uint8_t slot = 0; slot < assetSlotCount; slot++) {
+            if (!assets[slot].valid) continue;
+            if (list.length() > 0) list += ", ";
+            list += String(assets[slot].name) + " (" + assets[slot].frames + " frames)";
+        }
+        commandReply("Assets: " + (list.length() > 0 ? list : String("none")) + "; " +
+                     (assetSlotCount - assetCount()) + " slots free");
+        return true;
+    }
+    if (spanEquals(action, "delete")) {
+        int slot = assetFind(spanTrim(args));
+        if (slot < 0) {
+            commandReply("No such asset: " + spanString(spanTrim(args)));
+            return false;
+        }
+        assetErase(slot);
+        commandReply("Asset deleted: " + spanString(spanTrim(args)));
+        return true;
+    }
+    commandReply("Unknown asset command. Use: asset:upload, asset:status, asset:cancel, asset:list or asset:delete");
+    return false;
+}
+
+#endif // ASSET_UPLOAD_H
@@ -0,0 +1,139 @@
+#ifndef BLE_FRAME_H
+#define BLE_FRAME_H
+
+#include <Arduino.h>
+
+// Length-prefixed binary framing for BLE commands.
+//
+//   0x02 | length (u16 LE) | payload (length bytes, UTF-8) | CRC16 (u16 LE)
+//
+// The CRC is CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF) over the two
+// length bytes and the payload. The receiver knows a command is complete
+// the moment its last byte arrives, so it is dispatched straight away
+// instead of after a quiet period, and corrupted or truncated commands are
+// rejected instead of executed. A frame may span several BLE writes and a
+// write may hold several frames.
+//
+// Plain text commands never start with 0x02, so anything else still goes
+// down the old newline/timeout path in bluetooth.h.
+
+#define BLE_FRAME_START     0x02
+#define BLE_FRAME_OVERHEAD  5       // Start byte, length, CRC
+#define BLE_FRAME_TIMEOUT   500     // ms a half-received frame may stall
+#define BLE_FRAME_MAX_PAYLOAD 256   // Same as BLE_MAX_COMMAND_LENGTH
+
+// CRC-16/CCITT lookup table, built at compile time
+struct Crc16Table {
+    uint16_t entries[256];
+};
+
+constexpr Crc16Table crc16BuildTable() {
+    Crc16Table table{};
+    for (uint16_t i = 0; i < 256; i++) {
+        uint16_t crc = i << 8;
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+        table.entries[i] = crc;
+    }
+    return table;
+}
+
+constexpr Crc16Table CRC16_TABLE = crc16BuildTable();
+
+inline uint16_t crc16Update(uint16_t crc, uint8_t byte) {
+    return (crc << 8) ^ CRC16_TABLE.entries[(crc >> 8) ^ byte];
+}
+
+uint16_t crc16Ccitt(const uint8_t* data, size_t length, uint16_t crc = 0xFFFF) {
+    for (size_t i = 0; i < length; i++) {
+        crc = crc16Update(crc, data[i]);
+    }
+    return crc;
+}
+
+enum BleFrameState {
+    BLE_FRAME_IDLE,         // Waiting for the start byte
+    BLE_FRAME_LENGTH_LO,
+    BLE_FRAME_LENGTH_HI,
+    BLE_FRAME_PAYLOAD,
+    BLE_FRAME_CRC_LO,
+    BLE_FRAME_CRC_HI
+};
+
+enum BleFrameResult {
+    BLE_FRAME_MORE,         // Keep feeding
+    BLE_FRAME_DONE,         // payload[0..length) is a complete command
+    BLE_FRAME_BAD_CRC,
+    BLE_FRAME_TOO_LONG
+};
+
+struct BleFrameDecoder {
+    uint8_t state;
+    uint16_t length;
+    uint16_t received;
+    uint16_t crc;           // Running CRC of what has arrived
+    uint16_t frameCrc;      // CRC sent with the frame
+    unsigned long lastByte; // millis() of the last byte, for the stall timeout
+    char payload[BLE_FRAME_MAX_PAYLOAD + 1];
+};
+
+inline void bleFrameReset(BleFrameDecoder& d) {
+    d.state = BLE_FRAME_IDLE;
+}
+
+inline bool bleFrameInProgress(const BleFrameDecoder& d) {
+    return d.state != BLE_FRAME_IDLE;
+}
+
+// Feed one byte. On BLE_FRAME_DONE the payload is NUL-terminated and the
+// decoder is ready for the next frame; errors also reset it.
+uint8_t bleFrameFeed(BleFrameDecoder& d, uint8_t byte) {
+    switch (d.state) {
+        case BLE_FRAME_IDLE:
+            if (byte == BLE_FRAME_START) {
+                d.state = BLE_FRAME_LENGTH_LO;
+                d.crc = 0xFFFF;
+            }
+            return BLE_FRAME_MORE;
+
+        case BLE_FRAME_LENGTH_LO:
+            d.length = byte;
+            d.crc = crc16Update(d.crc, byte);
+            d.state = BLE_FRAME_LENGTH_HI;
+            return BLE_FRAME_MORE;
+
+        case BLE_FRAME_LENGTH_HI:
+            d.length |= (uint16_t)byte << 8;
+            d.crc = crc16Update(d.crc, byte);
+            if (d.length > BLE_FRAME_MAX_PAYLOAD) {
+                d.state = BLE_FRAME_IDLE;
+                return BLE_FRAME_TOO_LONG;
+            }
+            d.received = 0;
+            d.state = d.length > 0 ? BLE_FRAME_PAYLOAD : BLE_FRAME_CRC_LO;
+            return BLE_FRAME_MORE;
+
+        case BLE_FRAME_PAYLOAD:
+            d.payload[d.received++] = (char)byte;
+            d.crc = crc16Update(d.crc, byte);
+            if (d.received == d.length) d.state = BLE_FRAME_CRC_LO;
+            return BLE_FRAME_MORE;
+
+        case BLE_FRAME_CRC_LO:
+            d.frameCrc = byte;
+            d.state = BLE_FRAME_CRC_HI;
+            return BLE_FRAME_MORE;
+
+        case BLE_FRAME_CRC_HI:
+            d.frameCrc |= (uint16_t)byte << 8;
+            d.state = BLE_FRAME_IDLE;
+            if (d.frameCrc != d.crc) return BLE_FRAME_BAD_CRC;
+            d.payload[d.length] = '\0';
+            return BLE_FRAME_DONE;
+    }
+    d.state = BLE_FRAME_IDLE;
+    return BLE_FRAME_MORE;
+}
+
+#endif // BLE_FRAME_H
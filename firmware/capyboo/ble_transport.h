@@ -0,0 +1,161 @@
+#ifndef BLE_TRANSPORT_H
+#define BLE_TRANSPORT_H
+
+#include <Arduino.h>
+#include "spsc_ring.h"
+
+// The link underneath the BLE serial port.
+//
+// bluetooth.h owns everything above the radio - reassembly, framing, the
+// command queue, coalesced output - and reaches the link only through a
+// BleTransport. Several clients can be connected at once; each gets one
+// of BLE_MAX_CONNECTIONS link slots. A backend names clients by its own
+// connection ID and reports them from whatever task it runs on:
+// bleTransportOpen() when one connects, bleTransportReceive() for each
+// write, bleTransportClose() when it goes away. loop() notices the change
+// in the slot's state, sets up or tears down its buffers and only then
+// frees the slot for the next client.
+//
+// Bulk data (asset uploads, asset_upload.h) and streamed frames
+// (frame_stream.h) arrive on channels of their own, handed over with
+// bleTransportBulk() and bleTransportStream(). Only the GATT backend has
+// them.
+//
+// Three backends exist:
+//   ble_transport_esp32.h  the GATT server the app talks to (default)
+//   ble_transport_tcp.h    a TCP socket over WiFi carrying the same byte
+//                          stream, for scripted traffic against a device;
+//                          selected by building with -DBLE_TRANSPORT_TCP
+//   ble_transport_posix.h  the same on a POSIX host, for the simulator in
+//                          firmware/test/sim; -DBLE_TRANSPORT_POSIX
+
+struct BleTransport {
+    const char* name;
+    void (*begin)(const char* deviceName);
+    void (*poll)();                     // Called from loop() every pass
+    void (*advertise)();                // Let another client find us
+    uint16_t (*packetSize)(uint16_t connId);   // Payload bytes per send() right now
+    // Send one packet to one client; false if the link is congested and
+    // the same bytes should be offered again later
+    bool (*send)(uint16_t connId, const uint8_t* data, uint16_t length);
+};
+
+// Each slot costs about 9 KB: this receive ring plus the command queue,
+// text buffer and transmit ring in bluetooth.h. Bluedroid itself is
+// built for at most CONFIG_BT_ACL_CONNECTIONS links (4 by default).
+#ifndef BLE_MAX_CONNECTIONS
+#define BLE_MAX_CONNECTIONS 3
+#endif
+static_assert(BLE_MAX_CONNECTIONS >= 1 && BLE_MAX_CONNECTIONS <= 9, "Bluedroid supports 1 to 9 connections");
+
+// Receive ring per slot
+// Each write is stored as a record: length (u16 LE), millis() of arrival
+// (u32 LE), then the bytes. The backend is the only producer; bleRxPump()
+// in loop() is the only consumer.
+#define BLE_RX_RING_SIZE    4096    // Power of two; ~8 full-MTU writes
+#define BLE_RX_HEADER       6
+#define BLE_RX_MAX_WRITE    512     // Largest write the negotiated MTU allows
+
+enum BleLinkState {
+    BLE_LINK_FREE,
+    BLE_LINK_OPEN,
+    BLE_LINK_CLOSED                 // Gone; loop() has not cleaned up yet
+};
+
+struct BleLink {
+    std::atomic<uint8_t> state{BLE_LINK_FREE};
+    uint16_t connId;
+    SpscByteRing<BLE_RX_RING_SIZE> rx;
+    std::atomic<uint32_t> rxDropped{0};  // Writes refused because the ring was full
+};
+
+BleLink bleLinks[BLE_MAX_CONNECTIONS];
+
+// Data channels, each shared by all clients
+// Records are length (u16 LE), connection ID (u16 LE), then the bytes.
+#define BLE_CHANNEL_HEADER      4
+#define BLE_BULK_RING_SIZE      8192    // Power of two; a window of MTU-sized upload chunks
+#define BLE_STREAM_RING_SIZE    8192    // Power of two; a few worst-case frames
+
+SpscByteRing<BLE_BULK_RING_SIZE> bleBulkRing;
+std::atomic<uint32_t> bleBulkDropped{0};
+SpscByteRing<BLE_STREAM_RING_SIZE> bleStreamRing;
+std::atomic<uint32_t> bleStreamDropped{0};
+
+// Slot of an open connection, or -1
+int8_t bleLinkFind(uint16_t connId) {
+    for (uint8_t i = 0; i < BLE_MAX_CONNECTIONS; i++) {
+        if (bleLinks[i].state.load(std::memory_order_acquire) == BLE_LINK_OPEN &&
+            bleLinks[i].connId == connId) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// A client connected. Returns its slot, or -1 if all are taken and the
+// backend should turn it away.
+int8_t bleTransportOpen(uint16_t connId) {
+    for (uint8_t i = 0; i < BLE_MAX_CONNECTIONS; i++) {
+        if (bleLinks[i].state.load(std::memory_order_acquire) == BLE_LINK_FREE) {
+            bleLinks[i].connId = connId;
+            bleLinks[i].state.store(BLE_LINK_OPEN, std::memory_order_release);
+            return i;
+        }
+    }
+    return -1;
+}
+
+void bleTransportClose(uint16_t connId) {
+    int8_t slot = bleLinkFind(connId);
+    if (slot >= 0) bleLinks[slot].state.store(BLE_LINK_CLOSED, std::memory_order_release);
+}
+
+// Queue one received write. Does not block, so backends may call it from
+// a radio callback.
+void bleTransportReceive(uint16_t connId, const uint8_t* data, size_t length) {
+    int8_t slot = bleLinkFind(connId);
+    if (slot < 0 || length == 0) return;
+    BleLink& link = bleLinks[slot];
+    if (length > BLE_RX_MAX_WRITE || spscFree(link.rx) < BLE_RX_HEADER + length) {
+        link.rxDropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    uint32_t now = millis();
+    uint8_t header[BLE_RX_HEADER] = {
+        (uint8_t)length, (uint8_t)(length >> 8),
+        (uint8_t)now, (uint8_t)(now >> 8), (uint8_t)(now >> 16), (uint8_t)(now >> 24)
+    };
+    spscStage(link.rx, 0, header, BLE_RX_HEADER);
+    spscStage(link.rx, BLE_RX_HEADER, data, length);
+    spscPublish(link.rx, BLE_RX_HEADER + length);
+}
+
+// Queue one write to a data channel; same rules as bleTransportReceive()
+template <uint16_t N>
+void bleChannelPush(SpscByteRing<N>& ring, std::atomic<uint32_t>& dropped, uint16_t connId,
+                    const uint8_t* data, size_t length) {
+    if (length == 0) return;
+    if (length > BLE_RX_MAX_WRITE || spscFree(ring) < BLE_CHANNEL_HEADER + length) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    uint8_t header[BLE_CHANNEL_HEADER] = {
+        (uint8_t)length, (uint8_t)(length >> 8), (uint8_t)connId, (uint8_t)(connId >> 8)
+    };
+    spscStage(ring, 0, header, BLE_CHANNEL_HEADER);
+    spscStage(ring, BLE_CHANNEL_HEADER, data, length);
+    spscPublish(ring, BLE_CHANNEL_HEADER + length);
+}
+
+void bleTransportBulk(uint16_t connId, const uint8_t* data, size_t length) {
+    bleChannelPush(bleBulkRing, bleBulkDropped, connId, data, length);
+}
+
+void bleTransportStream(uint16_t connId, const uint8_t* data, size_t length) {
+    bleChannelPush(bleStreamRing, bleStreamDropped, connId, data, length);
+}
+
+#endif // BLE_TRANSPORT_H
@@ -0,0 +1,185 @@
+#ifndef BLE_TRANSPORT_ESP32_H
+#define BLE_TRANSPORT_ESP32_H
+
+#include <BLEDevice.h>
+#include <BLEServer.h>
+#include <BLEUtils.h>
+#include <BLE2902.h>
+#include "ble_transport.h"
+
+// BLE Serial Port Profile UUIDs
+#define BLE_SERVICE_UUID        "0000fff0-0000-1000-8000-00805f9b34fb"  // Serial Port Service
+#define BLE_CHAR_UUID_TX        "0000fff1-0000-1000-8000-00805f9b34fb"  // TX Characteristic
+#define BLE_CHAR_UUID_RX        "0000fff2-0000-1000-8000-00805f9b34fb"  // RX Characteristic
+#define BLE_CHAR_UUID_BULK      "0000fff3-0000-1000-8000-00805f9b34fb"  // Bulk upload Characteristic
+#define BLE_CHAR_UUID_STREAM    "0000fff4-0000-1000-8000-00805f9b34fb"  // Frame stream Characteristic
+
+#define BLE_ATT_OVERHEAD    3       // Bytes of each ATT packet that are not payload
+
+// BLE objects
+BLEServer* pBLEServer = NULL;
+BLECharacteristic* pBLETxCharacteristic = NULL;
+BLECharacteristic* pBLERxCharacteristic = NULL;
+BLECharacteristic* pBLEBulkCharacteristic = NULL;
+BLECharacteristic* pBLEStreamCharacteristic = NULL;
+BLE2902* pBLETxCccd = NULL;
+
+// Whether the client in each link slot has turned TX notifications on.
+// The 2902 descriptor keeps one value for all clients, so the writes to
+// it are picked up per connection in bleEsp32GattsEvent() instead.
+std::atomic<bool> bleEsp32Subscribed[BLE_MAX_CONNECTIONS];
+
+// BLE Server Callbacks
+class MyBLEServerCallbacks: public BLEServerCallbacks {
+    void onConnect(BLEServer* pServer, esp_ble_gatts_cb_param_t* param) {
+      Serial.println("BLE Device connected");
+      if (bleTransportOpen(param->connect.conn_id) < 0) {
+        Serial.println("BLE: no free connection slot, disconnecting");
+        pServer->disconnect(param->connect.conn_id);
+      }
+    }
+
+    void onDisconnect(BLEServer* pServer, esp_ble_gatts_cb_param_t* param) {
+      Serial.println("BLE Device disconnected");
+      // The next client in this slot starts unsubscribed
+      int8_t slot = bleLinkFind(param->disconnect.conn_id);
+      if (slot >= 0) bleEsp32Subscribed[slot].store(false, std::memory_order_relaxed);
+      bleTransportClose(param->disconnect.conn_id);
+    }
+};
+
+// BLE Characteristic Callbacks for RX (receiving data)
+// Runs on the BLE task: copy the write into the sender's ring and return
+class BLERxCallbacks: public BLECharacteristicCallbacks {
+    void onWrite(BLECharacteristic *pCharacteristic, esp_ble_gatts_cb_param_t* param) {
+      bleTransportReceive(param->write.conn_id, pCharacteristic->getData(), pCharacteristic->getLength());
+    }
+};
+
+// Bulk writes take the same route on a ring of their own
+class BLEBulkCallbacks: public BLECharacteristicCallbacks {
+    void onWrite(BLECharacteristic *pCharacteristic, esp_ble_gatts_cb_param_t* param) {
+      bleTransportBulk(param->write.conn_id, pCharacteristic->getData(), pCharacteristic->getLength());
+    }
+};
+
+class BLEStreamCallbacks: public BLECharacteristicCallbacks {
+    void onWrite(BLECharacteristic *pCharacteristic, esp_ble_gatts_cb_param_t* param) {
+      bleTransportStream(param->write.conn_id, pCharacteristic->getData(), pCharacteristic->getLength());
+    }
+};
+
+// Runs on the BLE task for every GATT server event; picks out writes to
+// the TX characteristic's 2902 descriptor
+void bleEsp32GattsEvent(esp_gatts_cb_event_t event, esp_gatt_if_t gattsIf, esp_ble_gatts_cb_param_t* param) {
+  if (event != ESP_GATTS_WRITE_EVT || pBLETxCccd == NULL || param->write.handle != pBLETxCccd->getHandle()) return;
+  int8_t slot = bleLinkFind(param->write.conn_id);
+  if (slot < 0 || param->write.len < 1) return;
+  bleEsp32Subscribed[slot].store((param->write.value[0] & 0x01) != 0, std::memory_order_relaxed);
+}
+
+void bleEsp32Begin(const char* deviceName) {
+  // Initialize BLE device
+  BLEDevice::init(deviceName);
+
+  // Set MTU size to allow larger packets (up to 512 bytes)
+  // This enables BLE 4.2+ extended MTU feature
+  BLEDevice::setMTU(512);
+
+  // Create BLE server
+  pBLEServer = BLEDevice::createServer();
+  pBLEServer->setCallbacks(new MyBLEServerCallbacks());
+  BLEDevice::setCustomGattsHandler(bleEsp32GattsEvent);
+
+  // Create BLE Serial Port Service
+  BLEService *pService = pBLEServer->createService(BLE_SERVICE_UUID);
+
+  // Create TX Characteristic (for sending data to phone)
+  pBLETxCharacteristic = pService->createCharacteristic(
+                      BLE_CHAR_UUID_TX,
+                      BLECharacteristic::PROPERTY_READ   |
+                      BLECharacteristic::PROPERTY_NOTIFY |
+                      BLECharacteristic::PROPERTY_INDICATE
+                    );
+  pBLETxCccd = new BLE2902();
+  pBLETxCharacteristic->addDescriptor(pBLETxCccd);
+
+  // Create RX Characteristic (for receiving data from phone)
+  // Set value size to allow longer commands
+  pBLERxCharacteristic = pService->createCharacteristic(
+                      BLE_CHAR_UUID_RX,
+                      BLECharacteristic::PROPERTY_WRITE |
+                      BLECharacteristic::PROPERTY_WRITE_NR
+                    );
+  // Set the maximum value length (512 bytes)
+  pBLERxCharacteristic->setValue((uint8_t*)NULL, 0);
+  pBLERxCharacteristic->setCallbacks(new BLERxCallbacks());
+
+  // Create Bulk Characteristic (upload chunks, written without response)
+  pBLEBulkCharacteristic = pService->createCharacteristic(
+                      BLE_CHAR_UUID_BULK,
+                      BLECharacteristic::PROPERTY_WRITE_NR
+                    );
+  pBLEBulkCharacteristic->setCallbacks(new BLEBulkCallbacks());
+
+  // Create Stream Characteristic (live frames, written without response)
+  pBLEStreamCharacteristic = pService->createCharacteristic(
+                      BLE_CHAR_UUID_STREAM,
+                      BLECharacteristic::PROPERTY_WRITE_NR
+                    );
+  pBLEStreamCharacteristic->setCallbacks(new BLEStreamCallbacks());
+
+  // Start the service
+  pService->start();
+
+  // Start advertising
+  BLEAdvertising *pAdvertising = BLEDevice::getAdvertising();
+  pAdvertising->addServiceUUID(BLE_SERVICE_UUID);
+  pAdvertising->setScanResponse(true);
+  pAdvertising->setMinPreferred(0x06);  // Helps with iPhone connections
+  pAdvertising->setMinPreferred(0x12);
+  BLEDevice::startAdvertising();
+}
+
+// Callbacks do all the work
+void bleEsp32Poll() {
+}
+
+// The stack stops advertising when a client connects; starting it again
+// while connected lets the next one in
+void bleEsp32Advertise() {
+  BLEDevice::startAdvertising();
+}
+
+// Payload bytes per notification for one connection
+uint16_t bleEsp32PacketSize(uint16_t connId) {
+  uint16_t mtu = pBLEServer->getPeerMTU(connId);
+  if (mtu < 23) mtu = 23;  // Not negotiated yet: BLE 4.0 default
+  return min((uint16_t)(mtu - BLE_ATT_OVERHEAD), (uint16_t)BLE_RX_MAX_WRITE);
+}
+
+// Notify one client. BLECharacteristic::notify() would send to every
+// connected peer, so this goes to the stack directly; it refuses the
+// packet when its queue is full, which is the congestion signal. The
+// stack does not check the client's CCCD, so a client that has not
+// subscribed is skipped here and its output dropped as if sent.
+bool bleEsp32Send(uint16_t connId, const uint8_t* data, uint16_t length) {
+  if (pBLETxCharacteristic == NULL) return false;
+  int8_t slot = bleLinkFind(connId);
+  if (slot < 0 || !bleEsp32Subscribed[slot].load(std::memory_order_relaxed)) return true;
+  esp_err_t result = esp_ble_gatts_send_indicate(pBLEServer->getGattsIf(), connId,
+                                                 pBLETxCharacteristic->getHandle(),
+                                                 length, (uint8_t*)data, false);
+  return result == ESP_OK;
+}
+
+const BleTransport bleEsp32Transport = {
+  "BLE",
+  bleEsp32Begin,
+  bleEsp32Poll,
+  bleEsp32Advertise,
+  bleEsp32PacketSize,
+  bleEsp32Send
+};
+
+#endif // BLE_TRANSPORT_ESP32_H
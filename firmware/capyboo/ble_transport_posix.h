@@ -0,0 +1,153 @@
+#ifndef BLE_TRANSPORT_POSIX_H
+#define BLE_TRANSPORT_POSIX_H
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "ble_transport.h"
+
+// The BLE serial port over a TCP socket on a POSIX host, for the simulator
+// (firmware/test/sim). Clients see the same byte stream as over
+// ble_transport_tcp.h on the device, in the same write-sized chunks, so a
+// scripted session runs unchanged against either. Only the listener
+// differs: it is up from begin() on, bound to the loopback interface, and
+// every socket is non-blocking.
+
+#ifndef BLE_POSIX_PORT
+#define BLE_POSIX_PORT      7070
+#endif
+#define BLE_POSIX_PACKET    (BLE_RX_MAX_WRITE - 3)
+
+// Set before begin(); 0 picks a free port, which is written back here
+uint16_t blePosixPort = BLE_POSIX_PORT;
+
+// A client's connection ID is its index here; -1 when free
+int blePosixListener = -1;
+int blePosixSockets[BLE_MAX_CONNECTIONS];
+uint8_t blePosixReadBuffer[BLE_POSIX_PACKET];
+
+// The tail of a packet the socket didn't take yet, per client
+uint8_t blePosixPending[BLE_MAX_CONNECTIONS][BLE_POSIX_PACKET];
+uint16_t blePosixPendingLength[BLE_MAX_CONNECTIONS];
+
+void blePosixBegin(const char* deviceName) {
+    for (uint8_t i = 0; i < BLE_MAX_CONNECTIONS; i++) blePosixSockets[i] = -1;
+    blePosixListener = socket(AF_INET, SOCK_STREAM, 0);
+    int reuse = 1;
+    setsockopt(blePosixListener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(blePosixPort);
+    socklen_t length = sizeof(address);
+    if (blePosixListener < 0 || bind(blePosixListener, (sockaddr*)&address, length) < 0 ||
+        listen(blePosixListener, BLE_MAX_CONNECTIONS) < 0 ||
+        getsockname(blePosixListener, (sockaddr*)&address, &length) < 0) {
+        Serial.print("BLE serial over TCP: cannot listen: ");
+        Serial.println(strerror(errno));
+        if (blePosixListener >= 0) close(blePosixListener);
+        blePosixListener = -1;
+        return;
+    }
+    fcntl(blePosixListener, F_SETFL, fcntl(blePosixListener, F_GETFL) | O_NONBLOCK);
+    blePosixPort = ntohs(address.sin_port);
+    Serial.print("BLE serial over TCP, port ");
+    Serial.println(blePosixPort);
+}
+
+void blePosixDisconnect(uint8_t id) {
+    close(blePosixSockets[id]);
+    blePosixSockets[id] = -1;
+    bleTransportClose(id);
+    Serial.println("BLE Device disconnected");
+}
+
+// Write out what is left of the last packet; true once nothing is
+bool blePosixFlushPending(uint8_t id) {
+    uint16_t& pending = blePosixPendingLength[id];
+    if (pending == 0) return true;
+    ssize_t written = send(blePosixSockets[id], blePosixPending[id], pending, MSG_DONTWAIT | MSG_NOSIGNAL);
+    if (written <= 0) return false;
+    memmove(blePosixPending[id], blePosixPending[id] + written, pending - written);
+    pending -= written;
+    return pending == 0;
+}
+
+void blePosixPoll() {
+    if (blePosixListener < 0) return;
+
+    int client = accept(blePosixListener, nullptr, nullptr);
+    if (client >= 0) {
+        int8_t id = -1;
+        for (uint8_t i = 0; i < BLE_MAX_CONNECTIONS && id < 0; i++) {
+            if (blePosixSockets[i] < 0) id = i;
+        }
+        if (id < 0 || bleTransportOpen(id) < 0) {
+            Serial.println("BLE: no free connection slot, disconnecting");
+            close(client);
+        } else {
+            int on = 1;
+            setsockopt(client, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+            fcntl(client, F_SETFL, fcntl(client, F_GETFL) | O_NONBLOCK);
+            blePosixSockets[id] = client;
+            blePosixPendingLength[id] = 0;
+            Serial.println("BLE Device connected");
+        }
+    }
+
+    // Hand over what has arrived, one write-sized chunk at a time, while
+    // the client's receive ring has room for it
+    for (uint8_t i = 0; i < BLE_MAX_CONNECTIONS; i++) {
+        if (blePosixSockets[i] < 0) continue;
+        blePosixFlushPending(i);
+        int8_t slot = bleLinkFind(i);
+        if (slot < 0) continue;
+        while (spscFree(bleLinks[slot].rx) >= BLE_RX_HEADER + BLE_POSIX_PACKET) {
+            ssize_t length = recv(blePosixSockets[i], blePosixReadBuffer, BLE_POSIX_PACKET, MSG_DONTWAIT);
+            if (length > 0) {
+                bleTransportReceive(i, blePosixReadBuffer, length);
+                continue;
+            }
+            if (length == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+                blePosixDisconnect(i);
+            }
+            break;
+        }
+    }
+}
+
+// Always listening
+void blePosixAdvertise() {
+}
+
+uint16_t blePosixPacketSize(uint16_t connId) {
+    return BLE_POSIX_PACKET;
+}
+
+// Never blocks; a full socket buffer is congestion, as in ble_transport_tcp.h
+bool blePosixSend(uint16_t connId, const uint8_t* data, uint16_t length) {
+    if (blePosixSockets[connId] < 0) return true;   // Gone; loop() cleans up
+    if (!blePosixFlushPending(connId)) return false;
+    ssize_t written = send(blePosixSockets[connId], data, length, MSG_DONTWAIT | MSG_NOSIGNAL);
+    if (written <= 0) return false;
+    if (written < length) {
+        memcpy(blePosixPending[connId], data + written, length - written);
+        blePosixPendingLength[connId] = length - written;
+    }
+    return true;
+}
+
+const BleTransport blePosixTransport = {
+    "TCP (POSIX)",
+    blePosixBegin,
+    blePosixPoll,
+    blePosixAdvertise,
+    blePosixPacketSize,
+    blePosixSend
+};
+
+#endif // BLE_TRANSPORT_POSIX_H
@@ -0,0 +1,145 @@
+#ifndef BLE_TRANSPORT_TCP_H
+#define BLE_TRANSPORT_TCP_H
+
+#include <WiFi.h>
+#include "ble_transport.h"
+
+// The BLE serial port over a TCP socket.
+//
+// Up to BLE_MAX_CONNECTIONS clients each get exactly what a phone would see: it writes
+// commands (text or framed, ble_frame.h) and reads replies, acks and
+// notifications from the same connection. Bytes are read in chunks of at
+// most BLE_TCP_PACKET, the size of a full-MTU BLE write, so the receive
+// path runs the same code it does over the radio. The listener starts
+// once the network is up, which on the device means WiFi has connected.
+
+#ifndef BLE_TCP_PORT
+#define BLE_TCP_PORT        7070
+#endif
+#define BLE_TCP_PACKET      (BLE_RX_MAX_WRITE - 3)
+
+// A client's connection ID is its index here
+WiFiServer bleTcpServer(BLE_TCP_PORT);
+WiFiClient bleTcpClients[BLE_MAX_CONNECTIONS];
+bool bleTcpOpen[BLE_MAX_CONNECTIONS];
+bool bleTcpListening = false;
+uint8_t bleTcpReadBuffer[BLE_TCP_PACKET];
+
+// The tail of a packet the socket didn't take yet, per client
+uint8_t bleTcpPending[BLE_MAX_CONNECTIONS][BLE_TCP_PACKET];
+uint16_t bleTcpPendingLength[BLE_MAX_CONNECTIONS];
+
+void bleTcpBegin(const char* deviceName) {
+    Serial.print("BLE serial over TCP, port ");
+    Serial.println(BLE_TCP_PORT);
+}
+
+// WiFiClient::write() on the ESP32 retries a full socket for up to a few
+// seconds, so writes go to the lwIP socket itself and return at once
+size_t bleTcpWrite(uint16_t connId, const uint8_t* data, size_t length) {
+#ifdef ESP32
+    int written = send(bleTcpClients[connId].fd(), data, length, MSG_DONTWAIT);
+    return written > 0 ? written : 0;
+#else
+    return bleTcpClients[connId].write(data, length);
+#endif
+}
+
+// Write out what is left of the last packet; true once nothing is
+bool bleTcpFlushPending(uint16_t connId) {
+    uint16_t& pending = bleTcpPendingLength[connId];
+    if (pending == 0) return true;
+    size_t written = bleTcpWrite(connId, bleTcpPending[connId], pending);
+    if (written > 0 && written < pending) {
+        memmove(bleTcpPending[connId], bleTcpPending[connId] + written, pending - written);
+    }
+    pending -= min(written, (size_t)pending);
+    return pending == 0;
+}
+
+void bleTcpPoll() {
+    if (!bleTcpListening) {
+        if (WiFi.status() != WL_CONNECTED) return;
+        bleTcpServer.begin();
+        bleTcpServer.setNoDelay(true);
+        bleTcpListening = true;
+    }
+
+    for (uint8_t i = 0; i < BLE_MAX_CONNECTIONS; i++) {
+        if (bleTcpOpen[i] && !bleTcpClients[i].connected()) {
+            bleTcpClients[i].stop();
+            bleTcpOpen[i] = false;
+            bleTransportClose(i);
+            Serial.println("BLE Device disconnected");
+        }
+    }
+
+    WiFiClient client = bleTcpServer.available();
+    if (client) {
+        int8_t id = -1;
+        for (uint8_t i = 0; i < BLE_MAX_CONNECTIONS && id < 0; i++) {
+            if (!bleTcpOpen[i]) id = i;
+        }
+        if (id < 0 || bleTransportOpen(id) < 0) {
+            Serial.println("BLE: no free connection slot, disconnecting");
+            client.stop();
+        } else {
+            client.setNoDelay(true);
+            bleTcpClients[id] = client;
+            bleTcpOpen[id] = true;
+            bleTcpPendingLength[id] = 0;
+            Serial.println("BLE Device connected");
+        }
+    }
+
+    // Hand over what has arrived, one write-sized chunk at a time, while
+    // the client's receive ring has room for it
+    for (uint8_t i = 0; i < BLE_MAX_CONNECTIONS; i++) {
+        if (!bleTcpOpen[i]) continue;
+        bleTcpFlushPending(i);
+        int8_t slot = bleLinkFind(i);
+        if (slot < 0) continue;
+        while (bleTcpClients[i].available() > 0 &&
+               spscFree(bleLinks[slot].rx) >= BLE_RX_HEADER + BLE_TCP_PACKET) {
+            int length = bleTcpClients[i].read(bleTcpReadBuffer, BLE_TCP_PACKET);
+            if (length <= 0) break;
+            bleTransportReceive(i, bleTcpReadBuffer, length);
+        }
+    }
+}
+
+// Always listening once started
+void bleTcpAdvertise() {
+}
+
+uint16_t bleTcpPacketSize(uint16_t connId) {
+    return BLE_TCP_PACKET;
+}
+
+// Never waits on the socket. A short write keeps the rest of the packet
+// here to go out first (reporting congestion after a partial write would
+// make bleTxFlush() send the whole packet again); while any of it is
+// left, the link reports congestion and the packet is offered again later,
+// as the GATT backend does when the stack runs out of buffers.
+bool bleTcpSend(uint16_t connId, const uint8_t* data, uint16_t length) {
+    if (!bleTcpOpen[connId]) return true;   // Gone; loop() cleans up
+    if (!bleTcpFlushPending(connId)) return false;
+    size_t written = bleTcpWrite(connId, data, length);
+    if (written == 0) return false;
+    if (written < length) {
+        memcpy(bleTcpPending[connId], data + written, length - written);
+        bleTcpPendingLength[connId] = length - written;
+    }
+    return true;
+}
+
+const BleTransport bleTcpTransport = {
+    "TCP",
+    bleTcpBegin,
+    bleTcpPoll,
+    bleTcpAdvertise,
+    bleTcpPacketSize,
+    bleTcpSend
+};
+
+#endif // BLE_TRANSPORT_TCP_H
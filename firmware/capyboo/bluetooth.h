@@ -1,10 +1,23 @@
 #ifndef BLUETOOTH_H
 #define BLUETOOTH_H
 
-#include <BLEDevice.h>
-#include <BLEServer.h>
-#include <BLEUtils.h>
-#include <BLE2902.h>
+#include "ble_frame.h"
+#include "spsc_ring.h"
+#include "tokenizer.h"
+#include "ble_transport.h"
+
+// The link itself lives behind a BleTransport (ble_transport.h): the GATT
+// server on the device, or a TCP socket for host builds
+#if defined(BLE_TRANSPORT_POSIX)
+#include "ble_transport_posix.h"
+const BleTransport& bleTransport = blePosixTransport;
+#elif defined(BLE_TRANSPORT_TCP)
+#include "ble_transport_tcp.h"
+const BleTransport& bleTransport = bleTcpTransport;
+#else
+#include "ble_transport_esp32.h"
+const BleTransport& bleTransport = bleEsp32Transport;
+#endif
 
 // BLE command length limits
 // Default BLE MTU: 20 bytes per packet (BLE 4.0)
@@ -13,164 +26,364 @@
 // Practical limit: ~200-300 characters for most commands
 #define BLE_MAX_COMMAND_LENGTH 256  // Maximum command length
 
-// BLE Serial Port Profile UUIDs
-#define BLE_SERVICE_UUID        "0000fff0-0000-1000-8000-00805f9b34fb"  // Serial Port Service
-#define BLE_CHAR_UUID_TX        "0000fff1-0000-1000-8000-00805f9b34fb"  // TX Characteristic
-#define BLE_CHAR_UUID_RX        "0000fff2-0000-1000-8000-00805f9b34fb"  // RX Characteristic
-
-// BLE objects
-BLEServer* pBLEServer = NULL;
-BLECharacteristic* pBLETxCharacteristic = NULL;
-BLECharacteristic* pBLERxCharacteristic = NULL;
-bool bleDeviceConnected = false;
-bool bleOldDeviceConnected = false;
-String bleReceivedData = "";
-
-// Buffer for accumulating multi-packet BLE data
-String bleReceiveBuffer = "";
-unsigned long bleLastReceiveTime = 0;
-const unsigned long BLE_RECEIVE_TIMEOUT = 100; // 100ms timeout between packets
-
-// BLE Server Callbacks
-class MyBLEServerCallbacks: public BLEServerCallbacks {
-    void onConnect(BLEServer* pServer) {
-      bleDeviceConnected = true;
-      Serial.println("BLE Device connected");
-    }
+unsigned long bleAdvertiseAt = 0;      // When to advertise again, 0 if not due
+const unsigned long BLE_READVERTISE_DELAY = 500;
 
-    void onDisconnect(BLEServer* pServer) {
-      bleDeviceConnected = false;
-      Serial.println("BLE Device disconnected");
-    }
+// Receive path
+// The transport only copies each write into its link's ring (on the
+// Bluedroid task for the radio). Everything else - framing, text
+// assembly, the command queue - happens in loop() via bleRxPump(), which
+// is the only code that touches that state.
+#define BLE_COMMAND_QUEUE_SIZE 8    // Completed commands waiting for loop()
+
+// Transmit path
+// bleSerialPrint() only appends to transmit rings; bleTxFlush() packs
+// whatever has built up into MTU-sized notifications once per loop()
+// pass, so a handler that prints several lines costs one or two
+// notifications and never waits on the radio. If the stack reports
+// congestion the flush backs off and retries the same bytes later.
+#define BLE_TX_RING_SIZE    2048    // Power of two
+#define BLE_TX_BURST        4       // Notifications per flush
+#define BLE_TX_RETRY        20      // ms to back off after a congested notify
+
+// Everything loop() keeps for one connected client. Slot i here belongs
+// to bleLinks[i].
+struct BleConnection {
+  bool open;
+  uint16_t connId;
+  uint16_t session;                     // Bumped for every client the slot serves
+
+  uint16_t rxOffset;                    // Bytes of the oldest record already fed to the frame decoder
+
+  // Completed commands, oldest first
+  char commandQueue[BLE_COMMAND_QUEUE_SIZE][BLE_MAX_COMMAND_LENGTH + 1];
+  uint8_t commandHead;
+  uint8_t commandCount;
+
+  // Unframed text accumulated across writes
+  char textBuffer[BLE_MAX_COMMAND_LENGTH + 1];
+  uint16_t textLength;
+  unsigned long lastReceiveTime;
+
+  // Framed commands (ble_frame.h)
+  BleFrameDecoder frame;
+  const char* frameError;
+
+  SpscByteRing<BLE_TX_RING_SIZE> tx;
+  unsigned long txRetryAt;
+  uint32_t txDropped;                   // Lines refused while the ring was full
 };
 
-// BLE Characteristic Callbacks for RX (receiving data)
-class BLERxCallbacks: public BLECharacteristicCallbacks {
-    void onWrite(BLECharacteristic *pCharacteristic) {
-      String rxValue = pCharacteristic->getValue();
-      if (rxValue.length() > 0) {
-        unsigned long currentTime = millis();
-        
-        // Check if this is a continuation of previous data (within timeout)
-        if (bleReceiveBuffer.length() > 0 && (currentTime - bleLastReceiveTime) < BLE_RECEIVE_TIMEOUT) {
-          // Append to buffer (accumulating chunks)
-          bleReceiveBuffer += rxValue;
-          Serial.print("BLE chunk received (");
-          Serial.print(rxValue.length());
-          Serial.print(" bytes), buffer now: ");
-          Serial.print(bleReceiveBuffer.length());
-          Serial.println(" bytes");
-        } else {
-          // New command or timeout - start fresh buffer
-          bleReceiveBuffer = rxValue;
-          Serial.print("BLE new data received (");
-          Serial.print(rxValue.length());
-          Serial.println(" bytes)");
-        }
-        
-        bleLastReceiveTime = currentTime;
-        
-        // Check if buffer exceeds limit
-        if (bleReceiveBuffer.length() > BLE_MAX_COMMAND_LENGTH) {
-          Serial.print("BLE command too long: ");
-          Serial.print(bleReceiveBuffer.length());
-          Serial.print(" bytes (max: ");
-          Serial.print(BLE_MAX_COMMAND_LENGTH);
-          Serial.println(")");
-          bleReceiveBuffer = ""; // Clear buffer
-          return;
-        }
-        
-        // Check if command is complete (ends with newline or is a complete WiFi command)
-        // For WiFi commands, check if we have both colons
-        if (bleReceiveBuffer.indexOf('\n') >= 0 || 
-            bleReceiveBuffer.indexOf('\r') >= 0 ||
-            (bleReceiveBuffer.startsWith("wifi:") && bleReceiveBuffer.indexOf(':', 5) > 0)) {
-          // Command is complete
-          bleReceivedData = bleReceiveBuffer;
-          bleReceivedData.trim();
-          bleReceiveBuffer = ""; // Clear buffer
-          
-          Serial.print("BLE Complete command (");
-          Serial.print(bleReceivedData.length());
-          Serial.print(" bytes): ");
-          Serial.println(bleReceivedData);
+BleConnection bleConnections[BLE_MAX_CONNECTIONS];
+uint8_t bleTxPacket[BLE_RX_MAX_WRITE];
+const unsigned long BLE_RECEIVE_TIMEOUT = 100; // 100ms timeout between packets (unframed text only)
+
+uint8_t bleConnectedCount() {
+  uint8_t count = 0;
+  for (uint8_t i = 0; i < BLE_MAX_CONNECTIONS; i++) {
+    if (bleConnections[i].open) count++;
+  }
+  return count;
+}
+
+// Changes whenever connection slot `connection` gets a new client, so
+// state kept for one client is not handed to the next
+uint16_t bleConnectionSession(uint8_t connection) {
+  return bleConnections[connection].session;
+}
+
+bool bleCommandQueueFull(const BleConnection& conn) {
+  return conn.commandCount >= BLE_COMMAND_QUEUE_SIZE;
+}
+
+// Queue a completed command, trimmed of surrounding whitespace. The
+// caller checks there is room first.
+void bleQueueCommand(BleConnection& conn, const char* text, size_t length, const char* source) {
+  while (length > 0 && isspace((unsigned char)text[0])) { text++; length--; }
+  while (length > 0 && isspace((unsigned char)text[length - 1])) length--;
+  if (length == 0) return;
+
+  char* slot = conn.commandQueue[(conn.commandHead + conn.commandCount) % BLE_COMMAND_QUEUE_SIZE];
+  memcpy(slot, text, length);
+  slot[length] = '\0';
+  conn.commandCount++;
+
+  Serial.print("BLE ");
+  Serial.print(source);
+  Serial.print(" command (");
+  Serial.print(length);
+  Serial.print(" bytes): ");
+  Serial.println(slot);
+}
+
+void bleFinishText(BleConnection& conn, const char* source) {
+  bleQueueCommand(conn, conn.textBuffer, conn.textLength, source);
+  conn.textLength = 0;
+}
+
+uint16_t bleRxRecordLength(const BleLink& link) {
+  return spscPeek(link.rx, 0) | (uint16_t)spscPeek(link.rx, 1) << 8;
+}
+
+unsigned long bleRxRecordTime(const BleLink& link) {
+  uint32_t at = 0;
+  for (uint8_t i = 0; i < 4; i++) at |= (uint32_t)spscPeek(link.rx, 2 + i) << (8 * i);
+  return at;
+}
+
+// Plain text write: wait for a newline or a quiet period. Needs one free
+// queue slot.
+void bleReceiveText(BleConnection& conn, const BleLink& link, uint16_t length, unsigned long at) {
+  // Check if this is a continuation of previous data (within timeout)
+  if (conn.textLength > 0 && (at - conn.lastReceiveTime) < BLE_RECEIVE_TIMEOUT) {
+    Serial.print("BLE chunk received (");
+    Serial.print(length);
+    Serial.print(" bytes), buffer now: ");
+    Serial.print(conn.textLength + length);
+    Serial.println(" bytes");
+  } else {
+    conn.textLength = 0;
+    Serial.print("BLE new data received (");
+    Serial.print(length);
+    Serial.println(" bytes)");
+  }
+  conn.lastReceiveTime = at;
+
+  // Check if buffer exceeds limit
+  if (conn.textLength + length > BLE_MAX_COMMAND_LENGTH) {
+    Serial.print("BLE command too long: ");
+    Serial.print(conn.textLength + length);
+    Serial.print(" bytes (max: ");
+    Serial.print(BLE_MAX_COMMAND_LENGTH);
+    Serial.println(")");
+    conn.textLength = 0;
+    return;
+  }
+  for (uint16_t i = 0; i < length; i++) {
+    conn.textBuffer[conn.textLength++] = (char)spscPeek(link.rx, BLE_RX_HEADER + i);
+  }
+  conn.textBuffer[conn.textLength] = '\0';
+
+  // Check if command is complete (ends with newline or is a complete WiFi command)
+  // For WiFi commands, check if we have both colons
+  if (strchr(conn.textBuffer, '\n') != NULL ||
+      strchr(conn.textBuffer, '\r') != NULL ||
+      (strncmp(conn.textBuffer, "wifi:", 5) == 0 && strchr(conn.textBuffer + 5, ':') != NULL)) {
+    bleFinishText(conn, "text");
+  }
+  // Otherwise, wait for more chunks (will timeout in handleBLESerial)
+}
+
+// Drain one client's writes into its command queue. Stops while the queue
+// is full, leaving the rest in the ring, so a burst is delayed rather
+// than lost; a frame can stop mid-write and carry on next time.
+void bleRxPump(uint8_t connection) {
+  BleConnection& conn = bleConnections[connection];
+  BleLink& link = bleLinks[connection];
+  if (!conn.open) return;
+
+  while (!bleCommandQueueFull(conn) && spscAvailable(link.rx) >= BLE_RX_HEADER) {
+    uint16_t length = bleRxRecordLength(link);
+    unsigned long at = bleRxRecordTime(link);
+
+    if (conn.rxOffset == 0) {
+      // A stalled half frame is dropped before looking at the next write
+      if (bleFrameInProgress(conn.frame) && at - conn.frame.lastByte >= BLE_FRAME_TIMEOUT) {
+        bleFrameReset(conn.frame);
+        conn.frameError = "incomplete frame";
+      }
+
+      if (!bleFrameInProgress(conn.frame) && spscPeek(link.rx, BLE_RX_HEADER) != BLE_FRAME_START) {
+        // Text left over from a write that went quiet before this one
+        if (conn.textLength > 0 && at - conn.lastReceiveTime >= BLE_RECEIVE_TIMEOUT) {
+          bleFinishText(conn, "text");
+          if (bleCommandQueueFull(conn)) break;
         }
-        // Otherwise, wait for more chunks (will timeout in handleBLESerial)
+        bleReceiveText(conn, link, length, at);
+        spscConsume(link.rx, BLE_RX_HEADER + length);
+        continue;
       }
     }
-};
+
+    // Binary frames: feed until the write is used up or the queue fills
+    while (conn.rxOffset < length && !bleCommandQueueFull(conn)) {
+      uint8_t result = bleFrameFeed(conn.frame, spscPeek(link.rx, BLE_RX_HEADER + conn.rxOffset));
+      conn.rxOffset++;
+      if (result == BLE_FRAME_DONE) {
+        bleQueueCommand(conn, conn.frame.payload, conn.frame.length, "framed");
+      } else if (result == BLE_FRAME_BAD_CRC) {
+        conn.frameError = "CRC mismatch";
+      } else if (result == BLE_FRAME_TOO_LONG) {
+        conn.frameError = "command too long";
+      }
+    }
+    conn.frame.lastByte = at;
+    if (conn.rxOffset < length) break;
+    spscConsume(link.rx, BLE_RX_HEADER + length);
+    conn.rxOffset = 0;
+  }
+}
+
+// Start a connection slot from scratch
+void bleConnectionReset(BleConnection& conn) {
+  conn.rxOffset = 0;
+  conn.commandHead = 0;
+  conn.commandCount = 0;
+  conn.textLength = 0;
+  bleFrameReset(conn.frame);
+  conn.frameError = nullptr;
+  spscDiscard(conn.tx);
+  conn.txRetryAt = 0;
+  conn.txDropped = 0;
+}
 
 // Initialize BLE Serial
 void initBLESerial(const char* deviceName) {
-  // Initialize BLE device
-  BLEDevice::init(deviceName);
-  
-  // Set MTU size to allow larger packets (up to 512 bytes)
-  // This enables BLE 4.2+ extended MTU feature
-  BLEDevice::setMTU(512);
-  
-  // Create BLE server
-  pBLEServer = BLEDevice::createServer();
-  pBLEServer->setCallbacks(new MyBLEServerCallbacks());
-
-  // Create BLE Serial Port Service
-  BLEService *pService = pBLEServer->createService(BLE_SERVICE_UUID);
-
-  // Create TX Characteristic (for sending data to phone)
-  pBLETxCharacteristic = pService->createCharacteristic(
-                      BLE_CHAR_UUID_TX,
-                      BLECharacteristic::PROPERTY_READ   |
-                      BLECharacteristic::PROPERTY_NOTIFY |
-                      BLECharacteristic::PROPERTY_INDICATE
-                    );
-  pBLETxCharacteristic->addDescriptor(new BLE2902());
-
-  // Create RX Characteristic (for receiving data from phone)
-  // Set value size to allow longer commands
-  pBLERxCharacteristic = pService->createCharacteristic(
-                      BLE_CHAR_UUID_RX,
-                      BLECharacteristic::PROPERTY_WRITE |
-                      BLECharacteristic::PROPERTY_WRITE_NR
-                    );
-  // Set the maximum value length (512 bytes)
-  pBLERxCharacteristic->setValue((uint8_t*)NULL, 0);
-  pBLERxCharacteristic->setCallbacks(new BLERxCallbacks());
-
-  // Start the service
-  pService->start();
-
-  // Start advertising
-  BLEAdvertising *pAdvertising = BLEDevice::getAdvertising();
-  pAdvertising->addServiceUUID(BLE_SERVICE_UUID);
-  pAdvertising->setScanResponse(true);
-  pAdvertising->setMinPreferred(0x06);  // Helps with iPhone connections
-  pAdvertising->setMinPreferred(0x12);
-  BLEDevice::startAdvertising();
-  
+  bleTransport.begin(deviceName);
+
   Serial.print("BLE Serial started! Device name: ");
   Serial.println(deviceName);
-  Serial.println("Waiting for connection...");
+  Serial.print("Waiting for connections (up to ");
+  Serial.print(BLE_MAX_CONNECTIONS);
+  Serial.println(")...");
+}
+
+// Oldest command from one client, left in its queue slot until
+// bleCommandPop()
+bool bleCommandPeek(uint8_t connection, TextSpan& command) {
+  BleConnection& conn = bleConnections[connection];
+  bleRxPump(connection);
+  if (!conn.open || conn.commandCount == 0) return false;
+  command = spanOf(conn.commandQueue[conn.commandHead]);
+  return true;
+}
+
+void bleCommandPop(uint8_t connection) {
+  BleConnection& conn = bleConnections[connection];
+  if (conn.commandCount == 0) return;
+  conn.commandHead = (conn.commandHead + 1) % BLE_COMMAND_QUEUE_SIZE;
+  conn.commandCount--;
 }
 
-// Check if data is available
+// Check if data is available from any client
 bool bleSerialAvailable() {
-  return (bleReceivedData.length() > 0);
+  TextSpan command;
+  for (uint8_t i = 0; i < BLE_MAX_CONNECTIONS; i++) {
+    if (bleCommandPeek(i, command)) return true;
+  }
+  return false;
 }
 
-// Read received data
+// Read received data (oldest command of the first client that has one)
 String bleSerialRead() {
-  String data = bleReceivedData;
-  bleReceivedData = ""; // Clear after reading
-  return data;
+  TextSpan command;
+  for (uint8_t i = 0; i < BLE_MAX_CONNECTIONS; i++) {
+    if (bleCommandPeek(i, command)) {
+      String data = spanString(command);
+      bleCommandPop(i);
+      return data;
+    }
+  }
+  return "";
+}
+
+// Next write on a data channel: copies up to `capacity` bytes into `dest`
+// and returns the write's full length (0 if there is none). `connection`
+// is the sender's slot, or -1 if it has disconnected since.
+template <uint16_t N>
+uint16_t bleChannelRead(SpscByteRing<N>& ring, int8_t& connection, uint8_t* dest, uint16_t capacity) {
+  if (spscAvailable(ring) < BLE_CHANNEL_HEADER) return 0;
+  uint16_t length = spscPeek(ring, 0) | (uint16_t)spscPeek(ring, 1) << 8;
+  uint16_t connId = spscPeek(ring, 2) | (uint16_t)spscPeek(ring, 3) << 8;
+  for (uint16_t i = 0; i < length && i < capacity; i++) {
+    dest[i] = spscPeek(ring, BLE_CHANNEL_HEADER + i);
+  }
+  spscConsume(ring, BLE_CHANNEL_HEADER + length);
+  connection = bleLinkFind(connId);
+  return length;
+}
+
+uint16_t bleBulkRead(int8_t& connection, uint8_t* dest, uint16_t capacity) {
+  return bleChannelRead(bleBulkRing, connection, dest, capacity);
+}
+
+uint16_t bleStreamRead(int8_t& connection, uint8_t* dest, uint16_t capacity) {
+  return bleChannelRead(bleStreamRing, connection, dest, capacity);
+}
+
+// True while slot `connection` still serves the client it had at `session`
+bool bleConnectionPresent(int8_t connection, uint16_t session) {
+  return connection >= 0 && connection < BLE_MAX_CONNECTIONS &&
+         bleConnections[connection].open && bleConnections[connection].session == session;
+}
+
+// Send one client's queued output: up to BLE_TX_BURST notifications, each
+// as full as its MTU allows. A packet that has more behind it is cut
+// after its last newline where there is one, so replies mostly arrive
+// line by line.
+void bleTxFlush(uint8_t connection) {
+  BleConnection& conn = bleConnections[connection];
+  if (!conn.open) return;
+  if (conn.txRetryAt != 0 && (long)(millis() - conn.txRetryAt) < 0) return;
+  conn.txRetryAt = 0;
+
+  uint16_t packetSize = min(bleTransport.packetSize(conn.connId), (uint16_t)BLE_RX_MAX_WRITE);
+  for (uint8_t sent = 0; sent < BLE_TX_BURST; sent++) {
+    uint32_t pending = spscAvailable(conn.tx);
+    if (pending == 0) return;
+
+    uint16_t length = min(pending, (uint32_t)packetSize);
+    for (uint16_t i = 0; i < length; i++) bleTxPacket[i] = spscPeek(conn.tx, i);
+    if (length < pending) {
+      for (uint16_t i = length; i > 0; i--) {
+        if (bleTxPacket[i - 1] == '\n') { length = i; break; }
+      }
+    }
+
+    if (!bleTransport.send(conn.connId, bleTxPacket, length)) {
+      // Stack is out of buffers: keep the bytes and try again shortly
+      conn.txRetryAt = millis() + BLE_TX_RETRY;
+      if (conn.txRetryAt == 0) conn.txRetryAt = 1;
+      return;
+    }
+    spscConsume(conn.tx, length);
+  }
 }
 
-// Send data via BLE
+void bleTxFlush() {
+  for (uint8_t i = 0; i < BLE_MAX_CONNECTIONS; i++) bleTxFlush(i);
+}
+
+// Queue output for one client; whole or not at all
+void bleEnqueue(uint8_t connection, const uint8_t* data, size_t length) {
+  BleConnection& conn = bleConnections[connection];
+  if (!conn.open) return;
+  if (spscFree(conn.tx) < length) {
+    bleTxFlush(connection);
+    if (spscFree(conn.tx) < length) {
+      // Client is not keeping up; drop whole lines rather than split one
+      conn.txDropped++;
+      return;
+    }
+  }
+  spscStage(conn.tx, 0, data, length);
+  spscPublish(conn.tx, length);
+}
+
+// Send data to one client (queued; goes out on the next flush)
+void bleSerialPrintTo(uint8_t connection, const String& data) {
+  bleEnqueue(connection, (const uint8_t*)data.c_str(), data.length());
+}
+
+void bleSerialPrintlnTo(uint8_t connection, const String& data) {
+  bleSerialPrintTo(connection, data + "\n");
+}
+
+// Send data to every connected client. Each gets its own copy in its
+// transmit ring, so a slow client only ever holds up itself.
 void bleSerialPrint(String data) {
-  if (bleDeviceConnected && pBLETxCharacteristic != NULL) {
-    pBLETxCharacteristic->setValue(data.c_str());
-    pBLETxCharacteristic->notify();
-    delay(10); // Small delay to ensure notification is sent
+  for (uint8_t i = 0; i < BLE_MAX_CONNECTIONS; i++) {
+    bleEnqueue(i, (const uint8_t*)data.c_str(), data.length());
   }
 }
 
@@ -178,48 +391,103 @@ void bleSerialPrintln(String data) {
   bleSerialPrint(data + "\n");
 }
 
+void bleScheduleAdvertise(unsigned long delayMs) {
+  bleAdvertiseAt = millis() + delayMs;
+  if (bleAdvertiseAt == 0) bleAdvertiseAt = 1;
+}
+
+// Pick up a client the transport has connected
+void bleConnectionOpened(uint8_t connection) {
+  BleConnection& conn = bleConnections[connection];
+  bleConnectionReset(conn);
+  conn.connId = bleLinks[connection].connId;
+  conn.session++;
+  conn.open = true;
+
+  uint8_t count = bleConnectedCount();
+  Serial.print("BLE: Device connected! (");
+  Serial.print(count);
+  Serial.print(" of ");
+  Serial.print(BLE_MAX_CONNECTIONS);
+  Serial.println(")");
+
+  // Keep advertising while there is room for another client
+  if (count < BLE_MAX_CONNECTIONS) bleScheduleAdvertise(0);
+
+  // Send welcome message
+  bleSerialPrintlnTo(connection, "Robot connected. Commands: weather, animation, timer");
+}
+
+// Forget a client that has gone and hand the slot back to the transport
+void bleConnectionClosed(uint8_t connection) {
+  BleConnection& conn = bleConnections[connection];
+  BleLink& link = bleLinks[connection];
+  if (conn.open) {
+    Serial.println("BLE: Device disconnected");
+    // Give the bluetooth stack time to get ready before advertising again,
+    // without holding up loop()
+    bleScheduleAdvertise(BLE_READVERTISE_DELAY);
+  }
+  conn.open = false;
+  bleConnectionReset(conn);
+  spscDiscard(link.rx);
+  link.rxDropped.store(0, std::memory_order_relaxed);
+  link.state.store(BLE_LINK_FREE, std::memory_order_release);
+}
+
 // Handle BLE connection/disconnection (call this in loop)
 void handleBLESerial() {
-  // Check for timeout on receive buffer (finalize command if no more data coming)
-  if (bleReceiveBuffer.length() > 0) {
-    unsigned long currentTime = millis();
-    if ((currentTime - bleLastReceiveTime) >= BLE_RECEIVE_TIMEOUT) {
-      // Timeout reached - finalize the command
-      bleReceivedData = bleReceiveBuffer;
-      bleReceivedData.trim();
-      bleReceiveBuffer = ""; // Clear buffer
-      
-      Serial.print("BLE Command finalized after timeout (");
-      Serial.print(bleReceivedData.length());
-      Serial.print(" bytes): ");
-      Serial.println(bleReceivedData);
+  bleTransport.poll();
+
+  for (uint8_t i = 0; i < BLE_MAX_CONNECTIONS; i++) {
+    BleConnection& conn = bleConnections[i];
+    BleLink& link = bleLinks[i];
+    uint8_t state = link.state.load(std::memory_order_acquire);
+    if (state == BLE_LINK_OPEN && !conn.open) {
+      bleConnectionOpened(i);
+    } else if (state == BLE_LINK_CLOSED) {
+      bleConnectionClosed(i);
+    }
+    if (!conn.open) continue;
+
+    bleRxPump(i);
+
+    if (conn.txDropped > 0) {
+      Serial.print("BLE transmit buffer full, lines dropped: ");
+      Serial.println(conn.txDropped);
+      conn.txDropped = 0;
+    }
+
+    // Tell the sender about writes and frames that were dropped
+    uint32_t dropped = link.rxDropped.exchange(0, std::memory_order_relaxed);
+    if (dropped > 0) {
+      Serial.print("BLE receive buffer full, writes dropped: ");
+      Serial.println(dropped);
+      bleSerialPrintlnTo(i, String("Receive buffer full: ") + dropped + " writes dropped");
+    }
+    if (conn.frameError != nullptr) {
+      Serial.print("BLE frame dropped: ");
+      Serial.println(conn.frameError);
+      bleSerialPrintlnTo(i, String("Frame dropped: ") + conn.frameError);
+      conn.frameError = nullptr;
+    }
+
+    // Check for timeout on receive buffer (finalize command if no more data coming)
+    if (conn.textLength > 0 && spscAvailable(link.rx) == 0 && !bleCommandQueueFull(conn) &&
+        millis() - conn.lastReceiveTime >= BLE_RECEIVE_TIMEOUT) {
+      bleFinishText(conn, "text");
     }
   }
-  
-  // Handle disconnection
-  if (!bleDeviceConnected && bleOldDeviceConnected) {
-    delay(500); // Give the bluetooth stack time to get ready
-    pBLEServer->startAdvertising(); // Restart advertising
-    Serial.println("BLE: Restarting advertising...");
-    bleOldDeviceConnected = bleDeviceConnected;
-    // Clear buffers on disconnect
-    bleReceiveBuffer = "";
-    bleReceivedData = "";
-  }
-  
-  // Handle new connection
-  if (bleDeviceConnected && !bleOldDeviceConnected) {
-    Serial.println("BLE: Device connected!");
-    bleOldDeviceConnected = bleDeviceConnected;
-    
-    // Clear buffers on new connection
-    bleReceiveBuffer = "";
-    bleReceivedData = "";
-    
-    // Send welcome message
-    bleSerialPrintln("Robot connected. Commands: weather, animation, timer");
+
+  bleTxFlush();
+
+  if (bleAdvertiseAt != 0 && (long)(millis() - bleAdvertiseAt) >= 0) {
+    bleAdvertiseAt = 0;
+    if (bleConnectedCount() < BLE_MAX_CONNECTIONS) {
+      bleTransport.advertise(); // Restart advertising
+      Serial.println("BLE: Restarting advertising...");
+    }
   }
 }
 
 #endif // BLUETOOTH_H
-
@@ -3,9 +3,18 @@
 #include <Wire.h>
 
 #include "face_animation.h"
+#include "eye_renderer.h"
 #include "weather.h"
 #include "dino_game.h"
 #include "clock.h"
+#include "sntp.h"
+#include "scheduler.h"
+#include "grayscale.h"
+#include "message_queue.h"
+#include "command_table.h"
+#include "command_router.h"
+#include "asset_upload.h"
+#include "frame_stream.h"
 
 // Touch sensor pin (from definitions.h)
 const int TOUCH_SENSOR_PIN = 4;
@@ -16,9 +25,29 @@ enum Mode {
     MODE_ANIMATION,
     MODE_WEATHER,
     MODE_GAME,
-    MODE_CLOCK
+    MODE_CLOCK,
+    MODE_GRAYSCALE,
+    MODE_STREAM
 };
-String message = "";
+
+// Moods pick the animation sequence; MOOD_RANDOM shuffles through them all
+enum Mood {
+    MOOD_RANDOM,
+    MOOD_IDLE,
+    MOOD_HAPPY,
+    MOOD_ENJOYING,
+    MOOD_ANGRY,
+    MOOD_SAD,
+    MOOD_VERYSAD,
+    MOOD_CRY,
+    MOOD_FUNNY,
+    MOOD_LOVE,
+    MOOD_SLEEP,
+    MOOD_THUMBUP,
+    MOOD_WAVE,
+    MOOD_COUNT
+};
+bool messageShowing = false;  // A queued message has the screen
 String currentCity = "";
 float currentTemperature = 0;
 float currentFeelsLike = 0;
@@ -28,9 +57,11 @@ int currentHour = 0;
 int currentMinute = 0;
 int currentSecond = 0;
 
-String mood = "random";
+Mood mood = MOOD_RANDOM;
+int moodAsset = -1;                 // Slot of an uploaded animation chosen with mood:<name>, or -1
 
 Mode currentMode = MODE_ANIMATION;  // Default mode
+GrayFrame grayShowcase;             // Frame shown in MODE_GRAYSCALE
 
 // Touch sensor long press detection
 unsigned long touchPressStartTime = 0;
@@ -56,6 +87,12 @@ void setup() {
     // Initialize BLE Serial
     initBLESerial("Capyboo");
 
+    // MQTT commands are picked up whenever WiFi is connected
+    initMQTT();
+
+    // Index animations uploaded to flash earlier
+    assetInit();
+
     // Initialize touch sensor
     pinMode(TOUCH_SENSOR_PIN, INPUT);
     
@@ -85,13 +122,16 @@ void setup() {
     // delay(2000);
     
     // Play wakeup animation once at startup
-    playWakeupAnimation();
+    playEyesWakeupAnimation();
     
     // Initialize random seed for sequence selection
     randomSeed(analogRead(0));
     
     // Select initial animation sequence based on mood
     selectAnimationSequence();
+
+    // Restore timers and alarms saved before the last reboot
+    initScheduler();
     
     // Display current mode
     displayCurrentMode();
@@ -113,7 +153,35 @@ void displayCurrentMode() {
         case MODE_CLOCK:
             modeText += "Clock";
             break;
+        case MODE_GRAYSCALE:
+            modeText += "Grayscale";
+            break;
+        case MODE_STREAM:
+            modeText += "Stream";
+            break;
+    }
+}
+
+// Transition played when entering each mode (indexed by Mode)
+const uint8_t MODE_TRANSITIONS[] = {
+    TRANSITION_DISSOLVE,    // MODE_ANIMATION
+    TRANSITION_SLIDE_LEFT,  // MODE_WEATHER
+    TRANSITION_WIPE,        // MODE_GAME
+    TRANSITION_SLIDE_UP,    // MODE_CLOCK
+    TRANSITION_NONE,        // MODE_GRAYSCALE pushes its own bitplanes
+    TRANSITION_NONE         // MODE_STREAM shows the phone's frames as they come
+};
+
+// Switch modes, tearing down whatever the old mode left running
+void enterMode(Mode newMode) {
+    grayEnd();
+    particlesSetEffect(EFFECT_NONE);
+    particlesClear();
+    if (newMode != currentMode) {
+        transitionBegin(MODE_TRANSITIONS[newMode]);
     }
+    eyes.rendered = false;  // Idle face redraws straight away if we land on it
+    currentMode = newMode;
 }
 
 // Animation sequence state
@@ -121,6 +189,7 @@ int animationIndex = 0;
 unsigned long lastAnimationTime = 0;
 const unsigned long ANIMATION_DELAY = 0; // Default delay between animations in ms
 int currentSequenceIndex = -1; // Track which sequence we're currently playing
+const uint8_t MOOD_CROSSFADE_FRAMES = 8; // Frames to dither between moods on a mid-sequence switch (0 = hard cut)
 
 // Simple function to play sound using analogWrite
 void play_sound() {
@@ -226,11 +295,13 @@ int currentAnimationSequenceLength = 0;
 #define ANIM_WITH_DELAY(func, delay) {func, delay}
 #define ANIM(func) {func, 0}  // Use default delay
 
+// Idle gaze is procedural (eye_renderer.h); blinking and small glances
+// keep running between entries, see MODE_ANIMATION in loop()
 AnimationEntry idleAnimationSequence[] = {
-    ANIM_WITH_DELAY(playLookRightFromMiddleAnimation, 1000),      // 0 - 1 second delay
-    ANIM_WITH_DELAY(playLookMiddleFromRightAnimation, 2000),     // 1 - 1 second delay
-    ANIM_WITH_DELAY(playLookLeftFromMiddleAnimation, 1000),       // 2 - 1 second delay
-    ANIM_WITH_DELAY(playLookMiddleFromLeftAnimation, 2000),      // 3 - 1 second delay
+    ANIM_WITH_DELAY(playEyesLookRightAnimation, 1000),      // 0 - 1 second delay
+    ANIM_WITH_DELAY(playEyesLookMiddleAnimation, 2000),     // 1 - 2 second delay
+    ANIM_WITH_DELAY(playEyesLookLeftAnimation, 1000),       // 2 - 1 second delay
+    ANIM_WITH_DELAY(playEyesLookMiddleAnimation, 2000),     // 3 - 2 second delay
 };
 
 AnimationEntry happyAnimationSequence[] = {
@@ -353,6 +424,32 @@ AnimationEntry WaveAnimationSequence[] = {
     ANIM(playWaveEndAnimation),
 };
 
+// Uploaded animations (asset_store.h) play as a sequence of their own, one
+// entry per frame, so loop() shows one frame per pass and keeps handling
+// commands and touches in between; playingAsset says which
+int playingAsset = -1;
+uint8_t assetFrameBuffer[ASSET_FRAME_BYTES];
+AnimationEntry assetAnimationSequence[ASSET_MAX_FRAMES];
+
+void playAssetFrame() {
+    if (playingAsset < 0) return;
+    if (assetReadFrame(playingAsset, animationIndex, assetFrameBuffer)) {
+        display_bitmap(assetFrameBuffer);
+    }
+}
+
+// Make the uploaded animation in `slot` the current sequence
+void selectAssetSequence(int slot) {
+    playingAsset = slot;
+    // 0 would mean ANIMATION_DELAY
+    unsigned long frameDelay = max(assets[slot].frameDelay, (uint16_t)1);
+    for (uint8_t i = 0; i < assets[slot].frames; i++) {
+        assetAnimationSequence[i] = ANIM_WITH_DELAY(playAssetFrame, frameDelay);
+    }
+    currentAnimationSequence = assetAnimationSequence;
+    currentAnimationSequenceLength = assets[slot].frames;
+}
+
 // Array of all available animation sequences (defined after all sequences)
 SequenceInfo allSequences[] = {
     {idleAnimationSequence, sizeof(idleAnimationSequence) / sizeof(idleAnimationSequence[0])},
@@ -380,239 +477,512 @@ SequenceInfo allSequences[] = {
 
 const int TOTAL_SEQUENCES = sizeof(allSequences) / sizeof(allSequences[0]);
 
+#define MOOD_SEQUENCE(s) s, sizeof(s) / sizeof(s[0])
+
+// Mood names and their sequences, in Mood order
+struct MoodInfo {
+    Mood mood;
+    const char* name;
+    AnimationEntry* sequence;
+    int length;
+};
+
+constexpr MoodInfo MOODS[] = {
+    {MOOD_RANDOM, "random", nullptr, 0},
+    {MOOD_IDLE, "idle", MOOD_SEQUENCE(idleAnimationSequence)},
+    {MOOD_HAPPY, "happy", MOOD_SEQUENCE(happyAnimationSequence)},
+    {MOOD_ENJOYING, "enjoying", MOOD_SEQUENCE(EnjoyingAnimationSequence)},
+    {MOOD_ANGRY, "angry", MOOD_SEQUENCE(AngryAnimationSequence)},
+    {MOOD_SAD, "sad", MOOD_SEQUENCE(SadAnimationSequence)},
+    {MOOD_VERYSAD, "verysad", MOOD_SEQUENCE(VerySadAnimationSequence)},
+    {MOOD_CRY, "cry", MOOD_SEQUENCE(CryAnimationSequence)},
+    {MOOD_FUNNY, "funny", MOOD_SEQUENCE(FunnyAnimationSequence)},
+    {MOOD_LOVE, "love", MOOD_SEQUENCE(LoveAnimationSequence)},
+    {MOOD_SLEEP, "sleep", MOOD_SEQUENCE(SleepAnimationSequence)},
+    {MOOD_THUMBUP, "thumbup", MOOD_SEQUENCE(ThumbAnimationSequence)},
+    {MOOD_WAVE, "wave", MOOD_SEQUENCE(WaveAnimationSequence)},
+};
+
+// MOODS[m] must be mood m: selectAnimationSequence() indexes it by mood
+static_assert(sizeof(MOODS) / sizeof(MOODS[0]) == MOOD_COUNT, "MOODS needs one entry per Mood");
+static_assert(tableInOrder(MOODS, &MoodInfo::mood), "MOODS is not in Mood order");
+
+constexpr PerfectHashIndex<32> MOOD_INDEX = perfectHashBuild<32>(MOODS);
+static_assert(MOOD_INDEX.seed != 0, "no perfect hash for the mood names");
+
+// Look up a mood by name (any case); false if there is no such mood
+bool moodFromName(const char* name, size_t length, Mood& result) {
+    int index = perfectHashFind(MOOD_INDEX, MOODS, name, length);
+    if (index < 0) return false;
+    result = MOODS[index].mood;
+    return true;
+}
+
+// Set a built-in mood. Every change of mood goes through here so that an
+// uploaded animation chosen earlier with mood:<name> doesn't stay in front.
+void setMood(Mood newMood) {
+    mood = newMood;
+    moodAsset = -1;
+}
+
 // Function to select animation sequence based on mood, or random if mood not set
 void selectAnimationSequence() {
+    // A switch that cuts into a running sequence gets crossfaded below
+    AnimationEntry* previousSequence = currentAnimationSequence;
+    bool interrupted = previousSequence != nullptr && animationIndex > 0 &&
+                       animationIndex < currentAnimationSequenceLength;
+
+    // An uploaded animation may have been deleted since it was chosen
+    if (moodAsset >= 0 && !assets[moodAsset].valid) moodAsset = -1;
+
     // Check mood and select corresponding sequence
-    if (mood == "idle") {
-        currentAnimationSequence = idleAnimationSequence;
-        currentAnimationSequenceLength = sizeof(idleAnimationSequence) / sizeof(idleAnimationSequence[0]);
-        currentSequenceIndex = 0;
-    } else if (mood == "happy") {
-        currentAnimationSequence = happyAnimationSequence;
-        currentAnimationSequenceLength = sizeof(happyAnimationSequence) / sizeof(happyAnimationSequence[0]);
-        currentSequenceIndex = 1;
-    } else if (mood == "enjoying") {
-        currentAnimationSequence = EnjoyingAnimationSequence;
-        currentAnimationSequenceLength = sizeof(EnjoyingAnimationSequence) / sizeof(EnjoyingAnimationSequence[0]);
-        currentSequenceIndex = 2;
-    } else if (mood == "angry") {
-        currentAnimationSequence = AngryAnimationSequence;
-        currentAnimationSequenceLength = sizeof(AngryAnimationSequence) / sizeof(AngryAnimationSequence[0]);
-        currentSequenceIndex = 3;
-    } else if (mood == "sad") {
-        currentAnimationSequence = SadAnimationSequence;
-        currentAnimationSequenceLength = sizeof(SadAnimationSequence) / sizeof(SadAnimationSequence[0]);
-        currentSequenceIndex = 4;
-    } else if (mood == "verysad") {
-        currentAnimationSequence = VerySadAnimationSequence;
-        currentAnimationSequenceLength = sizeof(VerySadAnimationSequence) / sizeof(VerySadAnimationSequence[0]);
-        currentSequenceIndex = 5;
-    } else if (mood == "cry") {
-        currentAnimationSequence = CryAnimationSequence;
-        currentAnimationSequenceLength = sizeof(CryAnimationSequence) / sizeof(CryAnimationSequence[0]);
-        currentSequenceIndex = 6;
-    } else if (mood == "funny") {
-        currentAnimationSequence = FunnyAnimationSequence;
-        currentAnimationSequenceLength = sizeof(FunnyAnimationSequence) / sizeof(FunnyAnimationSequence[0]);
-        currentSequenceIndex = 7;
-    } else if (mood == "love") {
-        currentAnimationSequence = LoveAnimationSequence;
-        currentAnimationSequenceLength = sizeof(LoveAnimationSequence) / sizeof(LoveAnimationSequence[0]);
-        currentSequenceIndex = 8;
-    } else if (mood == "sleep") {
-        currentAnimationSequence = SleepAnimationSequence;
-        currentAnimationSequenceLength = sizeof(SleepAnimationSequence) / sizeof(SleepAnimationSequence[0]);
-        currentSequenceIndex = 9;
-    } else if (mood == "thumbup") {
-        currentAnimationSequence = ThumbAnimationSequence;
-        currentAnimationSequenceLength = sizeof(ThumbAnimationSequence) / sizeof(ThumbAnimationSequence[0]);
-        currentSequenceIndex = 10;
-    } else if (mood == "wave") {
-        currentAnimationSequence = WaveAnimationSequence;
-        currentAnimationSequenceLength = sizeof(WaveAnimationSequence) / sizeof(WaveAnimationSequence[0]);
-        currentSequenceIndex = 11;
+    if (moodAsset >= 0) {
+        selectAssetSequence(moodAsset);
+        currentSequenceIndex = -1;
+    } else if (mood != MOOD_RANDOM) {
+        currentAnimationSequence = MOODS[mood].sequence;
+        currentAnimationSequenceLength = MOODS[mood].length;
+        currentSequenceIndex = mood - 1;
     } else {
-        // No specific mood set - randomly select from all sequences
-        int randomIndex = random(0, TOTAL_SEQUENCES);
+        // No specific mood set - randomly select from all sequences,
+        // uploaded animations included
+        int choices = TOTAL_SEQUENCES + assetCount();
+        int randomIndex = random(0, choices);
         
         // Make sure we don't pick the same sequence twice in a row
-        while (randomIndex == currentSequenceIndex && TOTAL_SEQUENCES > 1) {
-            randomIndex = random(0, TOTAL_SEQUENCES);
+        while (randomIndex == currentSequenceIndex && choices > 1) {
+            randomIndex = random(0, choices);
         }
         
         currentSequenceIndex = randomIndex;
-        currentAnimationSequence = allSequences[currentSequenceIndex].sequence;
-        currentAnimationSequenceLength = allSequences[currentSequenceIndex].length;
+        if (randomIndex < TOTAL_SEQUENCES) {
+            currentAnimationSequence = allSequences[currentSequenceIndex].sequence;
+            currentAnimationSequenceLength = allSequences[currentSequenceIndex].length;
+        } else {
+            selectAssetSequence(assetNth(randomIndex - TOTAL_SEQUENCES));
+        }
         
         Serial.print("Selected random sequence: ");
         Serial.println(currentSequenceIndex);
     }
+
+    // Whatever was on screen, the procedural face must redraw in full
+    if (currentAnimationSequence == idleAnimationSequence) {
+        eyes.rendered = false;
+    }
+
+    // Overlay effects for sequences that have one
+    if (currentAnimationSequence == LoveAnimationSequence) {
+        particlesSetEffect(EFFECT_HEARTS);
+    } else if (currentAnimationSequence == CryAnimationSequence) {
+        particlesSetEffect(EFFECT_TEARS);
+    } else {
+        particlesSetEffect(EFFECT_NONE);
+    }
+
+    if (interrupted && currentAnimationSequence != previousSequence && MOOD_CROSSFADE_FRAMES > 0) {
+        display_begin_crossfade(MOOD_CROSSFADE_FRAMES);
+    }
     
     animationIndex = 0; // Reset to start of new sequence
 }
 
-void loop() {
-    // Handle BLE connection/disconnection (required for BLE communication)
-    handleBLESerial();
+// Things a scheduled event can do, by name
+struct NamedPlayback {
+    const char* name;
+    AnimationFunction func;
+};
 
-    if (bleSerialAvailable()) {
-        String command = bleSerialRead();
-        command.trim();
-        String lowerCommand = command;
-        lowerCommand.toLowerCase();
-        
-        Serial.print("Received BLE command: ");
-        Serial.println(command);
-        // Handle mode switching commands
-        if (lowerCommand.startsWith("mode:")) {
-            String modeStr = lowerCommand.substring(5); // Get text after "mode:"
-            modeStr.trim();
-            
-            if (modeStr == "weather") {
-                currentMode = MODE_WEATHER;
-                bleSerialPrintln("Switched to Weather mode");
-                displayCurrentMode();
-            } else if (modeStr == "game") {
-                currentMode = MODE_GAME;
-                bleSerialPrintln("Switched to Game mode");
-                displayCurrentMode();
-            } else if (modeStr == "animation") {
-                currentMode = MODE_ANIMATION;
-                bleSerialPrintln("Switched to Animation mode");
-                displayCurrentMode();
-            } else if (modeStr == "clock") {
-                currentMode = MODE_CLOCK;
-                bleSerialPrintln("Switched to Clock mode");
-                displayCurrentMode();
-            } else {
-                String errorMsg = "Unknown mode: " + modeStr;
-                display_text(errorMsg.c_str());
-                bleSerialPrintln("Unknown mode. Use: mode:animation, mode:weather, or mode:game");
-                delay(2000);
-            }
-        } else if (lowerCommand.startsWith("weather:")) {
-            Serial.print("Weather command: ");
-            String weatherCommand = lowerCommand.substring(8); // Get text after "weather:"
-            weatherCommand.trim();
-            Serial.print("Parsing: ");
-            Serial.println(weatherCommand);
-            // command format: weather:city:temperature:feels_like:humidity:description
-            // Parse the colon-separated values
-            int pos = 0;
-            int nextPos = weatherCommand.indexOf(":", pos);
-            
-            // Parse city (required)
-            if (nextPos > 0) {
-                currentCity = weatherCommand.substring(pos, nextPos);
-                pos = nextPos + 1;
-                Serial.print("City: ");
-                Serial.println(currentCity);
-            } else if (nextPos == 0) {
-                // Colon at start - empty city
-                bleSerialPrintln("Invalid weather format: city cannot be empty");
-            } else {
-                // No colon found - city is the entire string
-                currentCity = weatherCommand;
-                pos = weatherCommand.length();
-                Serial.print("City (no more fields): ");
-                Serial.println(currentCity);
-            }
-            
-            // Parse temperature (required)
-            if (pos < weatherCommand.length()) {
-                nextPos = weatherCommand.indexOf(":", pos);
-                if (nextPos > pos) {
-                    currentTemperature = weatherCommand.substring(pos, nextPos).toFloat();
-                    pos = nextPos + 1;
-                    Serial.print("Temperature: ");
-                    Serial.println(currentTemperature);
-                } else if (nextPos == -1) {
-                    // No more colons - temperature is the rest
-                    currentTemperature = weatherCommand.substring(pos).toFloat();
-                    pos = weatherCommand.length();
-                    Serial.print("Temperature (last field): ");
-                    Serial.println(currentTemperature);
-                } else {
-                    bleSerialPrintln("Invalid weather format: missing temperature");
-                    pos = weatherCommand.length(); // Skip rest
-                }
-            }
-            
-            // Parse feels_like (required)
-            if (pos < weatherCommand.length()) {
-                nextPos = weatherCommand.indexOf(":", pos);
-                if (nextPos > pos) {
-                    currentFeelsLike = weatherCommand.substring(pos, nextPos).toFloat();
-                    pos = nextPos + 1;
-                    Serial.print("Feels like: ");
-                    Serial.println(currentFeelsLike);
-                } else if (nextPos == -1) {
-                    // No more colons - feels_like is the rest
-                    currentFeelsLike = weatherCommand.substring(pos).toFloat();
-                    pos = weatherCommand.length();
-                    Serial.print("Feels like (last field): ");
-                    Serial.println(currentFeelsLike);
-                } else {
-                    bleSerialPrintln("Invalid weather format: missing feels_like");
-                    pos = weatherCommand.length(); // Skip rest
-                }
-            }
-            
-            // Parse humidity (required, but description is optional)
-            if (pos < weatherCommand.length()) {
-                nextPos = weatherCommand.indexOf(":", pos);
-                if (nextPos > pos) {
-                    // Has description after humidity
-                    currentHumidity = weatherCommand.substring(pos, nextPos).toInt();
-                    pos = nextPos + 1;
-                    currentDescription = weatherCommand.substring(pos);
-                    Serial.print("Humidity: ");
-                    Serial.println(currentHumidity);
-                    Serial.print("Description: ");
-                    Serial.println(currentDescription);
-                } else if (nextPos == -1) {
-                    // No description - humidity is the rest
-                    currentHumidity = weatherCommand.substring(pos).toInt();
-                    currentDescription = "";
-                    Serial.print("Humidity (last field): ");
-                    Serial.println(currentHumidity);
-                } else {
-                    bleSerialPrintln("Invalid weather format: missing humidity");
-                }
-                
-                // Display the weather data
-                displayWeatherOnOLED(currentCity, currentTemperature, currentFeelsLike, currentHumidity, currentDescription);
-                bleSerialPrintln("Weather data updated");
-            } else {
-                bleSerialPrintln("Invalid weather format: missing humidity");
-            }
+const NamedPlayback SCHEDULE_ANIMATIONS[] = {
+    {"loveyou", playLoveYouAnimation},
+    {"wakeup", playEyesWakeupAnimation},
+    {"blink", playEyesBlinkAnimation},
+    {"love", playLoveAnimation},
+    {"tickle", playTickleAnimation},
+    {"sleep", playSleepAnimation},
+    {"thumb", playThumbAnimation},
+    {"wave", playWaveAnimation},
+};
+
+void playBeepMelody() {
+    for (int i = 0; i < 3; i++) {
+        playTonePattern(1047, 120);
+        delay(120);
+    }
+}
+
+void playAlarmMelody() {
+    for (int i = 0; i < 4; i++) {
+        playTonePattern(880, 150);
+        playTonePattern(1175, 150);
+        delay(200);
+    }
+}
+
+const NamedPlayback SCHEDULE_MELODIES[] = {
+    {"beep", playBeepMelody},
+    {"alarm", playAlarmMelody},
+    {"loveyou", playLoveYouMelody},
+};
+
+const int SCHEDULE_ANIMATION_COUNT = sizeof(SCHEDULE_ANIMATIONS) / sizeof(SCHEDULE_ANIMATIONS[0]);
+const int SCHEDULE_MELODY_COUNT = sizeof(SCHEDULE_MELODIES) / sizeof(SCHEDULE_MELODIES[0]);
+
+// Index of a named animation or melody, or -1
+int findScheduleAnimation(const char* name) {
+    for (int i = 0; i < SCHEDULE_ANIMATION_COUNT; i++) {
+        if (strcmp(SCHEDULE_ANIMATIONS[i].name, name) == 0) return i;
+    }
+    return -1;
+}
+
+int findScheduleMelody(const char* name) {
+    for (int i = 0; i < SCHEDULE_MELODY_COUNT; i++) {
+        if (strcmp(SCHEDULE_MELODIES[i].name, name) == 0) return i;
+    }
+    return -1;
+}
+
+// Declared in scheduler.h
+bool scheduleActionValid(uint8_t action, const char* arg) {
+    switch (action) {
+        case SCHEDULE_ACTION_MOOD: {
+            Mood unused;
+            return moodFromName(arg, strlen(arg), unused);
         }
-        else if (lowerCommand.startsWith("message:")) {
-            message = lowerCommand.substring(8); // Get text after "message:"
-            message.trim();
-        } else if (lowerCommand.startsWith("mood:")) {
-            String moodStr = lowerCommand.substring(5); // Get text after "mood:"
-            moodStr.trim();
-            moodStr.toLowerCase();
-            mood = moodStr;
-            bleSerialPrintln("Mood set to: " + mood);
-            // Immediately switch to the mood's animation sequence
+        case SCHEDULE_ACTION_ANIMATION:
+            return findScheduleAnimation(arg) >= 0;
+        case SCHEDULE_ACTION_MELODY:
+            return findScheduleMelody(arg) >= 0;
+        default:
+            return true;
+    }
+}
+
+// Carry out a timer, alarm or recurring event that came due
+void fireScheduledEvent(const ScheduledEvent& event) {
+    Serial.print("Scheduled event #");
+    Serial.print(event.id);
+    Serial.print(" fired: ");
+    Serial.println(event.arg);
+
+    switch (event.action) {
+        case SCHEDULE_ACTION_MOOD: {
+            Mood scheduled;
+            if (moodFromName(event.arg, strlen(event.arg), scheduled)) setMood(scheduled);
             if (currentMode == MODE_ANIMATION) {
                 selectAnimationSequence();
             }
-        }  else if (lowerCommand.startsWith("time:")) {
-            String clockCommand = lowerCommand.substring(5); // Get text after "time:"
-            clockCommand.trim();
-
-            // command format: clock:HH:MM:SS or clock:HH:MM:SS DD/MM/YYYY
-            // Use the setTimeFromString function from clock.h
-            if (setTimeFromString(clockCommand)) {
-                bleSerialPrintln("Clock time set successfully");
-            } else {
-                bleSerialPrintln("Invalid clock format. Use: clock:HH:MM:SS or clock:HH:MM:SS DD/MM/YYYY");
-            }
+            break;
         }
+        case SCHEDULE_ACTION_ANIMATION: {
+            int index = findScheduleAnimation(event.arg);
+            if (index >= 0) SCHEDULE_ANIMATIONS[index].func();
+            eyes.rendered = false;  // Whatever was on screen must redraw
+            break;
+        }
+        case SCHEDULE_ACTION_MELODY: {
+            int index = findScheduleMelody(event.arg);
+            if (index >= 0) SCHEDULE_MELODIES[index].func();
+            break;
+        }
+        case SCHEDULE_ACTION_MESSAGE:
+            // Plain timers and alarms beep as well as showing their text
+            playBeepMelody();
+            messagePush(event.arg, strlen(event.arg), MESSAGE_PRIORITY_HIGH);
+            break;
+    }
+    bleSerialPrintln(String(scheduleKindName(event.kind)) + " #" + String(event.id) + " fired");
+}
+
+// Command handlers. Each gets a span (tokenizer.h) over the text after
+// "<verb>:" in its original case; comparisons ignore case. They return
+// whether the command was carried out, which is what sequenced commands
+// are acked or nacked on.
 
+// mode:animation|weather|game|clock|gray|stream
+bool handleModeCommand(TextSpan args) {
+    TextSpan modeStr = spanTrim(args);
+
+    if (spanEquals(modeStr, "weather")) {
+        enterMode(MODE_WEATHER);
+        commandReply("Switched to Weather mode");
+        displayCurrentMode();
+    } else if (spanEquals(modeStr, "game")) {
+        enterMode(MODE_GAME);
+        commandReply("Switched to Game mode");
+        displayCurrentMode();
+    } else if (spanEquals(modeStr, "animation")) {
+        enterMode(MODE_ANIMATION);
+        commandReply("Switched to Animation mode");
+        displayCurrentMode();
+    } else if (spanEquals(modeStr, "clock")) {
+        enterMode(MODE_CLOCK);
+        commandReply("Switched to Clock mode");
+        displayCurrentMode();
+    } else if (spanEquals(modeStr, "gray")) {
+        enterMode(MODE_GRAYSCALE);
+        grayBuildShowcase(grayShowcase);
+        grayBegin(&grayShowcase);
+        commandReply("Switched to Grayscale mode");
+        displayCurrentMode();
+    } else if (spanEquals(modeStr, "stream")) {
+        enterMode(MODE_STREAM);
+        streamBegin(commandSourceIsBle(commandSource) ? commandSource - COMMAND_SOURCE_BLE : -1);
+        commandReply("Switched to Stream mode");
+        displayCurrentMode();
+    } else {
+        String errorMsg = "Unknown mode: " + spanString(modeStr);
+        display_text(errorMsg.c_str());
+        commandReply("Unknown mode. Use: mode:animation, mode:weather, mode:game, mode:clock, mode:gray or mode:stream");
+        delay(2000);
+        return false;
+    }
+    return true;
+}
+
+// weather:city:temperature:feels_like:humidity[:description]
+// Nothing is changed unless every required field parses.
+bool handleWeatherCommand(TextSpan args) {
+    TextSpan rest = spanTrim(args);
+    TextSpan city;
+    float temperature, feelsLike;
+    long humidity;
+
+    spanSplit(rest, ':', city);
+    city = spanTrim(city);
+    if (spanEmpty(city)) {
+        commandReply("Invalid weather format: city cannot be empty");
+        return false;
+    }
+    if (!spanNextFloat(rest, ':', temperature)) {
+        commandReply("Invalid weather format: missing temperature");
+        return false;
+    }
+    if (!spanNextFloat(rest, ':', feelsLike)) {
+        commandReply("Invalid weather format: missing feels_like");
+        return false;
+    }
+    if (!spanNextLong(rest, ':', humidity)) {
+        commandReply("Invalid weather format: missing humidity");
+        return false;
+    }
+
+    // Everything after the humidity, colons included, is the description
+    currentCity = spanString(city);
+    currentCity.toLowerCase();
+    currentTemperature = temperature;
+    currentFeelsLike = feelsLike;
+    currentHumidity = humidity;
+    currentDescription = spanString(spanTrim(rest));
+    currentDescription.toLowerCase();
+
+    Serial.print("Weather: ");
+    Serial.print(currentCity);
+    Serial.print(", ");
+    Serial.print(currentTemperature);
+    Serial.print(" (feels ");
+    Serial.print(currentFeelsLike);
+    Serial.print("), ");
+    Serial.print(currentHumidity);
+    Serial.print("%, ");
+    Serial.println(currentDescription);
+
+    // Display the weather data
+    displayWeatherOnOLED(currentCity, currentTemperature, currentFeelsLike, currentHumidity, currentDescription);
+    commandReply("Weather data updated");
+    return true;
+}
+
+bool handleMessageCommand(TextSpan args) {
+    // Keep the original case (and any UTF-8) of the text
+    String reply;
+    bool ok = messageQueueCommand(args, reply);
+    commandReply(reply);
+    return ok;
+}
+
+bool handleMoodCommand(TextSpan args) {
+    TextSpan moodStr = spanTrim(args);
+    Mood named = MOOD_RANDOM;
+    bool known = moodFromName(moodStr.data, moodStr.length, named);
+    setMood(named);
+    if (!known) {
+        // An uploaded animation plays like a mood of its own
+        moodAsset = assetFind(moodStr);
+        known = moodAsset >= 0;
+    }
+    if (moodAsset >= 0) {
+        commandReply(String("Mood set to: ") + assets[moodAsset].name);
+    } else if (!known) {
+        commandReply("Unknown mood: " + spanString(moodStr) + ", playing random");
+    } else {
+        commandReply(String("Mood set to: ") + MOODS[mood].name);
+    }
+    // Immediately switch to the mood's animation sequence
+    if (currentMode == MODE_ANIMATION) {
+        selectAnimationSequence();
+    }
+    return known;
+}
+
+// time:HH:MM:SS or time:HH:MM:SS DD/MM/YYYY
+bool handleTimeCommand(TextSpan args) {
+    if (setTimeFromText(args)) {
+        commandReply("Clock time set successfully");
+        return true;
+    }
+    commandReply("Invalid clock format. Use: clock:HH:MM:SS or clock:HH:MM:SS DD/MM/YYYY");
+    return false;
+}
+
+bool handleNtpCommand(TextSpan args) {
+    String reply;
+    bool ok = ntpCommand(args, reply);
+    commandReply(reply);
+    return ok;
+}
+
+// timer:/alarm:/every: - msg= text keeps its case
+bool handleScheduleKind(uint8_t kind, TextSpan args) {
+    String reply;
+    bool ok = schedulerCommand(kind, args, reply);
+    commandReply(reply);
+    return ok;
+}
+
+bool handleTimerCommand(TextSpan args) { return handleScheduleKind(SCHEDULE_TIMER, args); }
+bool handleAlarmCommand(TextSpan args) { return handleScheduleKind(SCHEDULE_ALARM, args); }
+bool handleEveryCommand(TextSpan args) { return handleScheduleKind(SCHEDULE_EVERY, args); }
+
+bool handleScheduleCommand(TextSpan args) {
+    String reply;
+    bool ok = schedulerManageCommand(args, reply);
+    commandReply(reply);
+    return ok;
+}
+
+bool handleClockFaceCommand(TextSpan args) {
+    TextSpan faceStr = spanTrim(args);
+    if (spanEquals(faceStr, "analog")) {
+        clockSetFace(CLOCK_FACE_ANALOG);
+        commandReply("Clock face set to analog");
+    } else if (spanEquals(faceStr, "digital")) {
+        clockSetFace(CLOCK_FACE_DIGITAL);
+        commandReply("Clock face set to digital");
+    } else {
+        commandReply("Unknown clock face. Use: clockface:digital or clockface:analog");
+        return false;
+    }
+    return true;
+}
+
+// asset:... (asset_upload.h). Uploaded animations are chosen with
+// mood:<name>, so an upload may not take a built-in mood's name.
+bool handleAssetCommand(TextSpan args) {
+    TextSpan rest = args;
+    TextSpan action;
+    TextSpan name;
+    spanSplit(rest, ':', action);
+    spanSplit(rest, ':', name);
+    name = spanTrim(name);
+    Mood unused;
+    if (spanEquals(spanTrim(action), "upload") && moodFromName(name.data, name.length, unused)) {
+        commandReply("Asset name is taken by a built-in mood: " + spanString(name));
+        return false;
+    }
+    return assetCommand(args);
+}
+
+// Command verbs, looked up through a perfect hash built at compile time
+typedef bool (*CommandHandler)(TextSpan args);
+
+struct CommandEntry {
+    const char* name;
+    CommandHandler handler;
+};
+
+constexpr CommandEntry COMMANDS[] = {
+    {"mode", handleModeCommand},
+    {"weather", handleWeatherCommand},
+    {"message", handleMessageCommand},
+    {"mood", handleMoodCommand},
+    {"time", handleTimeCommand},
+    {"ntp", handleNtpCommand},
+    {"timer", handleTimerCommand},
+    {"alarm", handleAlarmCommand},
+    {"every", handleEveryCommand},
+    {"schedule", handleScheduleCommand},
+    {"clockface", handleClockFaceCommand},
+    {"asset", handleAssetCommand},
+};
+
+constexpr PerfectHashIndex<32> COMMAND_INDEX = perfectHashBuild<32>(COMMANDS);
+static_assert(COMMAND_INDEX.seed != 0, "no perfect hash for the command verbs");
+
+// Parse and run one command from any transport; replies go back to it
+void routeCommand(uint8_t source, TextSpan command) {
+    command = spanTrim(command);
+    Serial.print("Received ");
+    Serial.print(commandSourceName(source));
+    Serial.print(" command: ");
+    Serial.write(command.data, command.length);
+    Serial.println();
+
+    uint16_t sequence = 0;
+    bool sequenced = commandTakeSequence(command, sequence);
+
+    // Dispatch on the verb before the first colon
+    TextSpan args = command;
+    TextSpan verb;
+    spanSplit(args, ':', verb);
+    int index = spanExhausted(args) ? -1 : perfectHashFind(COMMAND_INDEX, COMMANDS, verb.data, verb.length);
+
+    commandSource = source;
+    commandSequence = sequence;
+    bool ok = false;
+    if (index >= 0) {
+        ok = COMMANDS[index].handler(args);
+    } else if (sequenced) {
+        commandReply("Unknown command");
+    }
+    commandSource = COMMAND_SOURCE_NONE;
+    commandSequence = 0;
+
+    if (sequenced) commandAcknowledge(source, sequence, ok);
+}
+
+void loop() {
+    // Handle BLE connection/disconnection (required for BLE communication)
+    handleBLESerial();
+
+    // Write any uploaded animation chunks that have arrived to flash
+    assetUploadPump();
+
+    // Advance any running mode transition (bounded work per pass)
+    transitionTick();
+
+    // Keep the clock in step with network time while WiFi is up
+    ntpUpdate();
+
+    // Stay connected to the MQTT broker and take in its commands
+    handleMQTT();
+
+    // Fire any timers and alarms that are due
+    ScheduledEvent dueEvent;
+    while (schedulerPoll(dueEvent)) {
+        fireScheduledEvent(dueEvent);
+    }
+
+    // Commands from BLE, MQTT and the serial console, one of each per pass
+    for (uint8_t source = COMMAND_SOURCE_FIRST; source <= COMMAND_SOURCE_LAST; source++) {
+        TextSpan command;
+        if (commandPeek(source, command)) {
+            routeCommand(source, command);
+            commandRelease(source);
+        }
+        // Acknowledge a pipelined batch once its last command has run
+        if (!commandPeek(source, command)) commandFlushAcks(source);
     }
 
    
@@ -638,18 +1008,18 @@ void loop() {
                 
                 // Play love you animation with music
                 playLoveYouAnimation();
-                message = "";
+                messageClearAll();
                 
                 // Reset touch state
                 touchPressed = false;
             } else if (pressDuration >= LONG_PRESS_DURATION && pressDuration < VERY_LONG_PRESS_DURATION && !tickleAnimationPlaying && !veryLongPressTriggered) {
                 // Long press detected (1 second) - set mood to "love"
-                mood = "love";
+                setMood(MOOD_LOVE);
                 Serial.println("Long press detected (1s) - mood set to 'love'");
                 
                 // Trigger sequence selection to start love sequence
                 selectAnimationSequence();
-                message = "";
+                messageClearAll();
                 
                 // Don't reset touch state yet - wait to see if it becomes very long press
             }
@@ -712,7 +1082,7 @@ void loop() {
                     tapTimestamps[0] = 0;
                     tapTimestamps[1] = 0;
                     tapTimestamps[2] = 0;
-                    message = "";
+                    messageClearAll();
                 } else {
                     // Not a triple tap yet - schedule tickle animation after debounce delay
                     // But only if this is the first tap, or enough time has passed since last tap
@@ -750,7 +1120,7 @@ void loop() {
                 playTickleAnimation();
                 playTickleEndAnimation();
                 tickleAnimationPlaying = false;
-                message = "";
+                messageClearAll();
                 // Reset tap tracking after playing tickle
                 tapCount = 0;
                 tapTimestamps[0] = 0;
@@ -760,10 +1130,20 @@ void loop() {
         }
     }
 
-    if (message.length() > 0) {
-        display_text(message.c_str());
+    // Send this pass's replies in as few notifications as possible
+    bleTxFlush();
+
+    // Queued messages take over the screen until the queue drains
+    const char* messageText = messageUpdate();
+    if (messageText != nullptr) {
+        display_text(messageText);
+        messageShowing = true;
         return;
     }
+    if (messageShowing) {
+        messageShowing = false;
+        eyes.rendered = false;  // Idle face must redraw over the last message
+    }
 
     // Handle different modes
     switch (currentMode) {
@@ -773,8 +1153,8 @@ void loop() {
             // If no sequence is selected or sequence is complete, select sequence based on mood (or random)
             if (currentAnimationSequence == nullptr || animationIndex >= currentAnimationSequenceLength) {
                 // If love sequence just completed, reset mood to random
-                if (mood == "love") {
-                    mood = "random";
+                if (mood == MOOD_LOVE) {
+                    setMood(MOOD_RANDOM);
                     Serial.println("Love sequence completed - mood reset to 'random'");
                 }
                 selectAnimationSequence();
@@ -803,11 +1183,16 @@ void loop() {
                 }
                 
                 lastAnimationTime = currentTime;
+            } else if (currentAnimationSequence == idleAnimationSequence) {
+                // Keep the procedural eyes blinking and glancing while we wait
+                updateProceduralEyes();
             }
             break;
         }
         case MODE_WEATHER: {
-            // Weather mode - fetch and display weather
+            // Weather mode - fetch and display weather, with rain or snow
+            // falling over the card depending on the description
+            particlesSetEffect(weatherParticleEffect(currentDescription));
             displayWeatherOnOLED(currentCity, currentTemperature, currentFeelsLike, currentHumidity, currentDescription);
             break;
         }
@@ -824,5 +1209,18 @@ void loop() {
 
             break;
         }
+        case MODE_GRAYSCALE: {
+            // Grayscale showcase - interleave bitplanes at a steady rate
+            grayPresentTick();
+            break;
+        }
+        case MODE_STREAM: {
+            // Remote display - show the phone's frames; back to the
+            // animations once the phone that was streaming goes away
+            if (!streamTick()) {
+                enterMode(MODE_ANIMATION);
+            }
+            break;
+        }
     }    
 }
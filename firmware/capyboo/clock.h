@@ -1,8 +1,9 @@
 #ifndef CLOCK_H
 #define CLOCK_H
 
-#include <time.h>
 #include "display.h"
+#include "timebase.h"
+#include "tokenizer.h"
 
 // Time structure
 struct ClockTime {
@@ -18,37 +19,17 @@ struct ClockTime {
 // Global time variables
 bool timeInitialized = false;
 unsigned long lastTimeUpdate = 0;
-unsigned long timeSetMillis = 0; // When time was set
-time_t timeSetEpoch = 0; // Epoch time when set
-
-const unsigned long TIME_UPDATE_INTERVAL = 1000; // Update display every second
+uint64_t timeSetMillis = 0; // timebaseMillis() when time was set
+int64_t timeSetEpoch = 0; // Epoch time when set
+CalendarTime clockCalendar; // Broken-down time, advanced incrementally
+int32_t timeDriftPpb = 0; // Oscillator correction from SNTP, parts per billion
+uint32_t clockGeneration = 0; // Bumped whenever the clock is set or stepped
 
 // Day names
 const char* DAY_NAMES[] = {"Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"};
 const char* MONTH_NAMES[] = {"", "Jan", "Feb", "Mar", "Apr", "May", "Jun", 
                             "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
 
-// Days in each month (non-leap year)
-const int DAYS_IN_MONTH[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
-
-// Calculate day of week (Zeller's congruence)
-int calculateDayOfWeek(int day, int month, int year) {
-    if (month < 3) {
-        month += 12;
-        year -= 1;
-    }
-    int k = year % 100;
-    int j = year / 100;
-    int h = (day + (13 * (month + 1)) / 5 + k + k / 4 + j / 4 - 2 * j) % 7;
-    // Convert to 0=Sunday, 1=Monday, etc.
-    return ((h + 5) % 7);
-}
-
-// Check if year is leap year
-bool isLeapYear(int year) {
-    return (year % 4 == 0 && year % 100 != 0) || (year % 400 == 0);
-}
-
 // Initialize clock with manual time
 // Format: setTime(hour, minute, second, day, month, year)
 bool setTime(int hour, int minute, int second, int day, int month, int year) {
@@ -61,30 +42,17 @@ bool setTime(int hour, int minute, int second, int day, int month, int year) {
     }
     
     // Validate day for month
-    int maxDays = DAYS_IN_MONTH[month - 1];
-    if (month == 2 && isLeapYear(year)) {
-        maxDays = 29;
-    }
-    if (day > maxDays) {
+    if (day > calendarDaysInMonth(year, month)) {
         Serial.println("Invalid day for month");
         return false;
     }
     
-    // Create tm structure
-    struct tm timeinfo;
-    timeinfo.tm_hour = hour;
-    timeinfo.tm_min = minute;
-    timeinfo.tm_sec = second;
-    timeinfo.tm_mday = day;
-    timeinfo.tm_mon = month - 1; // tm_mon is 0-11
-    timeinfo.tm_year = year - 1900; // tm_year is years since 1900
-    timeinfo.tm_wday = calculateDayOfWeek(day, month, year);
-    timeinfo.tm_isdst = 0; // No daylight saving
-    
-    // Set system time
-    timeSetEpoch = mktime(&timeinfo);
-    timeSetMillis = millis();
+    // Anchor the epoch (no time zone or daylight saving) to the timebase
+    timeSetEpoch = calendarToEpoch(year, month, day, hour, minute, second);
+    timeSetMillis = timebaseMillis();
+    calendarFromEpoch(timeSetEpoch, clockCalendar);
     timeInitialized = true;
+    clockGeneration++;
     
     Serial.print("Time set to: ");
     Serial.print(hour);
@@ -102,52 +70,57 @@ bool setTime(int hour, int minute, int second, int day, int month, int year) {
     return true;
 }
 
-// Set time from string format: "HH:MM:SS DD/MM/YYYY" or "HH:MM:SS"
-bool setTimeFromString(String timeStr) {
-    timeStr.trim();
-    
-    // Try format: "HH:MM:SS DD/MM/YYYY"
-    int timeEnd = timeStr.indexOf(" ");
-    String timePart, datePart;
-    
-    if (timeEnd > 0) {
-        timePart = timeStr.substring(0, timeEnd);
-        datePart = timeStr.substring(timeEnd + 1);
-    } else {
-        // Only time provided, use current date or default
-        timePart = timeStr;
-        datePart = "";
-    }
-    
+// Set time from "HH:MM:SS DD/MM/YYYY" or "HH:MM:SS" (date defaults to
+// 1/1/2024)
+bool setTimeFromText(TextSpan text) {
+    TextSpan rest = spanTrim(text);
+    TextSpan timePart;
+    spanSplit(rest, ' ', timePart);
+    TextSpan datePart = spanTrim(rest);
+
     // Parse time: HH:MM:SS
-    int colon1 = timePart.indexOf(":");
-    int colon2 = timePart.indexOf(":", colon1 + 1);
-    
-    if (colon1 < 0 || colon2 < 0) {
+    long hour, minute, second;
+    if (!spanNextLong(timePart, ':', hour) || !spanNextLong(timePart, ':', minute) ||
+        !spanNextLong(timePart, ':', second) || !spanExhausted(timePart)) {
         Serial.println("Invalid time format. Use HH:MM:SS");
         return false;
     }
-    
-    int hour = timePart.substring(0, colon1).toInt();
-    int minute = timePart.substring(colon1 + 1, colon2).toInt();
-    int second = timePart.substring(colon2 + 1).toInt();
-    
+
     // Parse date: DD/MM/YYYY (optional)
-    int day = 1, month = 1, year = 2024;
-    if (datePart.length() > 0) {
-        int slash1 = datePart.indexOf("/");
-        int slash2 = datePart.indexOf("/", slash1 + 1);
-        
-        if (slash1 > 0 && slash2 > 0) {
-            day = datePart.substring(0, slash1).toInt();
-            month = datePart.substring(slash1 + 1, slash2).toInt();
-            year = datePart.substring(slash2 + 1).toInt();
+    long day = 1, month = 1, year = 2024;
+    if (!spanEmpty(datePart)) {
+        if (!spanNextLong(datePart, '/', day) || !spanNextLong(datePart, '/', month) ||
+            !spanNextLong(datePart, '/', year) || !spanExhausted(datePart)) {
+            Serial.println("Invalid date format. Use DD/MM/YYYY");
+            return false;
         }
     }
-    
+
     return setTime(hour, minute, second, day, month, year);
 }
 
+// Milliseconds since 1970 now, from the 64-bit timebase corrected for
+// the measured oscillator drift (0 until time is set)
+int64_t clockEpochMillis() {
+    if (!timeInitialized) return 0;
+    int64_t elapsed = (int64_t)(timebaseMillis() - timeSetMillis);
+    elapsed += elapsed * timeDriftPpb / 1000000000LL;
+    return timeSetEpoch * 1000 + elapsed;
+}
+
+int64_t clockEpochNow() {
+    return clockEpochMillis() / 1000;
+}
+
+// Re-anchor the clock: it was `epochMillis` (local time, ms since 1970)
+// at timebase `atMillis`. Used by network time sync.
+void clockSync(int64_t epochMillis, uint64_t atMillis) {
+    timeSetEpoch = epochMillis / 1000;
+    timeSetMillis = atMillis - epochMillis % 1000;
+    timeInitialized = true;
+    clockGeneration++;
+}
+
 // Get current time
 ClockTime getCurrentTime() {
     ClockTime clockTime;
@@ -164,20 +137,17 @@ ClockTime getCurrentTime() {
         return clockTime;
     }
     
-    // Calculate elapsed time since time was set
-    unsigned long elapsedMillis = millis() - timeSetMillis;
-    time_t currentEpoch = timeSetEpoch + (elapsedMillis / 1000);
-    
-    // Convert to tm structure
-    struct tm* timeinfo = localtime(&currentEpoch);
+    // Carry the elapsed seconds into the cached date; only a day
+    // rollover does the full conversion
+    calendarAdvance(clockCalendar, clockEpochNow());
     
-    clockTime.hour = timeinfo->tm_hour;
-    clockTime.minute = timeinfo->tm_min;
-    clockTime.second = timeinfo->tm_sec;
-    clockTime.day = timeinfo->tm_mday;
-    clockTime.month = timeinfo->tm_mon + 1; // tm_mon is 0-11
-    clockTime.year = timeinfo->tm_year + 1900; // tm_year is years since 1900
-    clockTime.dayOfWeek = String(DAY_NAMES[timeinfo->tm_wday]);
+    clockTime.hour = clockCalendar.hour;
+    clockTime.minute = clockCalendar.minute;
+    clockTime.second = clockCalendar.second;
+    clockTime.day = clockCalendar.day;
+    clockTime.month = clockCalendar.month;
+    clockTime.year = clockCalendar.year;
+    clockTime.dayOfWeek = String(DAY_NAMES[clockCalendar.weekday]);
     
     return clockTime;
 }
@@ -227,61 +197,365 @@ String formatDate(ClockTime t) {
 }
 
 
-// Display compact clock (smaller format)
+// ---------------------------------------------------------------------------
+// Clock screen with partial redraw.
+//
+// Everything sits on page boundaries: the big time on pages 1-3, seconds on
+// page 5 and the date on page 7. The size-3 digits are rasterized once into
+// a cache in page layout, so drawing one is three memcpy()s. Each tick only
+// the character cells that changed are recomposed and pushed; most seconds
+// that is the two seconds digits, 11 columns of one page.
+
+#define CLOCK_TIME_PAGE    1      // Big time: pages 1-3 (y = 8)
+#define CLOCK_SECONDS_PAGE 5      // y = 40
+#define CLOCK_DATE_PAGE    7      // y = 56
+#define CLOCK_BIG_SIZE     3
+#define CLOCK_BIG_PAGES    3      // 8 font rows * 3
+#define CLOCK_BIG_W        (FONT_5X8_WIDTH * CLOCK_BIG_SIZE)
+#define CLOCK_BIG_ADVANCE  ((FONT_5X8_WIDTH + 1) * CLOCK_BIG_SIZE)
+#define CLOCK_SMALL_ADVANCE (FONT_5X8_WIDTH + 1)
+
+// Big glyphs '0'-'9' and ':' (index 10), page layout
+uint8_t clockBigGlyphs[11][CLOCK_BIG_PAGES][CLOCK_BIG_W];
+bool clockBigGlyphsReady = false;
+
+// What is on the panel now
+char clockShownTime[6] = "";      // "H:MM" or "HH:MM"
+char clockShownSeconds[3] = "";
+char clockShownDate[12] = "";
+uint32_t clockPresentedSerial = 0;
+int64_t clockShownEpoch = -1;
+
+void clockBuildBigGlyphs() {
+    const char glyphs[] = "0123456789:";
+    for (uint8_t g = 0; g < 11; g++) {
+        const uint8_t* bitmap = glyphBitmap(font5x8, glyphs[g]);
+        for (uint8_t col = 0; col < FONT_5X8_WIDTH; col++) {
+            uint32_t bits = glyphScaleColumn(pgm_read_byte(bitmap + col), CLOCK_BIG_SIZE);
+            for (uint8_t i = 0; i < CLOCK_BIG_SIZE; i++) {
+                for (uint8_t page = 0; page < CLOCK_BIG_PAGES; page++) {
+                    clockBigGlyphs[g][page][col * CLOCK_BIG_SIZE + i] = (uint8_t)(bits >> (page * 8));
+                }
+            }
+        }
+    }
+    clockBigGlyphsReady = true;
+}
+
+inline int16_t clockCentredX(uint8_t chars, uint8_t advance, uint8_t width) {
+    return (FB_WIDTH - ((chars - 1) * advance + width)) / 2;
+}
+
+// Bring the big time row up to date. If the length changed (centring moved
+// everything) the row is redrawn, otherwise only cells that differ. Unless
+// `full`, the changed columns are pushed straight away.
+void clockUpdateTimeRow(const char* text, bool full) {
+    uint8_t len = strlen(text);
+    bool relayout = full || strlen(clockShownTime) != len;
+    int16_t x = clockCentredX(len, CLOCK_BIG_ADVANCE, CLOCK_BIG_W);
+    int16_t x0 = FB_WIDTH, x1 = -1;
+    uint8_t* fb = fbBuffer();
+
+    if (relayout) {
+        memset(fb + CLOCK_TIME_PAGE * FB_WIDTH, 0, CLOCK_BIG_PAGES * FB_WIDTH);
+        x0 = 0;
+        x1 = FB_WIDTH - 1;
+    }
+    for (uint8_t i = 0; i < len; i++) {
+        if (!relayout && text[i] == clockShownTime[i]) continue;
+        int16_t cx = x + i * CLOCK_BIG_ADVANCE;
+        uint8_t g = (text[i] == ':') ? 10 : text[i] - '0';
+        for (uint8_t page = 0; page < CLOCK_BIG_PAGES; page++) {
+            memcpy(fb + (CLOCK_TIME_PAGE + page) * FB_WIDTH + cx, clockBigGlyphs[g][page], CLOCK_BIG_W);
+        }
+        if (cx < x0) x0 = cx;
+        if (cx + CLOCK_BIG_W - 1 > x1) x1 = cx + CLOCK_BIG_W - 1;
+    }
+    strcpy(clockShownTime, text);
+
+    if (!full && x1 >= x0) {
+        fbPushPages(fb, CLOCK_TIME_PAGE, CLOCK_TIME_PAGE + CLOCK_BIG_PAGES - 1, x0, x1);
+    }
+}
+
+// Same for a one-page row of small text
+void clockUpdateSmallRow(char* shown, const char* text, uint8_t page, bool full) {
+    uint8_t len = strlen(text);
+    bool relayout = full || strlen(shown) != len;
+    int16_t x = clockCentredX(len, CLOCK_SMALL_ADVANCE, FONT_5X8_WIDTH);
+    int16_t x0 = FB_WIDTH, x1 = -1;
+    uint8_t* row = fbBuffer() + page * FB_WIDTH;
+
+    if (relayout) {
+        memset(row, 0, FB_WIDTH);
+        x0 = 0;
+        x1 = FB_WIDTH - 1;
+    }
+    for (uint8_t i = 0; i < len; i++) {
+        if (!relayout && text[i] == shown[i]) continue;
+        int16_t cx = x + i * CLOCK_SMALL_ADVANCE;
+        memset(row + cx, 0, FONT_5X8_WIDTH);
+        glyphDraw(font5x8, cx, page * 8, (uint8_t)text[i], 1);
+        if (cx < x0) x0 = cx;
+        if (cx + FONT_5X8_WIDTH - 1 > x1) x1 = cx + FONT_5X8_WIDTH - 1;
+    }
+    strcpy(shown, text);
+
+    if (!full && x1 >= x0) {
+        fbPushPages(fbBuffer(), page, page, x0, x1);
+    }
+}
+
+// Draw the clock screen: the whole thing if the panel shows something else
+// (or an overlay is animating), otherwise just the cells that changed
 void displayCompactClock() {
+    if (!clockBigGlyphsReady) clockBuildBigGlyphs();
     ClockTime t = getCurrentTime();
-    
-    display.clearDisplay();
-    display.setTextColor(SH110X_WHITE);
-    
-    // Time (large)
-    String timeStr = formatTime(t, false); // HH:MM without seconds
-    display.setTextSize(3);
-    int16_t x1, y1;
-    uint16_t w, h;
-    display.getTextBounds(timeStr, 0, 0, &x1, &y1, &w, &h);
-    int16_t x = (128 - w) / 2;
-    display.setCursor(x, 10);
-    display.print(timeStr);
-    
-    // Seconds (small, below time)
-    display.setTextSize(1);
-    String secStr = "";
-    if (t.second < 10) secStr += "0";
-    secStr += String(t.second);
-    display.getTextBounds(secStr, 0, 0, &x1, &y1, &w, &h);
-    x = (128 - w) / 2;
-    display.setCursor(x, 40);
-    display.print(secStr);
-    
-    // Date (bottom)
-    String dateStr = formatDate(t);
-    display.getTextBounds(dateStr, 0, 0, &x1, &y1, &w, &h);
-    x = (128 - w) / 2;
-    display.setCursor(x, 52);
-    display.print(dateStr);
-    
-    display.display();
+
+    // 12-hour time without a leading zero, as before
+    int hour12 = t.hour % 12;
+    if (hour12 == 0) hour12 = 12;
+    char timeText[6];
+    char secondsText[3];
+    char dateText[12];
+    snprintf(timeText, sizeof(timeText), "%d:%02d", hour12, t.minute);
+    snprintf(secondsText, sizeof(secondsText), "%02d", t.second);
+    snprintf(dateText, sizeof(dateText), "%02d %s %d", t.day, MONTH_NAMES[t.month], t.year);
+
+    bool full = clockShownTime[0] == '\0' || clockPresentedSerial != fbFrameSerial ||
+                display_overlay_active();
+    if (full) display.clearDisplay();
+    clockUpdateTimeRow(timeText, full);
+    clockUpdateSmallRow(clockShownSeconds, secondsText, CLOCK_SECONDS_PAGE, full);
+    clockUpdateSmallRow(clockShownDate, dateText, CLOCK_DATE_PAGE, full);
+    if (full) display_present();
+    clockPresentedSerial = fbFrameSerial;
 }
 
-// Update clock (call this in loop)
-void updateClock() {
-    // Update display every second
-    static unsigned long lastDisplayUpdate = 0;
-    if (millis() - lastDisplayUpdate >= TIME_UPDATE_INTERVAL) {
-        displayCompactClock();
-        lastDisplayUpdate = millis();
+// ---------------------------------------------------------------------------
+// Analog clock face.
+//
+// The dial (ring and hour ticks) never changes, so it is drawn once into
+// its own page-layout buffer. Hand end points come from a sine table for
+// the 60 positions, generated at compile time, and hands are drawn with
+// Bresenham straight into the framebuffer. When a hand moves, the box
+// covering its old and new positions is restored from the dial, all hands
+// are drawn again and only that box is pushed; most seconds that is just
+// the second hand's sweep.
+
+#define CLOCK_FACE_DIGITAL 0
+#define CLOCK_FACE_ANALOG  1
+
+#define ANALOG_CX          64
+#define ANALOG_CY          32
+#define ANALOG_RADIUS      31
+#define ANALOG_TRIG_SCALE  127
+
+// sin(2*pi*i/60) * 127, with 15 extra entries so cos(i) = sine[i + 15]
+struct AnalogTrig {
+    int8_t sine[75];
+};
+
+constexpr double analogTaylorSin(double x) {
+    double term = x;
+    double sum = x;
+    for (int n = 1; n < 12; n++) {
+        term *= -x * x / ((2 * n) * (2 * n + 1));
+        sum += term;
     }
+    return sum;
 }
 
-// Initialize clock (optional, sets default time)
-bool initClock() {
-    // Set default time if not already set
-    if (!timeInitialized) {
-        // Default: 00:00:00 01/01/2024
-        return setTime(0, 0, 0, 1, 1, 2024);
+constexpr AnalogTrig analogBuildTrig() {
+    AnalogTrig t{};
+    for (int i = 0; i < 75; i++) {
+        double a = 2 * PI * (i % 60) / 60;
+        if (a > PI) a -= 2 * PI;    // Keep the series in its accurate range
+        double v = analogTaylorSin(a) * ANALOG_TRIG_SCALE;
+        t.sine[i] = (int8_t)(v < 0 ? v - 0.5 : v + 0.5);
     }
-    return true;
+    return t;
+}
+
+constexpr AnalogTrig ANALOG_TRIG = analogBuildTrig();
+
+struct AnalogHand {
+    uint8_t length;
+    uint8_t width;      // 1 or 2 pixels
+};
+
+const AnalogHand ANALOG_HANDS[3] = {
+    {15, 2},            // Hour
+    {23, 2},            // Minute
+    {27, 1},            // Second
+};
+
+uint8_t clockFace = CLOCK_FACE_DIGITAL;
+uint8_t analogDial[FB_SIZE];
+bool analogDialReady = false;
+uint8_t analogShownHands[3] = {0xFF, 0xFF, 0xFF};  // Positions 0-59 on the panel
+
+// Point `length` pixels from the centre towards position 0-59
+inline void analogPoint(uint8_t pos, uint8_t length, int16_t& x, int16_t& y) {
+    int16_t s = ANALOG_TRIG.sine[pos];
+    int16_t c = ANALOG_TRIG.sine[pos + 15];
+    x = ANALOG_CX + (s * length + (s >= 0 ? 63 : -63)) / ANALOG_TRIG_SCALE;
+    y = ANALOG_CY - (c * length + (c >= 0 ? 63 : -63)) / ANALOG_TRIG_SCALE;
+}
+
+inline void analogPixel(uint8_t* buf, int16_t x, int16_t y) {
+    if (x < 0 || x >= FB_WIDTH || y < 0 || y >= FB_HEIGHT) return;
+    buf[x + (y >> 3) * FB_WIDTH] |= 1 << (y & 7);
+}
+
+void analogLine(uint8_t* buf, int16_t x0, int16_t y0, int16_t x1, int16_t y1) {
+    int16_t dx = abs(x1 - x0);
+    int16_t dy = -abs(y1 - y0);
+    int8_t sx = x0 < x1 ? 1 : -1;
+    int8_t sy = y0 < y1 ? 1 : -1;
+    int16_t err = dx + dy;
+    while (true) {
+        analogPixel(buf, x0, y0);
+        if (x0 == x1 && y0 == y1) break;
+        int16_t e2 = 2 * err;
+        if (e2 >= dy) { err += dy; x0 += sx; }
+        if (e2 <= dx) { err += dx; y0 += sy; }
+    }
+}
+
+void analogBuildDial() {
+    memset(analogDial, 0, FB_SIZE);
+
+    // Ring (midpoint circle)
+    int16_t x = ANALOG_RADIUS, y = 0, err = 1 - ANALOG_RADIUS;
+    while (x >= y) {
+        analogPixel(analogDial, ANALOG_CX + x, ANALOG_CY + y);
+        analogPixel(analogDial, ANALOG_CX - x, ANALOG_CY + y);
+        analogPixel(analogDial, ANALOG_CX + x, ANALOG_CY - y);
+        analogPixel(analogDial, ANALOG_CX - x, ANALOG_CY - y);
+        analogPixel(analogDial, ANALOG_CX + y, ANALOG_CY + x);
+        analogPixel(analogDial, ANALOG_CX - y, ANALOG_CY + x);
+        analogPixel(analogDial, ANALOG_CX + y, ANALOG_CY - x);
+        analogPixel(analogDial, ANALOG_CX - y, ANALOG_CY - x);
+        y++;
+        if (err < 0) {
+            err += 2 * y + 1;
+        } else {
+            x--;
+            err += 2 * (y - x) + 1;
+        }
+    }
+
+    // Hour ticks, longer at 12, 3, 6 and 9
+    for (uint8_t pos = 0; pos < 60; pos += 5) {
+        int16_t x0, y0, x1, y1;
+        analogPoint(pos, pos % 15 == 0 ? ANALOG_RADIUS - 6 : ANALOG_RADIUS - 4, x0, y0);
+        analogPoint(pos, ANALOG_RADIUS - 2, x1, y1);
+        analogLine(analogDial, x0, y0, x1, y1);
+    }
+    analogDialReady = true;
+}
+
+// Grow the box [x0..x1] x [y0..y1] to cover a hand at `pos` (one pixel
+// extra for thick hands)
+void analogHandBox(uint8_t hand, uint8_t pos, int16_t& x0, int16_t& y0, int16_t& x1, int16_t& y1) {
+    int16_t ex, ey;
+    analogPoint(pos, ANALOG_HANDS[hand].length, ex, ey);
+    x0 = min(x0, min((int16_t)ANALOG_CX, ex));
+    y0 = min(y0, min((int16_t)ANALOG_CY, ey));
+    x1 = max(x1, (int16_t)(max((int16_t)ANALOG_CX, ex) + ANALOG_HANDS[hand].width - 1));
+    y1 = max(y1, (int16_t)(max((int16_t)ANALOG_CY, ey) + ANALOG_HANDS[hand].width - 1));
+}
+
+void analogDrawHand(uint8_t hand, uint8_t pos) {
+    int16_t ex, ey;
+    analogPoint(pos, ANALOG_HANDS[hand].length, ex, ey);
+    uint8_t* fb = fbBuffer();
+    analogLine(fb, ANALOG_CX, ANALOG_CY, ex, ey);
+    if (ANALOG_HANDS[hand].width > 1) {
+        // Thicken along the minor axis
+        if (abs(ey - ANALOG_CY) > abs(ex - ANALOG_CX)) {
+            analogLine(fb, ANALOG_CX + 1, ANALOG_CY, ex + 1, ey);
+        } else {
+            analogLine(fb, ANALOG_CX, ANALOG_CY + 1, ex, ey + 1);
+        }
+    }
+}
+
+// Draw the analog face: the whole screen if the panel shows something
+// else, otherwise restore and push just the area the moving hands cover
+void displayAnalogClock() {
+    if (!analogDialReady) analogBuildDial();
+    ClockTime t = getCurrentTime();
+    uint8_t hands[3] = {
+        (uint8_t)((t.hour % 12) * 5 + t.minute / 12),
+        (uint8_t)t.minute,
+        (uint8_t)t.second,
+    };
+
+    uint8_t* fb = fbBuffer();
+    bool full = analogShownHands[0] == 0xFF || clockPresentedSerial != fbFrameSerial ||
+                display_overlay_active();
+    int16_t x0 = FB_WIDTH, y0 = FB_HEIGHT, x1 = -1, y1 = -1;
+
+    if (full) {
+        memcpy(fb, analogDial, FB_SIZE);
+    } else {
+        // Box around the old and new positions of every hand that moved
+        bool moved = false;
+        for (uint8_t i = 0; i < 3; i++) {
+            if (hands[i] == analogShownHands[i]) continue;
+            analogHandBox(i, analogShownHands[i], x0, y0, x1, y1);
+            analogHandBox(i, hands[i], x0, y0, x1, y1);
+            moved = true;
+        }
+        if (!moved) {
+            clockPresentedSerial = fbFrameSerial;
+            return;
+        }
+        x1 = min(x1, (int16_t)(FB_WIDTH - 1));
+        y1 = min(y1, (int16_t)(FB_HEIGHT - 1));
+        for (uint8_t page = y0 >> 3; page <= (y1 >> 3); page++) {
+            memcpy(fb + page * FB_WIDTH + x0, analogDial + page * FB_WIDTH + x0, x1 - x0 + 1);
+        }
+    }
+
+    // Redraw every hand; those that didn't move land on their own pixels
+    for (uint8_t i = 0; i < 3; i++) {
+        analogDrawHand(i, hands[i]);
+        analogShownHands[i] = hands[i];
+    }
+    fbFillEllipse(ANALOG_CX, ANALOG_CY, 2, 2, true);
+
+    if (full) {
+        display_present();
+    } else {
+        fbPushPages(fb, y0 >> 3, y1 >> 3, x0, x1);
+    }
+    clockPresentedSerial = fbFrameSerial;
+}
+
+// Switch between CLOCK_FACE_DIGITAL and CLOCK_FACE_ANALOG; the next
+// update redraws the whole screen
+void clockSetFace(uint8_t face) {
+    clockFace = face;
+    clockShownTime[0] = '\0';
+    analogShownHands[0] = 0xFF;
+    clockShownEpoch = -1;
+}
+
+// Update clock (call this in loop): redraws when the second changes, or
+// when something else has been on the panel since
+void updateClock() {
+    int64_t now = clockEpochNow();
+    bool stale = clockPresentedSerial != fbFrameSerial || display_overlay_active();
+    if (now == clockShownEpoch && !stale) return;
+    if (clockFace == CLOCK_FACE_ANALOG) {
+        displayAnalogClock();
+    } else {
+        displayCompactClock();
+    }
+    clockShownEpoch = now;
 }
 
 #endif // CLOCK_H
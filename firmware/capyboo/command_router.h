@@ -0,0 +1,222 @@
+#ifndef COMMAND_ROUTER_H
+#define COMMAND_ROUTER_H
+
+#include <Arduino.h>
+#include "bluetooth.h"
+#include "mqtt.h"
+#include "tokenizer.h"
+
+// One command path for every transport.
+//
+// BLE, MQTT (capyboo/commands) and the USB serial console each hand over
+// complete commands as spans over their own receive buffers; loop() takes
+// at most one per source per pass and runs it through the same parser.
+// While a command runs, commandSource says where it came from so that
+// commandReply() answers on the same transport: a BLE notification, a
+// message on capyboo/status, or a line on the serial console. Every
+// connected BLE client is a source of its own, so clients take turns and
+// each hears only its own replies.
+//
+// A command may carry a sequence ID, "#<id> <command>" with id 1-65535,
+// so a client can keep several in flight. Its replies are then prefixed
+// "#<id> ", and whether it succeeded is reported in batches once the
+// source has nothing more queued: "ack:<ids>" and "nack:<ids>", where
+// <ids> is a comma-separated list with consecutive runs written as
+// "first-last" (e.g. "ack:1-3,7"). Commands without an ID get no ack.
+
+enum CommandSource {
+    COMMAND_SOURCE_NONE,        // Not handling a command (timers, touch, ...)
+    COMMAND_SOURCE_MQTT,
+    COMMAND_SOURCE_SERIAL,
+    COMMAND_SOURCE_BLE          // BLE connection 0; connection i is COMMAND_SOURCE_BLE + i
+};
+
+#define COMMAND_SOURCE_FIRST COMMAND_SOURCE_MQTT
+#define COMMAND_SOURCE_LAST  (COMMAND_SOURCE_BLE + BLE_MAX_CONNECTIONS - 1)
+
+uint8_t commandSource = COMMAND_SOURCE_NONE;
+uint16_t commandSequence = 0;           // ID of the command being handled, 0 if none
+
+// Results waiting to be acknowledged, per source
+#define COMMAND_ACK_BATCH 16
+struct CommandAcks {
+    uint16_t ids[COMMAND_ACK_BATCH];
+    bool ok[COMMAND_ACK_BATCH];
+    uint8_t count;
+    uint16_t session;           // BLE client the results belong to
+};
+CommandAcks commandAcks[COMMAND_SOURCE_LAST + 1];
+
+// Serial console: a line at a time, read without blocking
+#define SERIAL_MAX_COMMAND_LENGTH 256
+char serialCommand[SERIAL_MAX_COMMAND_LENGTH + 1];
+uint16_t serialCommandLength = 0;
+bool serialCommandReady = false;
+bool serialCommandOverflow = false;     // Rest of an over-long line is skipped
+
+void serialCommandPoll() {
+    while (!serialCommandReady && Serial.available() > 0) {
+        char c = Serial.read();
+        if (c == '\n' || c == '\r') {
+            if (serialCommandLength > 0 && !serialCommandOverflow) {
+                serialCommand[serialCommandLength] = '\0';
+                serialCommandReady = true;
+            } else {
+                if (serialCommandOverflow) Serial.println("Serial command too long, ignored");
+                serialCommandLength = 0;
+                serialCommandOverflow = false;
+            }
+        } else if (serialCommandLength < SERIAL_MAX_COMMAND_LENGTH) {
+            serialCommand[serialCommandLength++] = c;
+        } else {
+            serialCommandOverflow = true;
+        }
+    }
+}
+
+inline bool commandSourceIsBle(uint8_t source) {
+    return source >= COMMAND_SOURCE_BLE && source <= COMMAND_SOURCE_LAST;
+}
+
+const char* commandSourceName(uint8_t source) {
+    if (commandSourceIsBle(source)) return "BLE";
+    switch (source) {
+        case COMMAND_SOURCE_MQTT: return "MQTT";
+        case COMMAND_SOURCE_SERIAL: return "Serial";
+        default: return "local";
+    }
+}
+
+// Identifies the client behind a source; only BLE sources change hands
+uint16_t commandSourceSession(uint8_t source) {
+    return commandSourceIsBle(source) ? bleConnectionSession(source - COMMAND_SOURCE_BLE) : 0;
+}
+
+// The next command waiting on `source`, left in place until released
+bool commandPeek(uint8_t source, TextSpan& command) {
+    if (commandSourceIsBle(source)) return bleCommandPeek(source - COMMAND_SOURCE_BLE, command);
+    switch (source) {
+        case COMMAND_SOURCE_MQTT:
+            return mqttCommandPeek(command);
+        case COMMAND_SOURCE_SERIAL:
+            serialCommandPoll();
+            if (!serialCommandReady) return false;
+            command = spanOf(serialCommand, serialCommandLength);
+            return true;
+    }
+    return false;
+}
+
+void commandRelease(uint8_t source) {
+    if (commandSourceIsBle(source)) {
+        bleCommandPop(source - COMMAND_SOURCE_BLE);
+        return;
+    }
+    switch (source) {
+        case COMMAND_SOURCE_MQTT:
+            mqttCommandRelease();
+            break;
+        case COMMAND_SOURCE_SERIAL:
+            serialCommandReady = false;
+            serialCommandLength = 0;
+            break;
+    }
+}
+
+// Take a leading "#<id> " off a command. False if there is none or the
+// ID is not a number from 1 to 65535.
+bool commandTakeSequence(TextSpan& command, uint16_t& id) {
+    if (!spanStartsWith(command, "#")) return false;
+    TextSpan rest = command;
+    TextSpan token;
+    spanSplit(rest, ' ', token);
+    long value;
+    if (!spanToLong(spanSkip(token, 1), value) || value < 1 || value > 65535) return false;
+    id = value;
+    command = spanTrim(rest);
+    return true;
+}
+
+// Send a line on the current command's transport; with no command, to
+// every BLE client
+void commandSendReply(const String& text) {
+    if (commandSourceIsBle(commandSource)) {
+        bleSerialPrintlnTo(commandSource - COMMAND_SOURCE_BLE, text);
+        return;
+    }
+    switch (commandSource) {
+        case COMMAND_SOURCE_MQTT:
+            publishStatus(text.c_str());
+            break;
+        case COMMAND_SOURCE_SERIAL:
+            Serial.println(text);
+            break;
+        default:
+            bleSerialPrintln(text);
+            break;
+    }
+}
+
+// Answer the command being handled on the transport it came from.
+// Outside a command (scheduled events and the like) this goes to every
+// BLE client.
+void commandReply(const String& text) {
+    if (commandSequence != 0) {
+        commandSendReply("#" + String(commandSequence) + " " + text);
+    } else {
+        commandSendReply(text);
+    }
+}
+
+// "ack:" or "nack:" line for the batched results with ok == `ok`
+String commandAckLine(const CommandAcks& acks, bool ok) {
+    String line = ok ? "ack:" : "nack:";
+    bool any = false;
+    for (uint8_t i = 0; i < acks.count; i++) {
+        if (acks.ok[i] != ok) continue;
+        // Extend a run of consecutive IDs as far as it goes
+        uint8_t last = i;
+        while (last + 1 < acks.count && acks.ok[last + 1] == ok && acks.ids[last + 1] == acks.ids[last] + 1) {
+            last++;
+        }
+        if (any) line += ",";
+        line += String(acks.ids[i]);
+        if (last > i) line += "-" + String(acks.ids[last]);
+        any = true;
+        i = last;
+    }
+    return any ? line : String("");
+}
+
+// Send whatever results `source` has collected
+void commandFlushAcks(uint8_t source) {
+    CommandAcks& acks = commandAcks[source];
+    if (acks.count == 0) return;
+    if (acks.session != commandSourceSession(source)) {
+        // The client these were for has disconnected
+        acks.count = 0;
+        return;
+    }
+
+    uint8_t previous = commandSource;
+    commandSource = source;
+    String line = commandAckLine(acks, true);
+    if (line.length() > 0) commandSendReply(line);
+    line = commandAckLine(acks, false);
+    if (line.length() > 0) commandSendReply(line);
+    commandSource = previous;
+    acks.count = 0;
+}
+
+void commandAcknowledge(uint8_t source, uint16_t id, bool ok) {
+    CommandAcks& acks = commandAcks[source];
+    if (acks.count == COMMAND_ACK_BATCH || acks.session != commandSourceSession(source)) {
+        commandFlushAcks(source);
+    }
+    acks.session = commandSourceSession(source);
+    acks.ids[acks.count] = id;
+    acks.ok[acks.count] = ok;
+    acks.count++;
+}
+
+#endif // COMMAND_ROUTER_H
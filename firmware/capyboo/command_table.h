@@ -0,0 +1,92 @@
+#ifndef COMMAND_TABLE_H
+#define COMMAND_TABLE_H
+
+#include <Arduino.h>
+
+// Perfect-hash lookup tables built at compile time.
+//
+// A table is a constexpr array of entries with a lowercase `name` member
+// (command verbs, mood names, ...). perfectHashBuild() searches for a seed that
+// sends every name to its own slot, so a lookup is one case-insensitive
+// hash, one slot read and one compare - the same cost for the first name
+// as for the last, and adding names does not slow the others down. If no
+// seed works the static_assert next to the table fails the build.
+
+#define PERFECT_HASH_MAX_SEED 100000
+
+inline constexpr char perfectHashLower(char c) {
+    return (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+}
+
+// FNV-1a over the lowercased bytes, with the seed folded into the basis
+inline constexpr uint32_t perfectHash(const char* key, size_t length, uint32_t seed) {
+    uint32_t hash = 2166136261u ^ (seed * 0x9E3779B9u);
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (uint8_t)perfectHashLower(key[i]);
+        hash *= 16777619u;
+    }
+    return hash ^ (hash >> 15);
+}
+
+inline constexpr size_t perfectHashLength(const char* s) {
+    size_t length = 0;
+    while (s[length] != '\0') length++;
+    return length;
+}
+
+// SLOTS must be a power of two; each slot holds an entry index + 1, or 0
+template <size_t SLOTS>
+struct PerfectHashIndex {
+    static_assert((SLOTS & (SLOTS - 1)) == 0, "slot count must be a power of two");
+    uint32_t seed;          // 0 if no collision-free seed was found
+    uint8_t slots[SLOTS];
+};
+
+template <size_t SLOTS, typename Entry, size_t N>
+constexpr PerfectHashIndex<SLOTS> perfectHashBuild(const Entry (&entries)[N]) {
+    static_assert(N < SLOTS && N < 255, "table needs more slots");
+    for (uint32_t seed = 1; seed < PERFECT_HASH_MAX_SEED; seed++) {
+        PerfectHashIndex<SLOTS> index{};
+        bool collision = false;
+        for (size_t i = 0; i < N && !collision; i++) {
+            const char* name = entries[i].name;
+            uint32_t slot = perfectHash(name, perfectHashLength(name), seed) & (SLOTS - 1);
+            if (index.slots[slot] != 0) {
+                collision = true;
+            } else {
+                index.slots[slot] = i + 1;
+            }
+        }
+        if (!collision) {
+            index.seed = seed;
+            return index;
+        }
+    }
+    return PerfectHashIndex<SLOTS>{};
+}
+
+// True if entry i's `id` member is i throughout, for tables indexed by an
+// enum: static_assert(tableInOrder(TABLE, &Entry::id))
+template <typename Entry, typename Id, size_t N>
+constexpr bool tableInOrder(const Entry (&entries)[N], Id Entry::*id) {
+    for (size_t i = 0; i < N; i++) {
+        if ((size_t)(entries[i].*id) != i) return false;
+    }
+    return true;
+}
+
+// Index of the entry named key[0..length) (any case), or -1
+template <size_t SLOTS, typename Entry, size_t N>
+int perfectHashFind(const PerfectHashIndex<SLOTS>& index, const Entry (&entries)[N],
+                    const char* key, size_t length) {
+    uint8_t slot = index.slots[perfectHash(key, length, index.seed) & (SLOTS - 1)];
+    if (slot == 0) return -1;
+
+    const char* name = entries[slot - 1].name;
+    for (size_t i = 0; i < length; i++) {
+        if (name[i] == '\0' || perfectHashLower(key[i]) != name[i]) return -1;
+    }
+    return name[length] == '\0' ? slot - 1 : -1;
+}
+
+#endif // COMMAND_TABLE_H
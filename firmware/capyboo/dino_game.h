@@ -219,7 +219,7 @@ void drawGame() {
         display.print(score);
     }
     
-    display.display();
+    display_present();
 }
 
 // Main game loop function
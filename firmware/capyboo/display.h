@@ -7,99 +7,90 @@
 // Display object (shared across headers) - define it here
 Adafruit_SH1106G display(128,64,&Wire,-1);
 
+#include "framebuffer.h"
+#include "particles.h"
+#include "transition.h"
+#include "text_layout.h"
+#include "marquee.h"
+
+// Crossfade state: a snapshot of the outgoing screen that gets dithered
+// into the next few presented frames
+uint32_t crossfadeFrom[FB_SIZE / 4];
+uint8_t crossfadeFrames = 0;   // Length of the running crossfade, 0 = none
+uint8_t crossfadeFrame = 0;    // Frames presented so far
+
+// Start blending from whatever is on screen now into the next `frames`
+// frames presented through display_present()
+void display_begin_crossfade(uint8_t frames) {
+    memcpy(crossfadeFrom, fbBuffer(), FB_SIZE);
+    crossfadeFrames = frames;
+    crossfadeFrame = 0;
+}
+
+// Push the framebuffer to the panel, drawing the particle overlay and
+// applying any running crossfade. During a mode transition the frame is
+// handed to the transition engine instead.
+void display_present() {
+    particlesOverlay();
+    if (crossfadeFrame < crossfadeFrames) {
+        crossfadeFrame++;
+        uint8_t level = (uint16_t)crossfadeFrame * 16 / (crossfadeFrames + 1);
+        fbDitherBlend(fbBuffer(), (const uint8_t*)crossfadeFrom, level);
+    }
+    if (transitionCapture()) return;
+    fbFrameSerial++;
+    display.display();
+}
+
+// True while something animates on top of whatever is presented, so a
+// static screen still needs presenting every frame
+bool display_overlay_active() {
+    return particleEffect != EFFECT_NONE || particles.count > 0 ||
+           crossfadeFrame < crossfadeFrames || transitionActive();
+}
 
 void display_bitmap(const unsigned char* frame) {
     display.clearDisplay();
     display.drawBitmap(0, 0, frame, 128, 64, SH110X_WHITE);
-    display.display();
+    display_present();
 }
 
+// Show a message, word-wrapped at the largest text size that fits, or as a
+// scrolling marquee when it doesn't fit even at size 1. Cheap to call every
+// loop: the layout and rendered frame are cached per text, and nothing is
+// redrawn or pushed while the panel already shows it.
 void display_text(const char* text) {
-    display.clearDisplay();
-    display.setTextColor(SH110X_WHITE);
-    display.setTextSize(1);
-    
-    // Calculate how many characters fit per line (128 pixels / ~6 pixels per char)
-    const int charsPerLine = 21;  // Approximately 21 characters per line at size 1
-    const int maxLines = 8;        // Maximum lines that fit (64 pixels / 8 pixels per line)
-    
-    String textStr = String(text);
-    int textLen = textStr.length();
-    
-    // If text fits on one line, center it
-    if (textLen <= charsPerLine) {
-        int16_t x1, y1;
-        uint16_t w, h;
-        display.getTextBounds(text, 0, 0, &x1, &y1, &w, &h);
-        int16_t x = (128 - w) / 2;
-        int16_t y = (64 - h) / 2;
-        display.setCursor(x, y);
-        display.println(text);
-    } else {
-        // Text is too long - wrap to multiple lines with word boundary awareness
-        int line = 0;
-        int pos = 0;
-        bool textTruncated = false;
-        
-        while (pos < textLen && line < maxLines) {
-            int remainingChars = textLen - pos;
-            int lineEndPos;
-            
-            if (remainingChars <= charsPerLine) {
-                // Remaining text fits on one line
-                lineEndPos = textLen;
-            } else {
-                // Find the best break point (prefer space, but break at char limit if needed)
-                lineEndPos = pos + charsPerLine;
-                
-                // Look for a space before the character limit (prefer word boundary)
-                int spacePos = textStr.lastIndexOf(' ', lineEndPos);
-                if (spacePos > pos) {
-                    // Found a space - break there
-                    lineEndPos = spacePos;
-                }
-                // If no space found or word is too long, break at character limit
-            }
-            
-            // Check if this is the last line and text will be truncated
-            if (line == maxLines - 1 && lineEndPos < textLen) {
-                // Last line - make room for ellipsis
-                if (lineEndPos - pos > charsPerLine - 3) {
-                    lineEndPos = pos + charsPerLine - 3;
-                }
-                textTruncated = true;
-            }
-            
-            // Extract line text
-            String lineText = textStr.substring(pos, lineEndPos);
-            
-            // Display line (left-aligned for multi-line)
-            display.setCursor(0, line * 8);  // 8 pixels per line at size 1
-            display.print(lineText);
-            
-            // Add ellipsis if text was truncated
-            if (textTruncated && line == maxLines - 1) {
-                display.print("...");
-            } else {
-                display.println(); // Move to next line
-            }
-            
-            // Move to next position (skip space if we broke at a word boundary)
-            pos = lineEndPos;
-            if (pos < textLen && textStr.charAt(pos) == ' ') {
-                pos++; // Skip the space at the start of next line
-            }
-            
-            line++;
-            
-            // Stop if we've displayed all text or reached max lines
-            if (pos >= textLen || line >= maxLines) {
-                break;
-            }
+    uint16_t length;
+    uint32_t hash = textHash(text, length);
+    bool cached = textCache.valid && textCache.hash == hash && textCache.length == length;
+    // Something else reached the panel since our last push, or is animating
+    // over us: present the whole screen rather than just what changed
+    bool full = !cached || textCache.presentedSerial != fbFrameSerial || display_overlay_active();
+
+    if (!cached) {
+        textLayoutFit(textCache.layout, text, length);
+        textCache.marquee = textCache.layout.truncated;
+        if (textCache.marquee) {
+            marqueeBegin(text, length);
+        } else {
+            textLayoutRender(textCache.layout, text);
+            memcpy(textCache.frame, fbBuffer(), FB_SIZE);
         }
+        textCache.hash = hash;
+        textCache.length = length;
+        textCache.valid = true;
     }
-    
-    display.display();
+
+    if (textCache.marquee) {
+        if (!marqueeUpdate(full)) return;
+        if (full) display_present();
+        else marqueePush();
+    } else {
+        if (!full) return;
+        if (cached) memcpy(fbBuffer(), textCache.frame, FB_SIZE);
+        display_present();
+    }
+    textCache.presentedSerial = fbFrameSerial;
 }
 
 #endif // DISPLAY_H
\ No newline at end of file
@@ -0,0 +1,262 @@
+#ifndef EYE_RENDERER_H
+#define EYE_RENDERER_H
+
+#include "display.h"
+#include "tween.h"
+
+// Procedural eyes: the idle face (two rounded eyes plus the capybara
+// nose/mouth) drawn from a handful of parameters instead of stored frames.
+// Gaze, blinking and wake-up are tweens on those parameters, so they cost
+// no flash and run at whatever rate the display can take.
+
+// Neutral face geometry, measured from the original look/wakeup artwork
+#define EYE_LEFT_CX     33
+#define EYE_RIGHT_CX    96
+#define EYE_CY          31
+#define EYE_W           25
+#define EYE_H           37
+#define EYE_RADIUS      10
+#define EYE_CLOSED_H    6    // Height of a closed eye (a flat pill)
+
+// How far features travel / compress at full gaze (gazeX = +-256).
+// The eye on the far side of the gaze swings further than the near one,
+// which gives the head-turn look of the old look_right/look_left frames.
+#define EYE_FAR_SHIFT    36
+#define EYE_NEAR_SHIFT   16
+#define EYE_FAR_SHRINK   6
+#define EYE_NEAR_SHRINK  7
+#define EYE_GAZE_Y_SHIFT 6
+#define MOUTH_SHIFT      27
+#define MOUTH_SHRINK     13
+#define MOUTH_GAZE_Y_SHIFT 4
+
+#define EYE_FRAME_INTERVAL 16 // ms, caps procedural redraws at ~60 fps
+
+// Nose and mouth, 26x16 px, column-major page layout, top-left at (51, 40)
+#define MOUTH_X 51
+#define MOUTH_Y 40
+#define MOUTH_W 26
+const unsigned char mouth_sprite[] PROGMEM = {
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x80, 0xfe,
+    0xfe, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x1c, 0x1c, 0x18, 0x38, 0x38, 0x30, 0x30, 0x18, 0x18, 0x1c, 0x0e, 0x0f, 0x07,
+    0x03, 0x0f, 0x0e, 0x1c, 0x18, 0x38, 0x30, 0x30, 0x38, 0x38, 0x18, 0x1c, 0x1c
+};
+
+// Parameters for one rendered face
+struct EyeParams {
+    int16_t gazeX;     // -256 (full left) .. 256 (full right)
+    int16_t gazeY;     // -256 (up) .. 256 (down)
+    int16_t openness;  // 0 = closed .. 256 = fully open
+    int16_t squash;    // Q8: >0 wider and flatter, <0 taller and narrower
+    int16_t pupilX;    // Pupil offset from eye centre, pixels
+    int16_t pupilY;
+    int16_t pupilSize; // Pupil radius in pixels, 0 = no pupil (default art)
+};
+
+// Draw one eye into the framebuffer
+void drawEye(int16_t cx, int16_t w, const EyeParams& p) {
+    int16_t h = EYE_CLOSED_H + (int16_t)(((int32_t)(EYE_H - EYE_CLOSED_H) * p.openness) >> 8);
+    w = (int16_t)(((int32_t)w * (256 + p.squash)) >> 8);
+    h = (int16_t)(((int32_t)h * (256 - p.squash)) >> 8);
+    if (w < 2) w = 2;
+    if (h < 2) h = 2;
+
+    int16_t cy = EYE_CY + (int16_t)(((int32_t)p.gazeY * EYE_GAZE_Y_SHIFT) >> 8);
+    fbFillRoundRect(cx - w / 2, cy - h / 2, w, h, EYE_RADIUS, true);
+
+    if (p.pupilSize > 0 && h > p.pupilSize * 2) {
+        fbFillEllipse(cx + p.pupilX, cy + p.pupilY, p.pupilSize, p.pupilSize, false);
+    }
+}
+
+// Draw the whole face into the framebuffer (no clear, no push)
+void drawEyes(const EyeParams& p) {
+    int16_t g = constrain(p.gazeX, -256, 256);
+    int16_t ag = abs(g);
+
+    // Far eye is the one opposite the gaze direction
+    bool leftIsFar = g > 0;
+    int16_t leftShift  = (int16_t)(((int32_t)g * (leftIsFar ? EYE_FAR_SHIFT : EYE_NEAR_SHIFT)) >> 8);
+    int16_t rightShift = (int16_t)(((int32_t)g * (leftIsFar ? EYE_NEAR_SHIFT : EYE_FAR_SHIFT)) >> 8);
+    int16_t leftW  = EYE_W - (int16_t)(((int32_t)ag * (leftIsFar ? EYE_FAR_SHRINK : EYE_NEAR_SHRINK)) >> 8);
+    int16_t rightW = EYE_W - (int16_t)(((int32_t)ag * (leftIsFar ? EYE_NEAR_SHRINK : EYE_FAR_SHRINK)) >> 8);
+
+    drawEye(EYE_LEFT_CX + leftShift, leftW, p);
+    drawEye(EYE_RIGHT_CX + rightShift, rightW, p);
+
+    // Mouth follows the gaze and narrows as the head turns
+    uint8_t mouthW = MOUTH_W - (uint8_t)(((int32_t)ag * MOUTH_SHRINK) >> 8);
+    int16_t mouthCx = MOUTH_X + MOUTH_W / 2 + (int16_t)(((int32_t)g * MOUTH_SHIFT) >> 8);
+    int16_t mouthY = MOUTH_Y + (int16_t)(((int32_t)p.gazeY * MOUTH_GAZE_Y_SHIFT) >> 8);
+    fbBlitColumns(mouthCx - mouthW / 2, mouthY, mouth_sprite, MOUTH_W, 2, mouthW, FB_BLIT_OR);
+}
+
+// Render a face to the display
+void renderEyes(const EyeParams& p) {
+    display.clearDisplay();
+    drawEyes(p);
+    display_present();
+}
+
+// ---------------------------------------------------------------------------
+// Eye animator: tweens for every parameter plus autonomous blinking and
+// small idle glances.
+
+struct EyeAnimator {
+    Tween gazeX;
+    Tween gazeY;
+    Tween openness;
+    Tween squash;
+    Tween pupilX;
+    Tween pupilY;
+    int16_t pupilSize;
+
+    int16_t baseGazeX;          // Where we were told to look; glances wander around it
+    int16_t baseGazeY;
+    uint8_t blinkStage;         // 0 = idle, 1 = closing, 2 = opening
+    unsigned long nextBlink;
+    unsigned long nextGlance;
+    unsigned long lastFrame;
+
+    EyeParams lastRendered;
+    bool rendered;
+};
+
+EyeAnimator eyes;
+
+void eyesReset(int16_t openness = 256) {
+    tweenSet(eyes.gazeX, 0);
+    tweenSet(eyes.gazeY, 0);
+    tweenSet(eyes.openness, openness);
+    tweenSet(eyes.squash, 0);
+    tweenSet(eyes.pupilX, 0);
+    tweenSet(eyes.pupilY, 0);
+    eyes.pupilSize = 0;
+    eyes.baseGazeX = 0;
+    eyes.baseGazeY = 0;
+    eyes.blinkStage = 0;
+    eyes.nextBlink = millis() + random(2000, 5000);
+    eyes.nextGlance = millis() + random(1500, 4000);
+    eyes.rendered = false;
+}
+
+// Look somewhere (gaze in -256..256) over `ms` milliseconds
+void eyesLookAt(int16_t gx, int16_t gy, uint16_t ms) {
+    unsigned long now = millis();
+    eyes.baseGazeX = gx;
+    eyes.baseGazeY = gy;
+    tweenTo(eyes.gazeX, gx, ms, TWEEN_EASE_IN_OUT, now);
+    tweenTo(eyes.gazeY, gy, ms, TWEEN_EASE_IN_OUT, now);
+    eyes.nextGlance = now + ms + random(1500, 4000);
+}
+
+void eyesBlink() {
+    if (eyes.blinkStage == 0) {
+        tweenTo(eyes.openness, 0, 70, TWEEN_EASE_IN, millis());
+        eyes.blinkStage = 1;
+    }
+}
+
+bool eyesAnimating() {
+    unsigned long now = millis();
+    return eyes.blinkStage != 0 ||
+           !tweenDone(eyes.gazeX, now) || !tweenDone(eyes.gazeY, now) ||
+           !tweenDone(eyes.openness, now) || !tweenDone(eyes.squash, now) ||
+           !tweenDone(eyes.pupilX, now) || !tweenDone(eyes.pupilY, now);
+}
+
+// Advance blink/glance behaviour and redraw if anything moved.
+// Non-blocking: call as often as you like.
+void updateProceduralEyes() {
+    unsigned long now = millis();
+    if (eyes.rendered && now - eyes.lastFrame < EYE_FRAME_INTERVAL) {
+        return;
+    }
+
+    // Blink state machine
+    if (eyes.blinkStage == 1 && tweenDone(eyes.openness, now)) {
+        tweenTo(eyes.openness, 256, 110, TWEEN_EASE_OUT, now);
+        eyes.blinkStage = 2;
+    } else if (eyes.blinkStage == 2 && tweenDone(eyes.openness, now)) {
+        eyes.blinkStage = 0;
+        // Occasionally blink twice in quick succession
+        eyes.nextBlink = now + (random(0, 100) < 15 ? 150 : random(2000, 6000));
+    } else if (eyes.blinkStage == 0 && eyes.openness.to == 256 &&
+               tweenDone(eyes.openness, now) && (long)(now - eyes.nextBlink) >= 0) {
+        eyesBlink();
+    }
+
+    // Small glances around the commanded gaze
+    if ((long)(now - eyes.nextGlance) >= 0 && tweenDone(eyes.gazeX, now)) {
+        int16_t gx = constrain(eyes.baseGazeX + random(-40, 41), -256, 256);
+        int16_t gy = constrain(eyes.baseGazeY + random(-60, 61), -256, 256);
+        tweenTo(eyes.gazeX, gx, 120, TWEEN_EASE_OUT, now);
+        tweenTo(eyes.gazeY, gy, 120, TWEEN_EASE_OUT, now);
+        eyes.nextGlance = now + random(1500, 4000);
+    }
+
+    EyeParams p;
+    p.gazeX = tweenValue(eyes.gazeX, now);
+    p.gazeY = tweenValue(eyes.gazeY, now);
+    p.openness = tweenValue(eyes.openness, now);
+    p.squash = tweenValue(eyes.squash, now);
+    p.pupilX = tweenValue(eyes.pupilX, now);
+    p.pupilY = tweenValue(eyes.pupilY, now);
+    p.pupilSize = eyes.pupilSize;
+
+    if (eyes.rendered && memcmp(&p, &eyes.lastRendered, sizeof(p)) == 0) {
+        return;
+    }
+    renderEyes(p);
+    eyes.lastRendered = p;
+    eyes.rendered = true;
+    eyes.lastFrame = now;
+}
+
+// Run the animator until all tweens settle (for use in animation sequences)
+void runEyesUntilSettled() {
+    updateProceduralEyes();
+    while (eyesAnimating()) {
+        updateProceduralEyes();
+        delay(1);
+    }
+    updateProceduralEyes();
+}
+
+// ---------------------------------------------------------------------------
+// Sequence-friendly animations (same shape as the play*Animation functions
+// in face_animation.h)
+
+void playEyesWakeupAnimation() {
+    eyesReset(0);
+    unsigned long now = millis();
+    tweenTo(eyes.openness, 96, 250, TWEEN_EASE_OUT, now);
+    runEyesUntilSettled();
+    tweenTo(eyes.openness, 0, 150, TWEEN_EASE_IN, millis());
+    runEyesUntilSettled();
+    tweenTo(eyes.openness, 256, 350, TWEEN_BACK_OUT, millis());
+    runEyesUntilSettled();
+}
+
+void playEyesLookRightAnimation() {
+    eyesLookAt(256, 0, 220);
+    runEyesUntilSettled();
+}
+
+void playEyesLookLeftAnimation() {
+    eyesLookAt(-256, 0, 220);
+    runEyesUntilSettled();
+}
+
+void playEyesLookMiddleAnimation() {
+    eyesLookAt(0, 0, 200);
+    runEyesUntilSettled();
+}
+
+void playEyesBlinkAnimation() {
+    eyesBlink();
+    runEyesUntilSettled();
+}
+
+#endif // EYE_RENDERER_H
@@ -6,138 +6,6 @@
 extern Adafruit_SH1106G display;
 int current_frame = 0;
 
-void playWakeupAnimation() {
-	 static const int wakeup_bitmap_allArray_LEN = 25;
-	 static const unsigned char* wakeup_bitmap_allArray[25] = {
-		 wakeup_bitmap_00,
-		 wakeup_bitmap_01,
-		 wakeup_bitmap_02,
-		 wakeup_bitmap_03,
-		 wakeup_bitmap_04,
-		 wakeup_bitmap_05,
-		 wakeup_bitmap_06,
-		 wakeup_bitmap_07,
-		 wakeup_bitmap_08,
-		 wakeup_bitmap_09,
-		 wakeup_bitmap_10,
-		 wakeup_bitmap_11,
-		 wakeup_bitmap_12,
-		 wakeup_bitmap_13,
-		 wakeup_bitmap_14,
-		 wakeup_bitmap_15,
-		 wakeup_bitmap_16,
-		 wakeup_bitmap_17,
-		 wakeup_bitmap_18,
-		 wakeup_bitmap_19,
-		 wakeup_bitmap_20,
-		 wakeup_bitmap_21,
-		 wakeup_bitmap_22,
-		 wakeup_bitmap_23,
-		 wakeup_bitmap_24
-	 };
-
-
-	 for (int i = 0; i < wakeup_bitmap_allArray_LEN; i++) {
-        display_bitmap(wakeup_bitmap_allArray[i]);
-		
-		delay(20);
-    }
-}
-
-
-
-
-
-void playLookRightFromMiddleAnimation() {
-	// Array of all bitmaps for convenience. (Total bytes used to store images in PROGMEM = 26000)
-	const int look_right_from_middle_bitmap_allArray_LEN = 9;
-	const unsigned char* look_right_from_middle_bitmap_allArray[9] = {
-		look_right_from_middle_bitmap_00,
-		look_right_from_middle_bitmap_01,
-		look_right_from_middle_bitmap_02,
-		look_right_from_middle_bitmap_03,
-		look_right_from_middle_bitmap_04,
-		look_right_from_middle_bitmap_05,
-		look_right_from_middle_bitmap_06,
-		look_right_from_middle_bitmap_07,
-		look_right_from_middle_bitmap_08,
-	};
-
-	for (int i = 0; i < look_right_from_middle_bitmap_allArray_LEN; i++) {
-	   display_bitmap(look_right_from_middle_bitmap_allArray[i]);
-	   delay(20);
-   }
-}
-
-
-void playLookMiddleFromRightAnimation() {
-	// Array of all bitmaps for convenience. (Total bytes used to store images in PROGMEM = 26000)
-	const int look_middle_from_right_bitmap_allArray_LEN = 8;
-	const unsigned char* look_middle_from_right_bitmap_allArray[8] = {
-		look_middle_from_right_bitmap_00,
-		look_middle_from_right_bitmap_01,
-		look_middle_from_right_bitmap_02,
-		look_middle_from_right_bitmap_03,
-		look_middle_from_right_bitmap_04,
-		look_middle_from_right_bitmap_05,
-		look_middle_from_right_bitmap_06,
-		look_middle_from_right_bitmap_07,
-	};
-
-	for (int i = 0; i < look_middle_from_right_bitmap_allArray_LEN; i++) {
-	   display_bitmap(look_middle_from_right_bitmap_allArray[i]);
-	   delay(20);
-   }
-}
-
-void playLookLeftFromMiddleAnimation() {
-	// Array of all bitmaps for convenience. (Total bytes used to store images in PROGMEM = 26000)
-	const int look_left_from_middle_bitmap_allArray_LEN = 9;
-	const unsigned char* look_left_from_middle_bitmap_allArray[9] = {
-		look_left_from_middle_bitmap_00,
-		look_left_from_middle_bitmap_01,
-		look_left_from_middle_bitmap_02,
-		look_left_from_middle_bitmap_03,
-		look_left_from_middle_bitmap_04,
-		look_left_from_middle_bitmap_05,
-		look_left_from_middle_bitmap_06,
-		look_left_from_middle_bitmap_07,
-		look_left_from_middle_bitmap_08,
-	};
-
-	for (int i = 0; i < look_left_from_middle_bitmap_allArray_LEN; i++) {
-	   display_bitmap(look_left_from_middle_bitmap_allArray[i]);
-	   delay(20);
-   }
-}
-
-
-
-
-
-void playLookMiddleFromLeftAnimation() {
-	// Array of all bitmaps for convenience. (Total bytes used to store images in PROGMEM = 26000)
-	const int look_middle_from_left_bitmap_allArray_LEN = 8;
-	const unsigned char* look_middle_from_left_bitmap_allArray[8] = {
-		look_middle_from_left_bitmap_00,
-		look_middle_from_left_bitmap_01,
-		look_middle_from_left_bitmap_02,
-		look_middle_from_left_bitmap_03,
-		look_middle_from_left_bitmap_04,
-		look_middle_from_left_bitmap_05,
-		look_middle_from_left_bitmap_06,
-		look_middle_from_left_bitmap_07
-	};
-
-	for (int i = 0; i < look_middle_from_left_bitmap_allArray_LEN; i++) {
-	   display_bitmap(look_middle_from_left_bitmap_allArray[i]);
-	   delay(20);
-   }
-}
-
-
-
-
 void playNormalToFunnyEyesAnimation() {
 	// Array of all bitmaps for convenience. (Total bytes used to store images in PROGMEM = 26000)
 	const int funny_eyes_bitmap_allArray_LEN = 6;
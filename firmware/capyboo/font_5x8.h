@@ -0,0 +1,303 @@
+#ifndef FONT_5X8_H
+#define FONT_5X8_H
+
+#include "glyph_atlas.h"
+
+// 5x8 text font (the classic 5x7 LCD shapes, descenders in row 7) with
+// Latin-1, the Latin Extended-A letters common in European place names,
+// typographic punctuation and a replacement box.
+//
+// Accented letters are composed at compile time from a base letter and an
+// entry in FONT_5X8_ACCENTS. FONT_5X8_SUBSET lists the code point ranges
+// that get baked into the atlas; everything else in the source table is
+// dropped at build time. Add ranges (and source glyphs) here to support
+// more text.
+
+#define FONT_5X8_WIDTH 5
+
+enum FontAccent {
+    ACCENT_NONE,
+    ACCENT_GRAVE,
+    ACCENT_ACUTE,
+    ACCENT_CIRCUMFLEX,
+    ACCENT_TILDE,
+    ACCENT_DIAERESIS,
+    ACCENT_RING,
+    ACCENT_CARON,
+    ACCENT_DOT,
+    ACCENT_DOUBLE_ACUTE,
+    ACCENT_CEDILLA,
+    ACCENT_OGONEK
+};
+
+// Indexed by FontAccent; rows 0-1 sit above lowercase letters, row 7 below
+constexpr uint8_t FONT_5X8_ACCENTS[][GLYPH_MAX_WIDTH] = {
+    {0x00, 0x00, 0x00, 0x00, 0x00},  // none
+    {0x00, 0x01, 0x02, 0x00, 0x00},  // grave
+    {0x00, 0x00, 0x02, 0x01, 0x00},  // acute
+    {0x00, 0x02, 0x01, 0x02, 0x00},  // circumflex
+    {0x00, 0x02, 0x01, 0x02, 0x01},  // tilde
+    {0x00, 0x01, 0x00, 0x01, 0x00},  // diaeresis
+    {0x00, 0x02, 0x05, 0x02, 0x00},  // ring
+    {0x00, 0x01, 0x02, 0x01, 0x00},  // caron
+    {0x00, 0x00, 0x01, 0x00, 0x00},  // dot
+    {0x00, 0x02, 0x01, 0x02, 0x01},  // double acute
+    {0x00, 0x00, 0x80, 0x80, 0x00},  // cedilla
+    {0x00, 0x00, 0x00, 0x80, 0x80}   // ogonek
+};
+
+// Source glyphs, sorted by code point
+constexpr GlyphSource FONT_5X8_SOURCES[] = {
+    {0x0020, 0, 0, {0x00, 0x00, 0x00, 0x00, 0x00}},  // space
+    {0x0021, 0, 0, {0x00, 0x00, 0x5F, 0x00, 0x00}},  // !
+    {0x0022, 0, 0, {0x00, 0x07, 0x00, 0x07, 0x00}},  // "
+    {0x0023, 0, 0, {0x14, 0x7F, 0x14, 0x7F, 0x14}},  // #
+    {0x0024, 0, 0, {0x24, 0x2A, 0x7F, 0x2A, 0x12}},  // $
+    {0x0025, 0, 0, {0x23, 0x13, 0x08, 0x64, 0x62}},  // %
+    {0x0026, 0, 0, {0x36, 0x49, 0x56, 0x20, 0x50}},  // &
+    {0x0027, 0, 0, {0x00, 0x08, 0x07, 0x03, 0x00}},  // '
+    {0x0028, 0, 0, {0x00, 0x1C, 0x22, 0x41, 0x00}},  // (
+    {0x0029, 0, 0, {0x00, 0x41, 0x22, 0x1C, 0x00}},  // )
+    {0x002A, 0, 0, {0x2A, 0x1C, 0x7F, 0x1C, 0x2A}},  // *
+    {0x002B, 0, 0, {0x08, 0x08, 0x3E, 0x08, 0x08}},  // +
+    {0x002C, 0, 0, {0x00, 0x80, 0x70, 0x30, 0x00}},  // ,
+    {0x002D, 0, 0, {0x08, 0x08, 0x08, 0x08, 0x08}},  // -
+    {0x002E, 0, 0, {0x00, 0x00, 0x60, 0x60, 0x00}},  // .
+    {0x002F, 0, 0, {0x20, 0x10, 0x08, 0x04, 0x02}},  // /
+    {0x0030, 0, 0, {0x3E, 0x51, 0x49, 0x45, 0x3E}},  // 0
+    {0x0031, 0, 0, {0x00, 0x42, 0x7F, 0x40, 0x00}},  // 1
+    {0x0032, 0, 0, {0x72, 0x49, 0x49, 0x49, 0x46}},  // 2
+    {0x0033, 0, 0, {0x21, 0x41, 0x49, 0x4D, 0x33}},  // 3
+    {0x0034, 0, 0, {0x18, 0x14, 0x12, 0x7F, 0x10}},  // 4
+    {0x0035, 0, 0, {0x27, 0x45, 0x45, 0x45, 0x39}},  // 5
+    {0x0036, 0, 0, {0x3C, 0x4A, 0x49, 0x49, 0x31}},  // 6
+    {0x0037, 0, 0, {0x41, 0x21, 0x11, 0x09, 0x07}},  // 7
+    {0x0038, 0, 0, {0x36, 0x49, 0x49, 0x49, 0x36}},  // 8
+    {0x0039, 0, 0, {0x46, 0x49, 0x49, 0x29, 0x1E}},  // 9
+    {0x003A, 0, 0, {0x00, 0x00, 0x14, 0x00, 0x00}},  // :
+    {0x003B, 0, 0, {0x00, 0x40, 0x34, 0x00, 0x00}},  // ;
+    {0x003C, 0, 0, {0x00, 0x08, 0x14, 0x22, 0x41}},  // <
+    {0x003D, 0, 0, {0x14, 0x14, 0x14, 0x14, 0x14}},  // =
+    {0x003E, 0, 0, {0x00, 0x41, 0x22, 0x14, 0x08}},  // >
+    {0x003F, 0, 0, {0x02, 0x01, 0x59, 0x09, 0x06}},  // ?
+    {0x0040, 0, 0, {0x3E, 0x41, 0x5D, 0x59, 0x4E}},  // @
+    {0x0041, 0, 0, {0x7C, 0x12, 0x11, 0x12, 0x7C}},  // A
+    {0x0042, 0, 0, {0x7F, 0x49, 0x49, 0x49, 0x36}},  // B
+    {0x0043, 0, 0, {0x3E, 0x41, 0x41, 0x41, 0x22}},  // C
+    {0x0044, 0, 0, {0x7F, 0x41, 0x41, 0x41, 0x3E}},  // D
+    {0x0045, 0, 0, {0x7F, 0x49, 0x49, 0x49, 0x41}},  // E
+    {0x0046, 0, 0, {0x7F, 0x09, 0x09, 0x09, 0x01}},  // F
+    {0x0047, 0, 0, {0x3E, 0x41, 0x41, 0x51, 0x73}},  // G
+    {0x0048, 0, 0, {0x7F, 0x08, 0x08, 0x08, 0x7F}},  // H
+    {0x0049, 0, 0, {0x00, 0x41, 0x7F, 0x41, 0x00}},  // I
+    {0x004A, 0, 0, {0x20, 0x40, 0x41, 0x3F, 0x01}},  // J
+    {0x004B, 0, 0, {0x7F, 0x08, 0x14, 0x22, 0x41}},  // K
+    {0x004C, 0, 0, {0x7F, 0x40, 0x40, 0x40, 0x40}},  // L
+    {0x004D, 0, 0, {0x7F, 0x02, 0x1C, 0x02, 0x7F}},  // M
+    {0x004E, 0, 0, {0x7F, 0x04, 0x08, 0x10, 0x7F}},  // N
+    {0x004F, 0, 0, {0x3E, 0x41, 0x41, 0x41, 0x3E}},  // O
+    {0x0050, 0, 0, {0x7F, 0x09, 0x09, 0x09, 0x06}},  // P
+    {0x0051, 0, 0, {0x3E, 0x41, 0x51, 0x21, 0x5E}},  // Q
+    {0x0052, 0, 0, {0x7F, 0x09, 0x19, 0x29, 0x46}},  // R
+    {0x0053, 0, 0, {0x26, 0x49, 0x49, 0x49, 0x32}},  // S
+    {0x0054, 0, 0, {0x03, 0x01, 0x7F, 0x01, 0x03}},  // T
+    {0x0055, 0, 0, {0x3F, 0x40, 0x40, 0x40, 0x3F}},  // U
+    {0x0056, 0, 0, {0x1F, 0x20, 0x40, 0x20, 0x1F}},  // V
+    {0x0057, 0, 0, {0x3F, 0x40, 0x38, 0x40, 0x3F}},  // W
+    {0x0058, 0, 0, {0x63, 0x14, 0x08, 0x14, 0x63}},  // X
+    {0x0059, 0, 0, {0x03, 0x04, 0x78, 0x04, 0x03}},  // Y
+    {0x005A, 0, 0, {0x61, 0x59, 0x49, 0x4D, 0x43}},  // Z
+    {0x005B, 0, 0, {0x00, 0x7F, 0x41, 0x41, 0x41}},  // [
+    {0x005C, 0, 0, {0x02, 0x04, 0x08, 0x10, 0x20}},  // backslash
+    {0x005D, 0, 0, {0x00, 0x41, 0x41, 0x41, 0x7F}},  // ]
+    {0x005E, 0, 0, {0x04, 0x02, 0x01, 0x02, 0x04}},  // ^
+    {0x005F, 0, 0, {0x40, 0x40, 0x40, 0x40, 0x40}},  // _
+    {0x0060, 0, 0, {0x00, 0x03, 0x07, 0x08, 0x00}},  // `
+    {0x0061, 0, 0, {0x20, 0x54, 0x54, 0x78, 0x40}},  // a
+    {0x0062, 0, 0, {0x7F, 0x28, 0x44, 0x44, 0x38}},  // b
+    {0x0063, 0, 0, {0x38, 0x44, 0x44, 0x44, 0x28}},  // c
+    {0x0064, 0, 0, {0x38, 0x44, 0x44, 0x28, 0x7F}},  // d
+    {0x0065, 0, 0, {0x38, 0x54, 0x54, 0x54, 0x18}},  // e
+    {0x0066, 0, 0, {0x00, 0x08, 0x7E, 0x09, 0x02}},  // f
+    {0x0067, 0, 0, {0x18, 0xA4, 0xA4, 0x9C, 0x78}},  // g
+    {0x0068, 0, 0, {0x7F, 0x08, 0x04, 0x04, 0x78}},  // h
+    {0x0069, 0, 0, {0x00, 0x44, 0x7D, 0x40, 0x00}},  // i
+    {0x006A, 0, 0, {0x20, 0x40, 0x40, 0x3D, 0x00}},  // j
+    {0x006B, 0, 0, {0x7F, 0x10, 0x28, 0x44, 0x00}},  // k
+    {0x006C, 0, 0, {0x00, 0x41, 0x7F, 0x40, 0x00}},  // l
+    {0x006D, 0, 0, {0x7C, 0x04, 0x78, 0x04, 0x78}},  // m
+    {0x006E, 0, 0, {0x7C, 0x08, 0x04, 0x04, 0x78}},  // n
+    {0x006F, 0, 0, {0x38, 0x44, 0x44, 0x44, 0x38}},  // o
+    {0x0070, 0, 0, {0xFC, 0x18, 0x24, 0x24, 0x18}},  // p
+    {0x0071, 0, 0, {0x18, 0x24, 0x24, 0x18, 0xFC}},  // q
+    {0x0072, 0, 0, {0x7C, 0x08, 0x04, 0x04, 0x08}},  // r
+    {0x0073, 0, 0, {0x48, 0x54, 0x54, 0x54, 0x24}},  // s
+    {0x0074, 0, 0, {0x04, 0x04, 0x3F, 0x44, 0x24}},  // t
+    {0x0075, 0, 0, {0x3C, 0x40, 0x40, 0x20, 0x7C}},  // u
+    {0x0076, 0, 0, {0x1C, 0x20, 0x40, 0x20, 0x1C}},  // v
+    {0x0077, 0, 0, {0x3C, 0x40, 0x30, 0x40, 0x3C}},  // w
+    {0x0078, 0, 0, {0x44, 0x28, 0x10, 0x28, 0x44}},  // x
+    {0x0079, 0, 0, {0x4C, 0x90, 0x90, 0x90, 0x7C}},  // y
+    {0x007A, 0, 0, {0x44, 0x64, 0x54, 0x4C, 0x44}},  // z
+    {0x007B, 0, 0, {0x00, 0x08, 0x36, 0x41, 0x00}},  // {
+    {0x007C, 0, 0, {0x00, 0x00, 0x77, 0x00, 0x00}},  // |
+    {0x007D, 0, 0, {0x00, 0x41, 0x36, 0x08, 0x00}},  // }
+    {0x007E, 0, 0, {0x02, 0x01, 0x02, 0x04, 0x02}},  // ~
+
+    {0x00A0, ' ', ACCENT_NONE, {}},                  // no-break space
+    {0x00A1, 0, 0, {0x00, 0x00, 0x7D, 0x00, 0x00}},  // inverted !
+    {0x00A3, 0, 0, {0x48, 0x7E, 0x49, 0x41, 0x42}},  // pound
+    {0x00B0, 0, 0, {0x00, 0x06, 0x09, 0x09, 0x06}},  // degree
+    {0x00B7, 0, 0, {0x00, 0x00, 0x08, 0x00, 0x00}},  // middle dot
+    {0x00BF, 0, 0, {0x30, 0x48, 0x4D, 0x40, 0x20}},  // inverted ?
+    {0x00C0, 'A', ACCENT_GRAVE, {}},
+    {0x00C1, 'A', ACCENT_ACUTE, {}},
+    {0x00C2, 'A', ACCENT_CIRCUMFLEX, {}},
+    {0x00C3, 'A', ACCENT_TILDE, {}},
+    {0x00C4, 'A', ACCENT_DIAERESIS, {}},
+    {0x00C5, 'A', ACCENT_RING, {}},
+    {0x00C6, 0, 0, {0x7C, 0x12, 0x7F, 0x49, 0x41}},  // AE
+    {0x00C7, 'C', ACCENT_CEDILLA, {}},
+    {0x00C8, 'E', ACCENT_GRAVE, {}},
+    {0x00C9, 'E', ACCENT_ACUTE, {}},
+    {0x00CA, 'E', ACCENT_CIRCUMFLEX, {}},
+    {0x00CB, 'E', ACCENT_DIAERESIS, {}},
+    {0x00CC, 'I', ACCENT_GRAVE, {}},
+    {0x00CD, 'I', ACCENT_ACUTE, {}},
+    {0x00CE, 'I', ACCENT_CIRCUMFLEX, {}},
+    {0x00CF, 'I', ACCENT_DIAERESIS, {}},
+    {0x00D1, 'N', ACCENT_TILDE, {}},
+    {0x00D2, 'O', ACCENT_GRAVE, {}},
+    {0x00D3, 'O', ACCENT_ACUTE, {}},
+    {0x00D4, 'O', ACCENT_CIRCUMFLEX, {}},
+    {0x00D5, 'O', ACCENT_TILDE, {}},
+    {0x00D6, 'O', ACCENT_DIAERESIS, {}},
+    {0x00D7, 0, 0, {0x22, 0x14, 0x08, 0x14, 0x22}},  // multiplication
+    {0x00D8, 0, 0, {0x5E, 0x31, 0x49, 0x46, 0x3D}},  // O stroke
+    {0x00D9, 'U', ACCENT_GRAVE, {}},
+    {0x00DA, 'U', ACCENT_ACUTE, {}},
+    {0x00DB, 'U', ACCENT_CIRCUMFLEX, {}},
+    {0x00DC, 'U', ACCENT_DIAERESIS, {}},
+    {0x00DD, 'Y', ACCENT_ACUTE, {}},
+    {0x00DF, 0, 0, {0x7E, 0x01, 0x49, 0x56, 0x20}},  // sharp s
+    {0x00E0, 'a', ACCENT_GRAVE, {}},
+    {0x00E1, 'a', ACCENT_ACUTE, {}},
+    {0x00E2, 'a', ACCENT_CIRCUMFLEX, {}},
+    {0x00E3, 'a', ACCENT_TILDE, {}},
+    {0x00E4, 'a', ACCENT_DIAERESIS, {}},
+    {0x00E5, 'a', ACCENT_RING, {}},
+    {0x00E6, 0, 0, {0x20, 0x54, 0x7C, 0x54, 0x58}},  // ae
+    {0x00E7, 'c', ACCENT_CEDILLA, {}},
+    {0x00E8, 'e', ACCENT_GRAVE, {}},
+    {0x00E9, 'e', ACCENT_ACUTE, {}},
+    {0x00EA, 'e', ACCENT_CIRCUMFLEX, {}},
+    {0x00EB, 'e', ACCENT_DIAERESIS, {}},
+    {0x00EC, 0x0131, ACCENT_GRAVE, {}},
+    {0x00ED, 0x0131, ACCENT_ACUTE, {}},
+    {0x00EE, 0x0131, ACCENT_CIRCUMFLEX, {}},
+    {0x00EF, 0x0131, ACCENT_DIAERESIS, {}},
+    {0x00F1, 'n', ACCENT_TILDE, {}},
+    {0x00F2, 'o', ACCENT_GRAVE, {}},
+    {0x00F3, 'o', ACCENT_ACUTE, {}},
+    {0x00F4, 'o', ACCENT_CIRCUMFLEX, {}},
+    {0x00F5, 'o', ACCENT_TILDE, {}},
+    {0x00F6, 'o', ACCENT_DIAERESIS, {}},
+    {0x00F7, 0, 0, {0x08, 0x08, 0x2A, 0x08, 0x08}},  // division
+    {0x00F8, 0, 0, {0x58, 0x64, 0x54, 0x4C, 0x34}},  // o stroke
+    {0x00F9, 'u', ACCENT_GRAVE, {}},
+    {0x00FA, 'u', ACCENT_ACUTE, {}},
+    {0x00FB, 'u', ACCENT_CIRCUMFLEX, {}},
+    {0x00FC, 'u', ACCENT_DIAERESIS, {}},
+    {0x00FD, 'y', ACCENT_ACUTE, {}},
+    {0x00FF, 'y', ACCENT_DIAERESIS, {}},
+
+    {0x0104, 'A', ACCENT_OGONEK, {}},
+    {0x0105, 'a', ACCENT_OGONEK, {}},
+    {0x0106, 'C', ACCENT_ACUTE, {}},
+    {0x0107, 'c', ACCENT_ACUTE, {}},
+    {0x010C, 'C', ACCENT_CARON, {}},
+    {0x010D, 'c', ACCENT_CARON, {}},
+    {0x0118, 'E', ACCENT_OGONEK, {}},
+    {0x0119, 'e', ACCENT_OGONEK, {}},
+    {0x011A, 'E', ACCENT_CARON, {}},
+    {0x011B, 'e', ACCENT_CARON, {}},
+    {0x0130, 'I', ACCENT_DOT, {}},
+    {0x0131, 0, 0, {0x00, 0x44, 0x7C, 0x40, 0x00}},  // dotless i
+    {0x0141, 0, 0, {0x08, 0x7F, 0x44, 0x40, 0x40}},  // L stroke
+    {0x0142, 0, 0, {0x00, 0x51, 0x7F, 0x44, 0x00}},  // l stroke
+    {0x0143, 'N', ACCENT_ACUTE, {}},
+    {0x0144, 'n', ACCENT_ACUTE, {}},
+    {0x0147, 'N', ACCENT_CARON, {}},
+    {0x0148, 'n', ACCENT_CARON, {}},
+    {0x0150, 'O', ACCENT_DOUBLE_ACUTE, {}},
+    {0x0151, 'o', ACCENT_DOUBLE_ACUTE, {}},
+    {0x0158, 'R', ACCENT_CARON, {}},
+    {0x0159, 'r', ACCENT_CARON, {}},
+    {0x015A, 'S', ACCENT_ACUTE, {}},
+    {0x015B, 's', ACCENT_ACUTE, {}},
+    {0x015E, 'S', ACCENT_CEDILLA, {}},
+    {0x015F, 's', ACCENT_CEDILLA, {}},
+    {0x0160, 'S', ACCENT_CARON, {}},
+    {0x0161, 's', ACCENT_CARON, {}},
+    {0x016E, 'U', ACCENT_RING, {}},
+    {0x016F, 'u', ACCENT_RING, {}},
+    {0x0170, 'U', ACCENT_DOUBLE_ACUTE, {}},
+    {0x0171, 'u', ACCENT_DOUBLE_ACUTE, {}},
+    {0x0179, 'Z', ACCENT_ACUTE, {}},
+    {0x017A, 'z', ACCENT_ACUTE, {}},
+    {0x017B, 'Z', ACCENT_DOT, {}},
+    {0x017C, 'z', ACCENT_DOT, {}},
+    {0x017D, 'Z', ACCENT_CARON, {}},
+    {0x017E, 'z', ACCENT_CARON, {}},
+
+    {0x2013, 0, 0, {0x08, 0x08, 0x08, 0x08, 0x00}},  // en dash
+    {0x2014, 0, 0, {0x08, 0x08, 0x08, 0x08, 0x08}},  // em dash
+    {0x2018, 0, 0, {0x00, 0x06, 0x05, 0x00, 0x00}},  // left single quote
+    {0x2019, 0, 0, {0x00, 0x05, 0x03, 0x00, 0x00}},  // right single quote
+    {0x201C, 0, 0, {0x06, 0x05, 0x00, 0x06, 0x05}},  // left double quote
+    {0x201D, 0, 0, {0x05, 0x03, 0x00, 0x05, 0x03}},  // right double quote
+    {0x2026, 0, 0, {0x40, 0x00, 0x40, 0x00, 0x40}},  // ellipsis
+    {0x20AC, 0, 0, {0x14, 0x3E, 0x55, 0x55, 0x41}},  // euro
+    {0xFFFD, 0, 0, {0x7F, 0x41, 0x41, 0x41, 0x7F}}   // replacement (box)
+};
+
+// Code points baked into flash
+constexpr GlyphRange FONT_5X8_SUBSET[] = {
+    {0x0020, 0x007E},   // ASCII
+    {0x00A0, 0x017F},   // Latin-1 and Latin Extended-A
+    {0x2013, 0x20AC},   // Dashes, quotes, ellipsis, euro
+    {0xFFFD, 0xFFFD}    // Fallback for anything else
+};
+
+constexpr uint16_t FONT_5X8_SOURCE_COUNT = sizeof(FONT_5X8_SOURCES) / sizeof(FONT_5X8_SOURCES[0]);
+constexpr uint8_t FONT_5X8_RANGE_COUNT = sizeof(FONT_5X8_SUBSET) / sizeof(FONT_5X8_SUBSET[0]);
+constexpr uint16_t FONT_5X8_COUNT = glyphSubsetCount(FONT_5X8_SOURCES, FONT_5X8_SOURCE_COUNT,
+                                                     FONT_5X8_SUBSET, FONT_5X8_RANGE_COUNT);
+
+static_assert(glyphSourcesSorted(FONT_5X8_SOURCES, FONT_5X8_SOURCE_COUNT),
+              "FONT_5X8_SOURCES must be sorted by code point");
+
+// The baked atlas: only this ends up in flash
+constexpr GlyphAtlasData<FONT_5X8_COUNT, FONT_5X8_WIDTH> FONT_5X8_DATA =
+    glyphBuildAtlas<FONT_5X8_COUNT, FONT_5X8_WIDTH>(FONT_5X8_SOURCES, FONT_5X8_SOURCE_COUNT,
+                                                    FONT_5X8_ACCENTS,
+                                                    FONT_5X8_SUBSET, FONT_5X8_RANGE_COUNT);
+
+constexpr int16_t FONT_5X8_FALLBACK = [] {
+    for (uint16_t i = 0; i < FONT_5X8_COUNT; i++) {
+        if (FONT_5X8_DATA.codepoints[i] == GLYPH_REPLACEMENT) return (int16_t)i;
+    }
+    return (int16_t)0;
+}();
+
+const GlyphAtlas font5x8 = {
+    FONT_5X8_DATA.codepoints,
+    FONT_5X8_DATA.bitmap,
+    FONT_5X8_COUNT,
+    FONT_5X8_WIDTH,
+    1,
+    1,
+    (uint16_t)FONT_5X8_FALLBACK
+};
+
+#endif // FONT_5X8_H
@@ -0,0 +1,232 @@
+#ifndef FRAME_STREAM_H
+#define FRAME_STREAM_H
+
+#include "bluetooth.h"
+#include "display.h"
+
+// Live frames from the phone (mode:stream).
+//
+// The app draws 128x64 frames and sends each one to the stream
+// characteristic (fff4) as the XOR against the frame before it,
+// run-length coded, in writes without response:
+//
+//   frame number (u8) | flags (u8) | start (u16 LE) | runs
+//
+// `start` is the framebuffer byte (page layout, see framebuffer.h) the
+// runs begin at. Each run is a control byte and what it needs:
+//
+//   00nnnnnn            n+1 bytes unchanged
+//   01nnnnnn b          b XORed into the next n+1 bytes
+//   1nnnnnnn b0..bn     n+1 bytes XORed in one by one
+//
+// Runs never cross writes, so a frame too big for one write carries on
+// in the next with the same number and `start` where the last one ended.
+// STREAM_FLAG_KEY marks a frame coded against a blank screen rather than
+// the previous frame; STREAM_FLAG_END marks a frame's last write.
+//
+// Runs are XORed straight into the framebuffer, which therefore always
+// holds the last frame decoded - the reference the next delta applies
+// to. Anything that breaks that chain (a write lost to a full ring, a
+// message drawn over the screen) makes the firmware drop deltas and ask
+// for a key frame with "stream:key" until one arrives.
+//
+// Each pass decodes every frame that has arrived but pushes only the
+// newest to the panel, and only the pages and columns that changed, then
+// answers "stream:ack:<frame number>" for it. The app keeps a few frames
+// unacknowledged at most and, when it gets ahead, replaces the frame
+// waiting to go out with the newer one: when throughput drops the frame
+// rate goes down rather than the latency going up.
+
+#define STREAM_HEADER           4
+#define STREAM_FLAG_KEY         0x01
+#define STREAM_FLAG_END         0x02
+#define STREAM_WRITES_PER_PASS  16      // Bounds the decoding work per loop() pass
+#define STREAM_KEY_RETRY        500     // ms between key frame requests
+
+struct FrameStream {
+    int8_t connection;          // BLE client streaming, -1 if none yet
+    uint16_t session;
+    bool needKey;               // Reference lost; deltas are dropped
+    unsigned long keyRequestedAt;
+    bool inFrame;               // A frame has started but not ended
+    uint8_t frame;              // Number of the frame being decoded
+    uint16_t position;          // Next framebuffer byte of it
+    bool ackPending;
+    uint8_t lastFrame;          // Newest frame decoded
+    uint32_t presentedSerial;   // fbFrameSerial after our last push
+    // Region changed since the last push
+    bool dirty;
+    uint8_t dirtyPage0, dirtyPage1, dirtyX0, dirtyX1;
+};
+
+FrameStream stream;
+uint8_t streamWrite[BLE_RX_MAX_WRITE];
+
+void streamSend(const String& text) {
+    if (bleConnectionPresent(stream.connection, stream.session)) {
+        bleSerialPrintlnTo(stream.connection, text);
+    }
+}
+
+// Framebuffer bytes first..last changed
+void streamMarkDirty(uint16_t first, uint16_t last) {
+    uint8_t page0 = first / FB_WIDTH;
+    uint8_t page1 = last / FB_WIDTH;
+    uint8_t x0 = page0 == page1 ? first % FB_WIDTH : 0;
+    uint8_t x1 = page0 == page1 ? last % FB_WIDTH : FB_WIDTH - 1;
+    if (!stream.dirty) {
+        stream.dirty = true;
+        stream.dirtyPage0 = page0;
+        stream.dirtyPage1 = page1;
+        stream.dirtyX0 = x0;
+        stream.dirtyX1 = x1;
+        return;
+    }
+    stream.dirtyPage0 = min(stream.dirtyPage0, page0);
+    stream.dirtyPage1 = max(stream.dirtyPage1, page1);
+    stream.dirtyX0 = min(stream.dirtyX0, x0);
+    stream.dirtyX1 = max(stream.dirtyX1, x1);
+}
+
+// The framebuffer no longer follows the phone's frames
+void streamLost() {
+    stream.inFrame = false;
+    if (stream.needKey) return;
+    stream.needKey = true;
+    stream.keyRequestedAt = millis();
+    streamSend("stream:key");
+}
+
+// XOR one write's runs into the framebuffer from `position` on; false if
+// they are malformed or run off its end
+bool streamDecode(const uint8_t* runs, uint16_t length, uint16_t& position) {
+    uint8_t* fb = fbBuffer();
+    uint16_t i = 0;
+    while (i < length) {
+        uint8_t control = runs[i++];
+        uint16_t count = (control & 0x80) ? (control & 0x7F) + 1 : (control & 0x3F) + 1;
+        if (position + count > FB_SIZE) return false;
+
+        if (control & 0x80) {
+            if (i + count > length) return false;
+            for (uint16_t k = 0; k < count; k++) fb[position + k] ^= runs[i + k];
+            i += count;
+            streamMarkDirty(position, position + count - 1);
+        } else if (control & 0x40) {
+            if (i >= length) return false;
+            uint8_t value = runs[i++];
+            if (value != 0) {
+                for (uint16_t k = 0; k < count; k++) fb[position + k] ^= value;
+                streamMarkDirty(position, position + count - 1);
+            }
+        }
+        position += count;
+    }
+    return true;
+}
+
+// Take one write from the stream channel
+void streamTake(int8_t connection, uint16_t length) {
+    if (connection < 0 || length < STREAM_HEADER || length > sizeof(streamWrite)) return;
+    if (!bleConnectionPresent(stream.connection, stream.session)) {
+        // Nobody owns the stream yet: whoever sends first does
+        stream.connection = connection;
+        stream.session = bleConnectionSession(connection);
+    } else if (connection != stream.connection) {
+        return;
+    }
+
+    uint8_t frame = streamWrite[0];
+    uint8_t flags = streamWrite[1];
+    uint16_t start = streamWrite[2] | (uint16_t)streamWrite[3] << 8;
+
+    if (start == 0) {
+        // First write of a frame; one still open lost its end
+        if (stream.inFrame) streamLost();
+        if (stream.needKey && !(flags & STREAM_FLAG_KEY)) return;
+        if (flags & STREAM_FLAG_KEY) {
+            memset(fbBuffer(), 0, FB_SIZE);
+            streamMarkDirty(0, FB_SIZE - 1);
+            stream.needKey = false;
+        }
+        stream.inFrame = true;
+        stream.frame = frame;
+        stream.position = 0;
+    } else if (!stream.inFrame || frame != stream.frame || start != stream.position) {
+        // A write of this frame went missing
+        if (stream.inFrame) streamLost();
+        return;
+    }
+
+    if (!streamDecode(streamWrite + STREAM_HEADER, length - STREAM_HEADER, stream.position)) {
+        streamLost();
+        return;
+    }
+    if (flags & STREAM_FLAG_END) {
+        stream.inFrame = false;
+        stream.lastFrame = frame;
+        stream.ackPending = true;
+    }
+}
+
+// Start streaming for `connection` (-1: whoever sends first). The screen
+// goes blank until the first key frame.
+void streamBegin(int8_t connection) {
+    stream.connection = connection;
+    stream.session = connection >= 0 ? bleConnectionSession(connection) : 0;
+    stream.needKey = true;
+    stream.keyRequestedAt = millis();
+    stream.inFrame = false;
+    stream.ackPending = false;
+    stream.dirty = false;
+    spscDiscard(bleStreamRing);
+    bleStreamDropped.store(0, std::memory_order_relaxed);
+
+    memset(fbBuffer(), 0, FB_SIZE);
+    fbPushPages(fbBuffer(), 0, FB_PAGES - 1, 0, FB_WIDTH - 1);
+    stream.presentedSerial = fbFrameSerial;
+}
+
+// Decode what has arrived and present the newest frame (call this in
+// loop while streaming). False once the client that was streaming has
+// gone.
+bool streamTick() {
+    if (stream.connection >= 0 && !bleConnectionPresent(stream.connection, stream.session)) {
+        return false;
+    }
+
+    // Something else drew on the screen since our last push
+    if (stream.presentedSerial != fbFrameSerial) {
+        streamLost();
+        stream.presentedSerial = fbFrameSerial;
+    }
+
+    // Finish a frame once started; the ring bounds how long that takes
+    for (uint16_t i = 0; i < STREAM_WRITES_PER_PASS || stream.inFrame; i++) {
+        int8_t connection;
+        uint16_t length = bleStreamRead(connection, streamWrite, sizeof(streamWrite));
+        if (length == 0) break;
+        streamTake(connection, length);
+    }
+    if (bleStreamDropped.exchange(0, std::memory_order_relaxed) > 0) {
+        streamLost();
+    }
+
+    // Push between whole frames only, so the panel never shows half of one
+    if (stream.dirty && !stream.inFrame && !stream.needKey) {
+        fbPushPages(fbBuffer(), stream.dirtyPage0, stream.dirtyPage1, stream.dirtyX0, stream.dirtyX1);
+        stream.presentedSerial = fbFrameSerial;
+        stream.dirty = false;
+    }
+    if (stream.ackPending) {
+        streamSend("stream:ack:" + String(stream.lastFrame));
+        stream.ackPending = false;
+    }
+    if (stream.needKey && millis() - stream.keyRequestedAt >= STREAM_KEY_RETRY) {
+        stream.keyRequestedAt = millis();
+        streamSend("stream:key");
+    }
+    return true;
+}
+
+#endif // FRAME_STREAM_H
@@ -0,0 +1,247 @@
+#ifndef FRAMEBUFFER_H
+#define FRAMEBUFFER_H
+
+#include <Wire.h>
+#include <Adafruit_SH110X.h>
+
+// Display object is defined in display.h
+extern Adafruit_SH1106G display;
+
+// Direct drawing into the SH1106 framebuffer.
+//
+// Adafruit_SH110X keeps the screen as 8 pages of 128 column bytes:
+// buffer[x + page * 128], bit 0 = top row of the page. A vertical run of
+// pixels in one column is therefore the cheapest primitive there is (two
+// masked bytes at most, whole bytes in between), so the fill kernels below
+// walk the shape column by column instead of going through drawPixel().
+
+#define FB_WIDTH  128
+#define FB_HEIGHT 64
+#define FB_PAGES  (FB_HEIGHT / 8)
+#define FB_SIZE   (FB_WIDTH * FB_PAGES)
+
+// Panel addressing for raw page pushes
+#define FB_I2C_ADDRESS     0x3C
+#define FB_COLUMN_OFFSET   2     // SH1106 RAM is 132 columns wide, the glass starts at 2
+#define FB_I2C_CHUNK       64    // Data bytes per I2C transaction (Wire buffer is 128)
+
+// Blit modes for fbBlitColumns()
+#define FB_BLIT_OR    0  // Set sprite pixels
+#define FB_BLIT_CLEAR 1  // Clear sprite pixels
+
+inline uint8_t* fbBuffer() {
+    return display.getBuffer();
+}
+
+// Set (on = true) or clear pixels y0..y1 (inclusive) in column x
+void fbColumnSpan(int16_t x, int16_t y0, int16_t y1, bool on) {
+    if (x < 0 || x >= FB_WIDTH) return;
+    if (y0 < 0) y0 = 0;
+    if (y1 >= FB_HEIGHT) y1 = FB_HEIGHT - 1;
+    if (y0 > y1) return;
+
+    uint8_t* col = fbBuffer() + x;
+    uint8_t firstPage = y0 >> 3;
+    uint8_t lastPage = y1 >> 3;
+    uint8_t firstMask = 0xFF << (y0 & 7);
+    uint8_t lastMask = 0xFF >> (7 - (y1 & 7));
+
+    if (firstPage == lastPage) {
+        uint8_t mask = firstMask & lastMask;
+        if (on) col[firstPage * FB_WIDTH] |= mask;
+        else    col[firstPage * FB_WIDTH] &= ~mask;
+        return;
+    }
+
+    if (on) col[firstPage * FB_WIDTH] |= firstMask;
+    else    col[firstPage * FB_WIDTH] &= ~firstMask;
+    for (uint8_t p = firstPage + 1; p < lastPage; p++) {
+        col[p * FB_WIDTH] = on ? 0xFF : 0x00;
+    }
+    if (on) col[lastPage * FB_WIDTH] |= lastMask;
+    else    col[lastPage * FB_WIDTH] &= ~lastMask;
+}
+
+// OR up to 32 rows of pixels into column x, bit 0 of `bits` at row y
+void fbColumnBits(int16_t x, int16_t y, uint32_t bits) {
+    if (x < 0 || x >= FB_WIDTH || bits == 0) return;
+    int16_t page = (y >= 0) ? (y >> 3) : -((7 - y) >> 3);
+    uint64_t shifted = (uint64_t)bits << (y & 7);
+    uint8_t* col = fbBuffer() + x;
+    for (; shifted != 0; page++, shifted >>= 8) {
+        if (page >= 0 && page < FB_PAGES) col[page * FB_WIDTH] |= (uint8_t)shifted;
+    }
+}
+
+// Integer square root (floor), good for everything the kernels need
+uint16_t fbIsqrt(uint32_t v) {
+    uint32_t result = 0;
+    uint32_t bit = 1UL << 30;
+    while (bit > v) bit >>= 2;
+    while (bit != 0) {
+        if (v >= result + bit) {
+            v -= result + bit;
+            result = (result >> 1) + bit;
+        } else {
+            result >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint16_t)result;
+}
+
+// Filled axis-aligned ellipse centred on (cx, cy) with radii rx, ry
+void fbFillEllipse(int16_t cx, int16_t cy, int16_t rx, int16_t ry, bool on) {
+    if (rx <= 0 || ry <= 0) {
+        if (rx >= 0 && ry >= 0) fbColumnSpan(cx, cy - ry, cy + ry, on);
+        return;
+    }
+    uint32_t rx2 = (uint32_t)rx * rx;
+    uint32_t ry2 = (uint32_t)ry * ry;
+    for (int16_t dx = 0; dx <= rx; dx++) {
+        // Half height of this column: ry * sqrt(1 - dx^2 / rx^2)
+        uint16_t h = fbIsqrt((rx2 - (uint32_t)dx * dx) * ry2 / rx2);
+        fbColumnSpan(cx - dx, cy - h, cy + h, on);
+        if (dx != 0) fbColumnSpan(cx + dx, cy - h, cy + h, on);
+    }
+}
+
+// Filled rectangle with corner radius r, top-left at (x, y)
+void fbFillRoundRect(int16_t x, int16_t y, int16_t w, int16_t h, int16_t r, bool on) {
+    if (w <= 0 || h <= 0) return;
+    if (r > w / 2) r = w / 2;
+    if (r > h / 2) r = h / 2;
+    if (r < 0) r = 0;
+
+    uint32_t r2 = (uint32_t)r * r;
+    for (int16_t i = 0; i < w; i++) {
+        int16_t inset = 0;
+        int16_t dx = 0;
+        if (i < r) {
+            dx = r - i;
+        } else if (i >= w - r) {
+            dx = i - (w - 1 - r);
+        }
+        if (dx > 0) {
+            inset = r - fbIsqrt(r2 - (uint32_t)dx * dx);
+        }
+        fbColumnSpan(x + i, y + inset, y + h - 1 - inset, on);
+    }
+}
+
+// Blit a column-major sprite stored in page layout (w bytes per page row,
+// `pages` rows, bit 0 = top) with its top-left corner at (x, y). Each source
+// byte is shifted into at most two destination pages, so a whole 8-pixel
+// column slice costs two read-modify-writes regardless of alignment.
+//
+// srcW is the stored sprite width; when w != srcW columns are resampled
+// (nearest neighbour), which squeezes a sprite horizontally for free.
+void fbBlitColumns(int16_t x, int16_t y, const uint8_t* sprite, uint8_t srcW,
+                   uint8_t pages, uint8_t w, uint8_t mode) {
+    if (w == 0 || srcW == 0) return;
+    uint8_t* fb = fbBuffer();
+    int16_t pageOffset = (y >= 0) ? (y >> 3) : -((7 - y) >> 3);
+    uint8_t shift = y & 7;
+
+    for (uint8_t i = 0; i < w; i++) {
+        int16_t dx = x + i;
+        if (dx < 0 || dx >= FB_WIDTH) continue;
+        uint8_t srcCol = (w == srcW) ? i : (uint8_t)(((uint16_t)i * srcW) / w);
+
+        for (uint8_t p = 0; p < pages; p++) {
+            uint8_t bits = pgm_read_byte(sprite + p * srcW + srcCol);
+            if (bits == 0) continue;
+            int16_t page = pageOffset + p;
+            uint8_t lo = bits << shift;
+            uint8_t hi = shift ? (bits >> (8 - shift)) : 0;
+            if (page >= 0 && page < FB_PAGES) {
+                if (mode == FB_BLIT_OR) fb[page * FB_WIDTH + dx] |= lo;
+                else                    fb[page * FB_WIDTH + dx] &= ~lo;
+            }
+            if (hi && page + 1 >= 0 && page + 1 < FB_PAGES) {
+                if (mode == FB_BLIT_OR) fb[(page + 1) * FB_WIDTH + dx] |= hi;
+                else                    fb[(page + 1) * FB_WIDTH + dx] &= ~hi;
+            }
+        }
+    }
+}
+
+// Bumped on every push to the panel, so callers can tell whether the screen
+// still shows what they pushed last
+uint32_t fbFrameSerial = 0;
+
+// I2C clock used for raw pushes (Adafruit_SH110X drops the bus back to
+// 100 kHz after each display() call)
+uint32_t fbI2cClock = 400000;
+
+// Push columns x0..x1 of pages firstPage..lastPage from `src` (an FB_SIZE
+// page-layout buffer, not necessarily the display's own) straight to the
+// panel. Lets callers update just the region that changed, or present from
+// a buffer of their own without copying it into the framebuffer first.
+void fbPushPages(const uint8_t* src, uint8_t firstPage, uint8_t lastPage, uint8_t x0, uint8_t x1) {
+    if (lastPage >= FB_PAGES) lastPage = FB_PAGES - 1;
+    if (x1 >= FB_WIDTH) x1 = FB_WIDTH - 1;
+    if (firstPage > lastPage || x0 > x1) return;
+
+    fbFrameSerial++;
+    Wire.setClock(fbI2cClock);
+    uint8_t column = x0 + FB_COLUMN_OFFSET;
+    for (uint8_t page = firstPage; page <= lastPage; page++) {
+        Wire.beginTransmission(FB_I2C_ADDRESS);
+        Wire.write((uint8_t)0x00);                  // Command stream
+        Wire.write((uint8_t)(0xB0 | page));         // Page address
+        Wire.write((uint8_t)(0x10 | (column >> 4))); // Column high nibble
+        Wire.write((uint8_t)(column & 0x0F));       // Column low nibble
+        Wire.endTransmission();
+
+        const uint8_t* ptr = src + page * FB_WIDTH + x0;
+        uint8_t remaining = x1 - x0 + 1;
+        while (remaining > 0) {
+            uint8_t n = remaining > FB_I2C_CHUNK ? FB_I2C_CHUNK : remaining;
+            Wire.beginTransmission(FB_I2C_ADDRESS);
+            Wire.write((uint8_t)0x40);              // Data stream
+            Wire.write(ptr, n);
+            Wire.endTransmission();
+            ptr += n;
+            remaining -= n;
+        }
+    }
+}
+
+// 4x4 ordered-dither (Bayer) thresholds, indexed [row & 3][column & 3]
+const uint8_t FB_BAYER4[4][4] = {
+    { 0,  8,  2, 10},
+    {12,  4, 14,  6},
+    { 3, 11,  1,  9},
+    {15,  7, 13,  5}
+};
+
+// Dither mask for level 0..16 (0 = nothing, 16 = everything) covering four
+// adjacent columns of one page. The Bayer pattern repeats every 4 columns and
+// 4 rows, so this single 32-bit word (byte n = column n, little-endian) is
+// the mask for every aligned word of the framebuffer.
+uint32_t fbDitherMask(uint8_t level) {
+    uint32_t mask = 0;
+    for (uint8_t col = 0; col < 4; col++) {
+        uint8_t bits = 0;
+        for (uint8_t row = 0; row < 8; row++) {
+            if (FB_BAYER4[row & 3][col] < level) bits |= 1 << row;
+        }
+        mask |= (uint32_t)bits << (col * 8);
+    }
+    return mask;
+}
+
+// Blend `from` into `dst` in place: pixels under the dither mask for `level`
+// keep dst, the rest come from `from`. Both buffers are FB_SIZE bytes and
+// 4-byte aligned; the whole screen is 256 word-wide AND/OR operations.
+void fbDitherBlend(uint8_t* dst, const uint8_t* from, uint8_t level) {
+    uint32_t mask = fbDitherMask(level);
+    uint32_t* d = (uint32_t*)dst;
+    const uint32_t* f = (const uint32_t*)from;
+    for (uint16_t i = 0; i < FB_SIZE / 4; i++) {
+        d[i] = (d[i] & mask) | (f[i] & ~mask);
+    }
+}
+
+#endif // FRAMEBUFFER_H
@@ -0,0 +1,252 @@
+#ifndef GLYPH_ATLAS_H
+#define GLYPH_ATLAS_H
+
+#include "framebuffer.h"
+
+// Pre-rasterized glyph atlases with UTF-8 text.
+//
+// An atlas stores fixed-size 1-bit glyphs column-major in the SH1106 page
+// layout (bit 0 = top row, `pages` rows of `width` bytes per glyph), so a
+// glyph goes into the framebuffer with whole-column writes through
+// fbBlitColumns() instead of one drawPixel() per dot. Code points are kept
+// in a sorted table next to the bitmaps and looked up by binary search.
+//
+// Atlases are baked at compile time from a source font by
+// glyphBuildAtlas(), keeping only the code points listed in a subset, so
+// unused glyphs never reach flash. See font_5x8.h.
+
+#define GLYPH_REPLACEMENT 0xFFFD   // Decoder output for malformed UTF-8
+#define GLYPH_MAX_WIDTH   8        // Widest glyph a source font can describe
+
+struct GlyphAtlas {
+    const uint16_t* codepoints;  // Sorted ascending
+    const uint8_t* bitmap;       // count * width * pages bytes
+    uint16_t count;
+    uint8_t width;               // Glyph width in columns
+    uint8_t pages;               // Glyph height in pages
+    uint8_t spacing;             // Blank columns after each glyph
+    uint16_t fallback;           // Glyph index for code points not in the atlas
+};
+
+// ---------------------------------------------------------------------------
+// Compile-time atlas builder
+
+// Source glyph: either drawn (columns) or composed from a base glyph plus
+// an accent from the font's accent table
+struct GlyphSource {
+    uint16_t codepoint;
+    uint16_t base;           // 0 = drawn
+    uint8_t accent;
+    uint8_t columns[GLYPH_MAX_WIDTH]; // Drawn glyphs, one page tall
+};
+
+struct GlyphRange {
+    uint16_t first;
+    uint16_t last;
+};
+
+template <uint16_t N, uint8_t W>
+struct GlyphAtlasData {
+    uint16_t codepoints[N];
+    uint8_t bitmap[N * W];
+};
+
+constexpr bool glyphInRanges(const GlyphRange* ranges, uint8_t rangeCount, uint16_t cp) {
+    for (uint8_t i = 0; i < rangeCount; i++) {
+        if (cp >= ranges[i].first && cp <= ranges[i].last) return true;
+    }
+    return false;
+}
+
+// Number of source glyphs that fall in the subset
+constexpr uint16_t glyphSubsetCount(const GlyphSource* sources, uint16_t count,
+                                    const GlyphRange* ranges, uint8_t rangeCount) {
+    uint16_t n = 0;
+    for (uint16_t i = 0; i < count; i++) {
+        if (glyphInRanges(ranges, rangeCount, sources[i].codepoint)) n++;
+    }
+    return n;
+}
+
+constexpr int16_t glyphSourceIndex(const GlyphSource* sources, uint16_t count, uint16_t cp) {
+    for (uint16_t i = 0; i < count; i++) {
+        if (sources[i].codepoint == cp) return i;
+    }
+    return -1;
+}
+
+// Does an accent sit above the letter (rows 0-1)?
+constexpr bool glyphAccentAbove(const uint8_t (*accents)[GLYPH_MAX_WIDTH], uint8_t accent) {
+    for (uint8_t col = 0; col < GLYPH_MAX_WIDTH; col++) {
+        if (accents[accent][col] & 0x03) return true;
+    }
+    return false;
+}
+
+constexpr bool glyphSourcesSorted(const GlyphSource* sources, uint16_t count) {
+    for (uint16_t i = 1; i < count; i++) {
+        if (sources[i].codepoint <= sources[i - 1].codepoint) return false;
+    }
+    return true;
+}
+
+// Column `col` of a source glyph, composing accented glyphs. Accents use
+// rows 0-1 (above) or row 7 (below). Capitals fill rows 0-6, so for an
+// accent above they lose their second row and the accent is flattened
+// into row 0; the baseline stays put.
+constexpr uint8_t glyphSourceColumn(const GlyphSource* sources, uint16_t count,
+                                    const uint8_t (*accents)[GLYPH_MAX_WIDTH], int16_t index, uint8_t col) {
+    if (index < 0) return 0;
+    const GlyphSource& g = sources[index];
+    if (g.base == 0) return g.columns[col];
+
+    uint8_t base = glyphSourceColumn(sources, count, accents,
+                                     glyphSourceIndex(sources, count, g.base), col);
+    uint8_t accent = accents[g.accent][col];
+    bool capital = g.base >= 'A' && g.base <= 'Z';
+    if (capital && glyphAccentAbove(accents, g.accent)) {
+        base = (base & 0x7C) | ((base & 0x01) << 1);
+        accent = (accent | (accent >> 1)) & 0x01;
+    }
+    return base | accent;
+}
+
+// Bake the subset of `sources` into an atlas image (one page tall glyphs)
+template <uint16_t N, uint8_t W>
+constexpr GlyphAtlasData<N, W> glyphBuildAtlas(const GlyphSource* sources, uint16_t count,
+                                               const uint8_t (*accents)[GLYPH_MAX_WIDTH],
+                                               const GlyphRange* ranges, uint8_t rangeCount) {
+    GlyphAtlasData<N, W> data{};
+    uint16_t n = 0;
+    for (uint16_t i = 0; i < count && n < N; i++) {
+        if (!glyphInRanges(ranges, rangeCount, sources[i].codepoint)) continue;
+        data.codepoints[n] = sources[i].codepoint;
+        for (uint8_t col = 0; col < W; col++) {
+            data.bitmap[n * W + col] = glyphSourceColumn(sources, count, accents, i, col);
+        }
+        n++;
+    }
+    return data;
+}
+
+// ---------------------------------------------------------------------------
+// UTF-8
+
+// Decode the code point at p (advancing p, never past end). Malformed or
+// truncated sequences and overlong forms give GLYPH_REPLACEMENT and skip one
+// byte, so the decoder always makes progress.
+uint32_t utf8Next(const char*& p, const char* end) {
+    uint8_t c = (uint8_t)*p++;
+    if (c < 0x80) return c;
+
+    uint8_t extra;
+    uint32_t cp;
+    if ((c & 0xE0) == 0xC0)      { extra = 1; cp = c & 0x1F; }
+    else if ((c & 0xF0) == 0xE0) { extra = 2; cp = c & 0x0F; }
+    else if ((c & 0xF8) == 0xF0) { extra = 3; cp = c & 0x07; }
+    else return GLYPH_REPLACEMENT;
+
+    if (end - p < extra) return GLYPH_REPLACEMENT;
+    for (uint8_t i = 0; i < extra; i++) {
+        uint8_t cc = (uint8_t)p[i];
+        if ((cc & 0xC0) != 0x80) return GLYPH_REPLACEMENT;
+        cp = (cp << 6) | (cc & 0x3F);
+    }
+
+    static const uint32_t minimum[4] = {0, 0x80, 0x800, 0x10000};
+    if (cp < minimum[extra] || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF)) {
+        return GLYPH_REPLACEMENT;
+    }
+    p += extra;
+    return cp;
+}
+
+// Number of code points in the first `length` bytes
+uint16_t utf8Length(const char* text, uint16_t length) {
+    const char* p = text;
+    const char* end = text + length;
+    uint16_t n = 0;
+    while (p < end) {
+        utf8Next(p, end);
+        n++;
+    }
+    return n;
+}
+
+// Byte length of the first `glyphs` code points
+uint16_t utf8Prefix(const char* text, uint16_t length, uint16_t glyphs) {
+    const char* p = text;
+    const char* end = text + length;
+    while (p < end && glyphs > 0) {
+        utf8Next(p, end);
+        glyphs--;
+    }
+    return p - text;
+}
+
+// ---------------------------------------------------------------------------
+// Rendering
+
+// Bitmap of a code point's glyph (the fallback glyph if it isn't baked in)
+const uint8_t* glyphBitmap(const GlyphAtlas& atlas, uint32_t cp) {
+    uint16_t lo = 0;
+    uint16_t hi = atlas.count;
+    while (lo < hi) {
+        uint16_t mid = (lo + hi) / 2;
+        uint16_t c = pgm_read_word(atlas.codepoints + mid);
+        if (c == cp) return atlas.bitmap + mid * atlas.width * atlas.pages;
+        if (c < cp) lo = mid + 1;
+        else hi = mid;
+    }
+    return atlas.bitmap + atlas.fallback * atlas.width * atlas.pages;
+}
+
+// Spread each bit of a glyph column over `size` rows
+uint32_t glyphScaleColumn(uint8_t bits, uint8_t size) {
+    uint32_t out = 0;
+    uint32_t run = (1UL << size) - 1;
+    for (uint8_t row = 0; row < 8; row++) {
+        if (bits & (1 << row)) out |= run << (row * size);
+    }
+    return out;
+}
+
+// Draw one glyph with its top-left at (x, y), scaled by `size`
+void glyphDraw(const GlyphAtlas& atlas, int16_t x, int16_t y, uint32_t cp, uint8_t size) {
+    const uint8_t* bitmap = glyphBitmap(atlas, cp);
+    if (size <= 1) {
+        fbBlitColumns(x, y, bitmap, atlas.width, atlas.pages, atlas.width, FB_BLIT_OR);
+        return;
+    }
+    // Scaled: each source column becomes `size` identical columns
+    for (uint8_t col = 0; col < atlas.width; col++) {
+        uint8_t bits = pgm_read_byte(bitmap + col);
+        if (bits == 0) continue;
+        uint32_t scaled = glyphScaleColumn(bits, size);
+        for (uint8_t i = 0; i < size; i++) {
+            fbColumnBits(x + col * size + i, y, scaled);
+        }
+    }
+}
+
+// Horizontal advance of one glyph at `size`
+inline uint8_t glyphAdvance(const GlyphAtlas& atlas, uint8_t size) {
+    return (atlas.width + atlas.spacing) * size;
+}
+
+// Draw `length` bytes of UTF-8 text from (x, y); returns the x after it
+int16_t glyphDrawText(const GlyphAtlas& atlas, int16_t x, int16_t y,
+                      const char* text, uint16_t length, uint8_t size) {
+    const char* p = text;
+    const char* end = text + length;
+    uint8_t advance = glyphAdvance(atlas, size);
+    while (p < end) {
+        uint32_t cp = utf8Next(p, end);
+        if (x >= FB_WIDTH) break;
+        if (x > -advance && cp != ' ') glyphDraw(atlas, x, y, cp, size);
+        x += advance;
+    }
+    return x;
+}
+
+#endif // GLYPH_ATLAS_H
@@ -0,0 +1,121 @@
+#ifndef GRAYSCALE_H
+#define GRAYSCALE_H
+
+#include "display.h"
+
+// Temporal-dithering grayscale for the 1-bit SH1106.
+//
+// A GrayFrame holds two bitplanes in the native page layout. The present
+// scheduler cycles MSB, LSB, MSB at a fixed subframe rate, so a pixel is lit
+// for (2 * msb + lsb) / 3 of the time: four levels, 0 (off) to 3 (full).
+// Planes are pushed straight from the frame with fbPushPages(), no copies.
+//
+// This is only usable with a fast bus: at 800 kHz a full-screen push takes
+// ~12 ms, which gives ~80 subframes/s and a ~27 Hz gray cycle.
+
+#define GRAY_LEVELS        4
+#define GRAY_I2C_CLOCK     800000  // Above the SH1106's 400 kHz spec, but fine on common modules
+#define GRAY_SUBFRAME_US   12500   // Subframe period; steady timing keeps the levels even
+
+struct GrayFrame {
+    uint32_t lsb[FB_SIZE / 4];
+    uint32_t msb[FB_SIZE / 4];
+};
+
+// Plane shown in each subframe of the cycle
+const uint8_t GRAY_SUBFRAME_PLANE[3] = {1, 0, 1}; // 1 = MSB, 0 = LSB
+
+// Present scheduler state
+const GrayFrame* grayFrame = nullptr;
+uint8_t graySubframe = 0;
+unsigned long grayNextDeadline = 0;
+uint32_t grayLateSubframes = 0;   // Subframes that missed their slot (for tuning)
+uint32_t grayPreviousClock = 400000;
+
+void grayClear(GrayFrame& frame) {
+    memset(frame.lsb, 0, sizeof(frame.lsb));
+    memset(frame.msb, 0, sizeof(frame.msb));
+}
+
+void graySetPixel(GrayFrame& frame, int16_t x, int16_t y, uint8_t level) {
+    if (x < 0 || x >= FB_WIDTH || y < 0 || y >= FB_HEIGHT) return;
+    uint8_t* lsb = (uint8_t*)frame.lsb;
+    uint8_t* msb = (uint8_t*)frame.msb;
+    uint16_t index = x + (y >> 3) * FB_WIDTH;
+    uint8_t bit = 1 << (y & 7);
+    if (level & 1) lsb[index] |= bit; else lsb[index] &= ~bit;
+    if (level & 2) msb[index] |= bit; else msb[index] &= ~bit;
+}
+
+// Demo frame for the gray mode: a four-step ramp and a shaded sphere
+void grayBuildShowcase(GrayFrame& frame) {
+    grayClear(frame);
+
+    // Ramp across the bottom: one band per level
+    for (int16_t x = 0; x < FB_WIDTH; x++) {
+        uint8_t level = x / (FB_WIDTH / GRAY_LEVELS);
+        for (int16_t y = 52; y < FB_HEIGHT; y++) {
+            graySetPixel(frame, x, y, level);
+        }
+    }
+
+    // Sphere lit from the top-left: level falls off with distance from the
+    // highlight, edge pixels stay at the lowest visible level
+    const int16_t cx = 64, cy = 25, r = 22;
+    const int16_t hx = cx - 8, hy = cy - 8;
+    for (int16_t y = cy - r; y <= cy + r; y++) {
+        for (int16_t x = cx - r; x <= cx + r; x++) {
+            int32_t dx = x - cx, dy = y - cy;
+            if (dx * dx + dy * dy > (int32_t)r * r) continue;
+            int32_t lx = x - hx, ly = y - hy;
+            int32_t d2 = lx * lx + ly * ly;
+            uint8_t level = d2 < 80 ? 3 : (d2 < 500 ? 2 : 1);
+            graySetPixel(frame, x, y, level);
+        }
+    }
+}
+
+// Start presenting a gray frame (the frame must stay alive while shown)
+void grayBegin(const GrayFrame* frame) {
+    if (grayFrame == nullptr) {
+        grayPreviousClock = fbI2cClock;
+    }
+    grayFrame = frame;
+    graySubframe = 0;
+    grayLateSubframes = 0;
+    fbI2cClock = GRAY_I2C_CLOCK;
+    grayNextDeadline = micros();
+}
+
+void grayEnd() {
+    if (grayFrame == nullptr) return;
+    // Leave the MSB plane in the framebuffer as the screen's 1-bit stand-in,
+    // so whatever comes next (e.g. a transition) starts from it
+    memcpy(fbBuffer(), grayFrame->msb, FB_SIZE);
+    grayFrame = nullptr;
+    fbI2cClock = grayPreviousClock;
+}
+
+// Call as often as possible from loop(). Presents the next subframe when its
+// slot comes up; deadlines advance by a fixed period so jitter in the caller
+// doesn't accumulate into drift.
+void grayPresentTick() {
+    if (grayFrame == nullptr) return;
+
+    unsigned long now = micros();
+    if ((long)(now - grayNextDeadline) < 0) return;
+
+    const uint32_t* plane = GRAY_SUBFRAME_PLANE[graySubframe] ? grayFrame->msb : grayFrame->lsb;
+    fbPushPages((const uint8_t*)plane, 0, FB_PAGES - 1, 0, FB_WIDTH - 1);
+    graySubframe = (graySubframe + 1) % 3;
+
+    grayNextDeadline += GRAY_SUBFRAME_US;
+    if ((long)(micros() - grayNextDeadline) > (long)GRAY_SUBFRAME_US) {
+        // Fell more than a whole slot behind (blocking animation, BLE, ...):
+        // resync instead of bursting to catch up
+        grayLateSubframes++;
+        grayNextDeadline = micros() + GRAY_SUBFRAME_US;
+    }
+}
+
+#endif // GRAYSCALE_H
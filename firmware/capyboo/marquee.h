@@ -0,0 +1,102 @@
+#ifndef MARQUEE_H
+#define MARQUEE_H
+
+#include "font_5x8.h"
+
+// Scrolling ticker for messages too long to wrap onto the screen.
+//
+// The message is rendered once into an off-screen strip (page layout, as
+// many pages tall as the text size, one column per pixel of text plus a
+// gap before it repeats). Each frame copies a 128-column window of the
+// strip into the framebuffer pages it occupies, so a frame costs the same
+// two memcpy()s per page however long the message is, and only those pages
+// need pushing.
+
+#define MARQUEE_STRIP_BYTES 4096   // Strip memory; longer messages are cut off
+#define MARQUEE_GAP         32     // Blank columns before the text repeats
+#define MARQUEE_SPEED       40     // px per second
+#define MARQUEE_FRAME_MS    25     // 40 fps
+
+uint8_t marqueeStrip[MARQUEE_STRIP_BYTES];
+uint16_t marqueeWidth = 0;     // Strip width in columns, gap included
+uint8_t marqueePages = 0;      // Strip height in pages (= text size)
+uint8_t marqueeTop = 0;        // Framebuffer page the strip is shown on
+unsigned long marqueeStart = 0;
+unsigned long marqueeLastFrame = 0;
+
+// OR a glyph into the strip at column x, scaled by `size`
+void marqueeDrawGlyph(uint16_t x, uint32_t cp, uint8_t size) {
+    const uint8_t* bitmap = glyphBitmap(font5x8, cp);
+    for (uint8_t col = 0; col < font5x8.width; col++) {
+        uint32_t bits = glyphScaleColumn(pgm_read_byte(bitmap + col), size);
+        if (bits == 0) continue;
+        for (uint8_t i = 0; i < size; i++) {
+            uint16_t column = x + col * size + i;
+            for (uint8_t page = 0; page < size; page++) {
+                marqueeStrip[page * marqueeWidth + column] |= (uint8_t)(bits >> (page * 8));
+            }
+        }
+    }
+}
+
+// Render `length` bytes of UTF-8 text into the strip and restart scrolling.
+// Uses text size 2 when the strip can hold it, size 1 otherwise.
+void marqueeBegin(const char* text, uint16_t length) {
+    uint16_t glyphs = utf8Length(text, length);
+    uint8_t size = 2;
+    uint32_t width = (uint32_t)glyphs * glyphAdvance(font5x8, size) + MARQUEE_GAP;
+    if (width * size > MARQUEE_STRIP_BYTES) {
+        size = 1;
+        width = (uint32_t)glyphs * glyphAdvance(font5x8, size) + MARQUEE_GAP;
+    }
+    if (width > MARQUEE_STRIP_BYTES) width = MARQUEE_STRIP_BYTES;
+    if (width < FB_WIDTH) width = FB_WIDTH;
+
+    marqueeWidth = width;
+    marqueePages = size;
+    marqueeTop = (FB_PAGES - size) / 2;
+    memset(marqueeStrip, 0, marqueeWidth * marqueePages);
+
+    uint8_t advance = glyphAdvance(font5x8, size);
+    const char* p = text;
+    const char* end = text + length;
+    uint16_t x = 0;
+    while (p < end && x + advance <= marqueeWidth - MARQUEE_GAP) {
+        uint32_t cp = utf8Next(p, end);
+        if (cp != ' ' && cp != '\n') marqueeDrawGlyph(x, cp, size);
+        x += advance;
+    }
+
+    marqueeStart = millis();
+    marqueeLastFrame = marqueeStart - MARQUEE_FRAME_MS;
+}
+
+// If a frame is due, copy the current window of the strip into the
+// framebuffer (clearing the rest of the screen first when `full`) and
+// return true
+bool marqueeUpdate(bool full) {
+    unsigned long now = millis();
+    if (now - marqueeLastFrame < MARQUEE_FRAME_MS) return false;
+    marqueeLastFrame = now;
+
+    uint16_t offset = (uint64_t)(now - marqueeStart) * MARQUEE_SPEED / 1000 % marqueeWidth;
+    if (full) display.clearDisplay();
+
+    uint8_t* fb = fbBuffer();
+    for (uint8_t page = 0; page < marqueePages; page++) {
+        uint8_t* dst = fb + (marqueeTop + page) * FB_WIDTH;
+        const uint8_t* row = marqueeStrip + page * marqueeWidth;
+        uint16_t first = marqueeWidth - offset;
+        if (first > FB_WIDTH) first = FB_WIDTH;
+        memcpy(dst, row + offset, first);
+        if (first < FB_WIDTH) memcpy(dst + first, row, FB_WIDTH - first);  // Wrap around
+    }
+    return true;
+}
+
+// Push just the strip's pages
+void marqueePush() {
+    fbPushPages(fbBuffer(), marqueeTop, marqueeTop + marqueePages - 1, 0, FB_WIDTH - 1);
+}
+
+#endif // MARQUEE_H
@@ -0,0 +1,230 @@
+#ifndef MESSAGE_QUEUE_H
+#define MESSAGE_QUEUE_H
+
+#include <Arduino.h>
+#include "tokenizer.h"
+
+// Bounded queue of on-screen messages.
+//
+// Fixed slots, no heap: each message carries a priority, a time-to-live and
+// how long it stays up per turn. The screen rotates through live messages
+// (new arrivals first, most important first, then round-robin) and the
+// caller falls back to the current mode once everything has expired. When the
+// queue is full a new message evicts the least important one, so a burst of
+// notifications never blocks newer ones and never pins the screen.
+
+#define MESSAGE_QUEUE_SLOTS     8
+#define MESSAGE_TEXT_MAX        160      // Bytes per message, terminator included
+#define MESSAGE_DEFAULT_TTL     60000    // ms
+#define MESSAGE_DEFAULT_SHOW    5000     // ms on screen per turn
+#define MESSAGE_MAX_TTL         86400    // s; keeps expires within millis()' signed range
+
+enum MessagePriority {
+    MESSAGE_PRIORITY_LOW,
+    MESSAGE_PRIORITY_NORMAL,
+    MESSAGE_PRIORITY_HIGH
+};
+
+struct QueuedMessage {
+    char text[MESSAGE_TEXT_MAX];
+    bool used;
+    uint8_t priority;
+    uint32_t seq;               // Arrival order
+    bool shown;                 // Has had at least one turn
+    uint32_t expires;           // millis() when it drops out, wrapping like it
+    uint16_t duration;          // ms per turn
+};
+
+QueuedMessage messageQueue[MESSAGE_QUEUE_SLOTS];
+int8_t messageCurrent = -1;     // Slot on screen, -1 = none
+unsigned long messageShownAt = 0;
+uint32_t messageNextSeq = 0;
+
+uint8_t messageCount() {
+    uint8_t n = 0;
+    for (uint8_t i = 0; i < MESSAGE_QUEUE_SLOTS; i++) {
+        if (messageQueue[i].used) n++;
+    }
+    return n;
+}
+
+void messageRemove(int8_t slot) {
+    if (slot < 0) return;
+    messageQueue[slot].used = false;
+    if (slot == messageCurrent) messageCurrent = -1;
+}
+
+void messageClearAll() {
+    for (uint8_t i = 0; i < MESSAGE_QUEUE_SLOTS; i++) {
+        messageQueue[i].used = false;
+    }
+    messageCurrent = -1;
+}
+
+// Queue `length` bytes of text. A message already in the queue with the
+// same text is refreshed instead of duplicated. Returns false only if the
+// queue is full of messages more important than this one.
+bool messagePush(const char* text, uint16_t length, uint8_t priority = MESSAGE_PRIORITY_NORMAL,
+                 unsigned long ttl = MESSAGE_DEFAULT_TTL, uint16_t duration = MESSAGE_DEFAULT_SHOW) {
+    // Trim to the slot size without cutting a UTF-8 sequence in half
+    if (length > MESSAGE_TEXT_MAX - 1) {
+        length = MESSAGE_TEXT_MAX - 1;
+        while (length > 0 && ((uint8_t)text[length] & 0xC0) == 0x80) length--;
+    }
+    unsigned long now = millis();
+
+    int8_t slot = -1;
+    for (uint8_t i = 0; i < MESSAGE_QUEUE_SLOTS; i++) {
+        QueuedMessage& m = messageQueue[i];
+        if (m.used && strncmp(m.text, text, length) == 0 && m.text[length] == '\0') {
+            slot = i;
+            break;
+        }
+    }
+    if (slot < 0) {
+        for (uint8_t i = 0; i < MESSAGE_QUEUE_SLOTS; i++) {
+            if (!messageQueue[i].used) {
+                slot = i;
+                break;
+            }
+        }
+    }
+    if (slot < 0) {
+        // Full: evict the lowest priority message, the oldest among equals
+        for (uint8_t i = 0; i < MESSAGE_QUEUE_SLOTS; i++) {
+            const QueuedMessage& m = messageQueue[i];
+            if (slot < 0 || m.priority < messageQueue[slot].priority ||
+                (m.priority == messageQueue[slot].priority && m.seq < messageQueue[slot].seq)) {
+                slot = i;
+            }
+        }
+        if (messageQueue[slot].priority > priority) return false;
+        messageRemove(slot);
+    }
+
+    QueuedMessage& m = messageQueue[slot];
+    if (!m.used) {
+        memcpy(m.text, text, length);
+        m.text[length] = '\0';
+        m.seq = messageNextSeq++;
+        m.priority = priority;
+        m.shown = false;
+        m.used = true;
+    } else if (priority > m.priority) {
+        m.priority = priority;
+    }
+    m.expires = (uint32_t)(now + ttl);
+    m.duration = duration;
+    return true;
+}
+
+// Next message to show after `after`. Messages that haven't been on screen
+// yet go first, most important then oldest; after that everything takes
+// turns in arrival order, wrapping round.
+int8_t messagePickNext(int8_t after) {
+    int8_t best = -1;
+    for (uint8_t i = 0; i < MESSAGE_QUEUE_SLOTS; i++) {
+        const QueuedMessage& m = messageQueue[i];
+        if (!m.used || m.shown) continue;
+        if (best < 0 || m.priority > messageQueue[best].priority ||
+            (m.priority == messageQueue[best].priority && m.seq < messageQueue[best].seq)) {
+            best = i;
+        }
+    }
+    if (best >= 0) return best;
+
+    uint32_t afterSeq = after >= 0 ? messageQueue[after].seq : 0;
+    int8_t first = -1;      // Oldest overall, for wrapping round
+    for (uint8_t i = 0; i < MESSAGE_QUEUE_SLOTS; i++) {
+        const QueuedMessage& m = messageQueue[i];
+        if (!m.used) continue;
+        if (first < 0 || m.seq < messageQueue[first].seq) first = i;
+        if (after >= 0 && m.seq > afterSeq &&
+            (best < 0 || m.seq < messageQueue[best].seq)) {
+            best = i;
+        }
+    }
+    return best >= 0 ? best : first;
+}
+
+// Expire old messages and advance the rotation. Returns the text to show,
+// or nullptr when the queue is empty. Call every loop.
+const char* messageUpdate() {
+    unsigned long now = millis();
+    for (uint8_t i = 0; i < MESSAGE_QUEUE_SLOTS; i++) {
+        if (messageQueue[i].used && (int32_t)((uint32_t)now - messageQueue[i].expires) >= 0) {
+            messageRemove(i);
+        }
+    }
+
+    int8_t next = messagePickNext(messageCurrent);
+    if (next < 0) {
+        messageCurrent = -1;
+        return nullptr;
+    }
+
+    // Move on when the turn is up, or straight away for a more important
+    // new arrival. With a single message left, next is the current one.
+    bool turnOver = messageCurrent < 0 ||
+                    now - messageShownAt >= messageQueue[messageCurrent].duration ||
+                    (!messageQueue[next].shown &&
+                     messageQueue[next].priority > messageQueue[messageCurrent].priority);
+    if (turnOver) {
+        messageCurrent = next;
+        messageShownAt = now;
+        messageQueue[next].shown = true;
+    }
+    return messageCurrent >= 0 ? messageQueue[messageCurrent].text : nullptr;
+}
+
+// Queue the payload of a "message:" command: optional "[key=value ...]"
+// options, then the text. Keys: p (low, normal, high), ttl (seconds, up to
+// a day) and show (seconds, up to a minute). An empty payload clears the
+// queue.
+bool messageQueueCommand(TextSpan payload, String& reply) {
+    payload = spanTrim(payload);
+    if (spanEmpty(payload)) {
+        messageClearAll();
+        reply = "Messages cleared";
+        return true;
+    }
+
+    uint8_t priority = MESSAGE_PRIORITY_NORMAL;
+    unsigned long ttl = MESSAGE_DEFAULT_TTL;
+    uint16_t duration = MESSAGE_DEFAULT_SHOW;
+
+    int close = spanStartsWith(payload, "[") ? spanIndexOf(payload, ']') : -1;
+    if (close > 0) {
+        TextSpan options = TextSpan{payload.data + 1, (uint16_t)(close - 1)};
+        payload = spanTrim(spanSkip(payload, close + 1));
+
+        TextSpan option;
+        while (spanSplit(options, ' ', option)) {
+            TextSpan key;
+            spanSplit(option, '=', key);
+            if (spanEmpty(key) || spanExhausted(option)) continue;
+            long value;
+            if (spanEquals(key, "p")) {
+                if (spanEquals(option, "low")) priority = MESSAGE_PRIORITY_LOW;
+                else if (spanEquals(option, "high")) priority = MESSAGE_PRIORITY_HIGH;
+                else priority = MESSAGE_PRIORITY_NORMAL;
+            } else if (spanEquals(key, "ttl") && spanToLong(option, value) && value > 0) {
+                ttl = constrain(value, 1, MESSAGE_MAX_TTL) * 1000UL;
+            } else if (spanEquals(key, "show") && spanToLong(option, value) && value > 0) {
+                duration = constrain(value, 1, 60) * 1000;
+            }
+        }
+    }
+    if (spanEmpty(payload)) {
+        reply = "Message text is empty";
+        return false;
+    }
+    if (!messagePush(payload.data, payload.length, priority, ttl, duration)) {
+        reply = "Message dropped: queue full of higher priority messages";
+        return false;
+    }
+    reply = "Message queued (" + String(messageCount()) + " in queue)";
+    return true;
+}
+
+#endif // MESSAGE_QUEUE_H
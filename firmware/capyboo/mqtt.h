@@ -1,10 +1,12 @@
 #ifndef MQTT_H
 #define MQTT_H
 
+#include <atomic>
 #include <PubSubClient.h>
 #include <WiFi.h>
 #include <WiFiClientSecure.h>
 #include "secrets.h"  // MQTT credentials
+#include "tokenizer.h"
 
 // MQTT Client object
 WiFiClientSecure espClient;
@@ -19,19 +21,54 @@ const char* MQTT_TOPIC_PUBLISH = "capyboo/status";      // Topic to publish stat
 
 // MQTT connection state
 bool mqttConnected = false;
-String lastReceivedMessage = "";
+
+// Connecting (DNS, TCP, TLS handshake, CONNACK) takes seconds even when
+// the broker answers, and up to the timeouts below when it doesn't, so on
+// the ESP32 it runs on a task of its own: loop() starts an attempt and
+// picks up the result, and leaves mqttClient alone in between. Failed
+// attempts back off, doubling from MQTT_RETRY_MIN to MQTT_RETRY_MAX.
+#define MQTT_CONNECT_TIMEOUT  5         // s, for the TLS handshake and for CONNACK
+#define MQTT_RETRY_MIN        5000      // ms
+#define MQTT_RETRY_MAX        300000    // ms
+#define MQTT_TASK_STACK       8192
+
+std::atomic<bool> mqttConnecting{false};  // The connect task owns mqttClient
+bool mqttAttemptStarted = false;
+bool mqttAttemptOk = false;               // Written by the task before it hands back
+unsigned long mqttLastAttempt = 0;        // millis() the last attempt finished
+unsigned long mqttRetryDelay = 0;         // 0 until an attempt fails
+#ifdef ESP32
+TaskHandle_t mqttTask = nullptr;
+void mqttConnectTask(void*);
+#endif
+
+// Last command received, kept until the router has handled it. The
+// callback runs inside mqttClient.loop(), which handles one packet per
+// call, so one slot is enough.
+#define MQTT_MAX_COMMAND_LENGTH 256
+char mqttCommand[MQTT_MAX_COMMAND_LENGTH + 1];
+uint16_t mqttCommandLength = 0;
+bool mqttCommandPending = false;
 
 // MQTT Callback function - called when a message is received
 void mqttCallback(char* topic, byte* payload, unsigned int length) {
     Serial.print("Message received on topic: ");
     Serial.println(topic);
-    Serial.print("Message: ");
-    
-    lastReceivedMessage = "";
-    for (int i = 0; i < length; i++) {
-        lastReceivedMessage += (char)payload[i];
+
+    if (length > MQTT_MAX_COMMAND_LENGTH) {
+        Serial.println("MQTT command too long, ignored");
+        return;
+    }
+    if (mqttCommandPending) {
+        Serial.println("MQTT command replaced before it was handled");
     }
-    Serial.println(lastReceivedMessage);
+    memcpy(mqttCommand, payload, length);
+    mqttCommand[length] = '\0';
+    mqttCommandLength = length;
+    mqttCommandPending = true;
+
+    Serial.print("Message: ");
+    Serial.println(mqttCommand);
 }
 
 // Initialize MQTT connection
@@ -43,8 +80,15 @@ bool initMQTT() {
     // For testing, you can skip certificate validation (not recommended for production)
     espClient.setInsecure();
     
+    espClient.setHandshakeTimeout(MQTT_CONNECT_TIMEOUT);
+    mqttClient.setSocketTimeout(MQTT_CONNECT_TIMEOUT);
     mqttClient.setServer(MQTT_BROKER, MQTT_PORT);
     mqttClient.setCallback(mqttCallback);
+
+#ifdef ESP32
+    // Core 0, away from loop() on core 1
+    xTaskCreatePinnedToCore(mqttConnectTask, "mqtt", MQTT_TASK_STACK, nullptr, 1, &mqttTask, 0);
+#endif
     
     Serial.println("MQTT client initialized");
     return true;
@@ -70,7 +114,6 @@ bool connectMQTT() {
     // Attempt to connect
     if (mqttClient.connect(clientId.c_str(), MQTT_USERNAME, MQTT_PASSWORD)) {
         Serial.println("Connected to MQTT broker!");
-        mqttConnected = true;
         
         // Subscribe to command topic
         if (mqttClient.subscribe(MQTT_TOPIC_SUBSCRIBE)) {
@@ -84,17 +127,37 @@ bool connectMQTT() {
     } else {
         Serial.print("Failed to connect to MQTT broker. Error code: ");
         Serial.println(mqttClient.state());
-        mqttConnected = false;
         return false;
     }
 }
 
-// Publish a message to MQTT
+#ifdef ESP32
+void mqttConnectTask(void*) {
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        mqttAttemptOk = connectMQTT();
+        mqttConnecting.store(false, std::memory_order_release);
+    }
+}
+#endif
+
+// Hand mqttClient to the connect task for one attempt (on the host, where
+// connecting never blocks, make it here)
+void mqttStartConnect() {
+    mqttAttemptStarted = true;
+    mqttConnecting.store(true, std::memory_order_release);
+#ifdef ESP32
+    xTaskNotifyGive(mqttTask);
+#else
+    mqttAttemptOk = connectMQTT();
+    mqttConnecting.store(false, std::memory_order_release);
+#endif
+}
+
+// Publish a message to MQTT. Never connects: that happens in handleMQTT()
 bool publishMQTT(const char* topic, const char* message) {
-    if (!mqttClient.connected()) {
-        if (!connectMQTT()) {
-            return false;
-        }
+    if (mqttConnecting.load(std::memory_order_acquire) || !mqttConnected || !mqttClient.connected()) {
+        return false;
     }
     
     bool result = mqttClient.publish(topic, message);
@@ -116,29 +179,60 @@ bool publishStatus(const char* status) {
 
 // Check if a message was received
 bool mqttMessageAvailable() {
-    return lastReceivedMessage.length() > 0;
+    return mqttCommandPending;
+}
+
+// The pending command in place; release it once handled
+bool mqttCommandPeek(TextSpan& command) {
+    if (!mqttCommandPending) return false;
+    command = spanOf(mqttCommand, mqttCommandLength);
+    return true;
+}
+
+void mqttCommandRelease() {
+    mqttCommandPending = false;
 }
 
 // Get the last received message
 String getMQTTMessage() {
-    String msg = lastReceivedMessage;
-    lastReceivedMessage = "";  // Clear after reading
+    String msg = mqttCommandPending ? String(mqttCommand) : String("");
+    mqttCommandPending = false;  // Clear after reading
     return msg;
 }
 
-// Handle MQTT connection (call this in loop)
+// Handle MQTT connection (call this in loop). Never waits on the network.
 void handleMQTT() {
-    if (!mqttClient.connected()) {
-        mqttConnected = false;
-        // Try to reconnect every 5 seconds
-        static unsigned long lastReconnectAttempt = 0;
-        unsigned long now = millis();
-        if (now - lastReconnectAttempt > 5000) {
-            lastReconnectAttempt = now;
-            connectMQTT();
+    // The connect task has the client
+    if (mqttConnecting.load(std::memory_order_acquire)) return;
+
+    unsigned long now = millis();
+    if (mqttAttemptStarted) {
+        mqttAttemptStarted = false;
+        mqttConnected = mqttAttemptOk;
+        mqttLastAttempt = now;
+        if (mqttAttemptOk) {
+            mqttRetryDelay = 0;
+        } else {
+            mqttRetryDelay = mqttRetryDelay == 0 ? MQTT_RETRY_MIN : min(mqttRetryDelay * 2, (unsigned long)MQTT_RETRY_MAX);
         }
-    } else {
+    }
+
+    // Nothing to do until WiFi is up
+    if (WiFi.status() != WL_CONNECTED) {
+        mqttConnected = false;
+        return;
+    }
+    if (mqttClient.connected()) {
         mqttClient.loop();  // Process incoming messages - this calls the callback
+        return;
+    }
+    if (mqttConnected) {
+        // Dropped: reconnect straight away, then back off if that fails
+        mqttConnected = false;
+        mqttRetryDelay = 0;
+    }
+    if (now - mqttLastAttempt >= mqttRetryDelay) {
+        mqttStartConnect();
     }
 }
 
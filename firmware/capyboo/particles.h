@@ -0,0 +1,202 @@
+#ifndef PARTICLES_H
+#define PARTICLES_H
+
+#include "framebuffer.h"
+
+// Fixed-pool particle system for overlay effects (floating hearts, tears,
+// rain, snow). The pool is structure-of-arrays with no allocation: dead
+// particles are removed by moving the last live one into their slot.
+// Positions and velocities are fixed point (PARTICLE_FP_SHIFT fractional
+// bits) and the simulation runs in fixed PARTICLE_STEP_MS steps, so the
+// motion looks the same whatever the frame rate.
+
+#define PARTICLE_CAPACITY   32
+#define PARTICLE_FP_SHIFT   6      // 1/64 px
+#define PARTICLE_FP_ONE     (1 << PARTICLE_FP_SHIFT)
+#define PARTICLE_STEP_MS    16
+#define PARTICLE_MAX_STEPS  4      // Catch-up limit after a long blocking call
+
+enum ParticleKind {
+    PARTICLE_HEART,
+    PARTICLE_TEAR,
+    PARTICLE_RAIN,
+    PARTICLE_SNOW
+};
+
+enum ParticleEffect {
+    EFFECT_NONE,
+    EFFECT_HEARTS,
+    EFFECT_TEARS,
+    EFFECT_RAIN,
+    EFFECT_SNOW
+};
+
+// 1-bit sprites, column-major, one page tall (bit 0 = top row)
+const unsigned char particle_heart[] PROGMEM = {0x06, 0x0F, 0x1F, 0x3E, 0x1F, 0x0F, 0x06}; // 7x6
+const unsigned char particle_tear[]  PROGMEM = {0x0C, 0x1F, 0x0C};                         // 3x5
+const unsigned char particle_rain[]  PROGMEM = {0x0F};                                     // 1x4
+const unsigned char particle_snow[]  PROGMEM = {0x02, 0x07, 0x02};                         // 3x3
+
+struct ParticleSprite {
+    const unsigned char* data;
+    uint8_t w;
+    uint8_t h;
+};
+
+// Indexed by ParticleKind
+const ParticleSprite PARTICLE_SPRITES[] = {
+    {particle_heart, 7, 6},
+    {particle_tear, 3, 5},
+    {particle_rain, 1, 4},
+    {particle_snow, 3, 3}
+};
+
+struct ParticlePool {
+    int16_t x[PARTICLE_CAPACITY];     // Fixed point
+    int16_t y[PARTICLE_CAPACITY];
+    int16_t vx[PARTICLE_CAPACITY];    // Fixed point px per step
+    int16_t vy[PARTICLE_CAPACITY];
+    int16_t ay[PARTICLE_CAPACITY];    // Vertical acceleration per step
+    uint16_t life[PARTICLE_CAPACITY]; // Steps left
+    uint8_t kind[PARTICLE_CAPACITY];
+    uint8_t count;
+};
+
+ParticlePool particles;
+uint8_t particleEffect = EFFECT_NONE;
+unsigned long particleLastStep = 0;
+uint16_t particleSpawnTimer = 0;   // Steps until the next spawn
+
+void particlesClear() {
+    particles.count = 0;
+}
+
+void particlesSetEffect(uint8_t effect) {
+    if (effect == particleEffect) return;
+    particleEffect = effect;
+    particleSpawnTimer = 0;
+    particleLastStep = millis();
+}
+
+// Effect for a weather description from the app or OpenWeatherMap
+uint8_t weatherParticleEffect(const String& desc) {
+    if (desc.indexOf("snow") >= 0 || desc.indexOf("sleet") >= 0) {
+        return EFFECT_SNOW;
+    }
+    if (desc.indexOf("rain") >= 0 || desc.indexOf("drizzle") >= 0 ||
+        desc.indexOf("shower") >= 0 || desc.indexOf("thunder") >= 0) {
+        return EFFECT_RAIN;
+    }
+    return EFFECT_NONE;
+}
+
+// Add a particle (pixel coordinates, fixed-point velocities); dropped if the
+// pool is full
+void particleSpawn(uint8_t kind, int16_t x, int16_t y, int16_t vx, int16_t vy, int16_t ay, uint16_t life) {
+    if (particles.count >= PARTICLE_CAPACITY) return;
+    uint8_t i = particles.count++;
+    particles.x[i] = x << PARTICLE_FP_SHIFT;
+    particles.y[i] = y << PARTICLE_FP_SHIFT;
+    particles.vx[i] = vx;
+    particles.vy[i] = vy;
+    particles.ay[i] = ay;
+    particles.life[i] = life;
+    particles.kind[i] = kind;
+}
+
+// Emit new particles for the active effect; returns steps until the next spawn
+uint16_t particlesEmit() {
+    switch (particleEffect) {
+        case EFFECT_HEARTS:
+            // Float up from the bottom edge with a little sideways drift
+            particleSpawn(PARTICLE_HEART, random(4, FB_WIDTH - 10), FB_HEIGHT,
+                          random(-12, 13), -random(32, 64), 0, 150);
+            return random(12, 30);
+        case EFFECT_TEARS: {
+            // Drip from under either eye and fall under gravity
+            int16_t x = random(0, 2) ? random(24, 40) : random(86, 100);
+            particleSpawn(PARTICLE_TEAR, x, 32, random(-6, 7), 16, 6, 90);
+            return random(6, 16);
+        }
+        case EFFECT_RAIN:
+            // Fast, slanted streaks from the top edge
+            particleSpawn(PARTICLE_RAIN, random(0, FB_WIDTH + 16), -4, -24, random(150, 200), 0, 40);
+            return random(1, 3);
+        case EFFECT_SNOW:
+            particleSpawn(PARTICLE_SNOW, random(0, FB_WIDTH), -3, random(-10, 11), random(16, 32), 0, 300);
+            return random(6, 14);
+        default:
+            return 0;
+    }
+}
+
+// One fixed simulation step
+void particlesStep() {
+    if (particleEffect != EFFECT_NONE) {
+        if (particleSpawnTimer == 0) {
+            particleSpawnTimer = particlesEmit();
+        } else {
+            particleSpawnTimer--;
+        }
+    }
+
+    uint8_t i = 0;
+    while (i < particles.count) {
+        particles.vy[i] += particles.ay[i];
+        particles.x[i] += particles.vx[i];
+        particles.y[i] += particles.vy[i];
+        if (particles.kind[i] == PARTICLE_SNOW && random(0, 8) == 0) {
+            particles.vx[i] = random(-10, 11);   // Flutter
+        }
+
+        int16_t py = particles.y[i] >> PARTICLE_FP_SHIFT;
+        bool dead = particles.life[i] == 0 || py > FB_HEIGHT + 8 || py < -16;
+        if (dead) {
+            // Swap-remove: move the last particle into this slot
+            uint8_t last = --particles.count;
+            particles.x[i] = particles.x[last];
+            particles.y[i] = particles.y[last];
+            particles.vx[i] = particles.vx[last];
+            particles.vy[i] = particles.vy[last];
+            particles.ay[i] = particles.ay[last];
+            particles.life[i] = particles.life[last];
+            particles.kind[i] = particles.kind[last];
+            continue;
+        }
+        particles.life[i]--;
+        i++;
+    }
+}
+
+// Advance the simulation to now
+void particlesUpdate() {
+    unsigned long now = millis();
+    uint8_t steps = 0;
+    while (now - particleLastStep >= PARTICLE_STEP_MS) {
+        if (steps++ >= PARTICLE_MAX_STEPS) {
+            particleLastStep = now;
+            break;
+        }
+        particlesStep();
+        particleLastStep += PARTICLE_STEP_MS;
+    }
+}
+
+// Draw all live particles into the framebuffer
+void particlesRender() {
+    for (uint8_t i = 0; i < particles.count; i++) {
+        const ParticleSprite& sprite = PARTICLE_SPRITES[particles.kind[i]];
+        int16_t x = (particles.x[i] >> PARTICLE_FP_SHIFT) - sprite.w / 2;
+        int16_t y = (particles.y[i] >> PARTICLE_FP_SHIFT) - sprite.h / 2;
+        fbBlitColumns(x, y, sprite.data, sprite.w, 1, sprite.w, FB_BLIT_OR);
+    }
+}
+
+// Update and draw in one go; used by display_present()
+void particlesOverlay() {
+    if (particleEffect == EFFECT_NONE && particles.count == 0) return;
+    particlesUpdate();
+    particlesRender();
+}
+
+#endif // PARTICLES_H
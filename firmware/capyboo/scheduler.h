@@ -0,0 +1,457 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <Preferences.h>
+#include "clock.h"
+#include "tokenizer.h"
+
+// Timers, alarms and recurring events.
+//
+// Events live in a fixed-capacity binary min-heap ordered by a 64-bit
+// deadline on the monotonic timebase, so the per-loop check is a single
+// comparison against the root; adding, firing and cancelling cost
+// O(log n). Every event also remembers its local wall-clock time (seconds
+// since 1970, 0 while the clock isn't set): when the clock is set or
+// stepped (clockGeneration changes) deadlines are recomputed from it, and
+// it is what survives a reboot, since the timebase starts again from zero.
+//
+// When the clock steps forward (NTP, a new time zone, "time:") an alarm
+// whose time was skipped over fires once straight away rather than waiting
+// for the next day. A step backwards keeps an alarm's next time, so one
+// that has just fired doesn't fire again when NTP pulls the clock back
+// across it; only a step of more than a day brings it forward. Timers that
+// came due fire at once. Repeating events keep their alignment and skip
+// the repeats stepped over, as after a reboot.
+//
+//   timer  fires once, a given time from now
+//   alarm  fires every day at HH:MM (needs the clock)
+//   every  fires repeatedly with a fixed period
+//
+// Each event carries an action (mood, animation, melody or message) that
+// the sketch carries out; see fireScheduledEvent() in capyboo.ino.
+
+#define SCHEDULER_CAPACITY     16
+#define SCHEDULER_ARG_MAX      48      // Action argument, terminator included
+#define SCHEDULER_MIN_PERIOD   10      // s, shortest "every"
+#define SCHEDULER_UNSCHEDULED  UINT64_MAX  // Waiting for the clock
+#define SCHEDULER_PREFS_VERSION 1
+
+enum ScheduleKind {
+    SCHEDULE_TIMER,
+    SCHEDULE_ALARM,
+    SCHEDULE_EVERY
+};
+
+enum ScheduleAction {
+    SCHEDULE_ACTION_MOOD,
+    SCHEDULE_ACTION_ANIMATION,
+    SCHEDULE_ACTION_MELODY,
+    SCHEDULE_ACTION_MESSAGE
+};
+
+struct ScheduledEvent {
+    uint64_t deadline;          // timebaseMillis() when it fires
+    int64_t wall;               // Local time it fires, s since 1970 (0 = clock unknown)
+    uint32_t period;            // s between repeats; alarms: second of the day
+    uint8_t id;
+    uint8_t kind;
+    uint8_t action;
+    char arg[SCHEDULER_ARG_MAX];
+};
+
+// Checks an action's argument (mood, animation or melody name);
+// defined in capyboo.ino
+bool scheduleActionValid(uint8_t action, const char* arg);
+
+ScheduledEvent schedulerHeap[SCHEDULER_CAPACITY];
+uint8_t schedulerCount = 0;
+uint8_t schedulerNextId = 1;
+uint32_t schedulerClockGeneration = UINT32_MAX;   // Forces a rebase on first poll
+Preferences schedulerPrefs;
+
+// ---------------------------------------------------------------------------
+// Heap
+
+inline void schedulerSwap(uint8_t a, uint8_t b) {
+    ScheduledEvent t = schedulerHeap[a];
+    schedulerHeap[a] = schedulerHeap[b];
+    schedulerHeap[b] = t;
+}
+
+void schedulerSiftUp(uint8_t i) {
+    while (i > 0) {
+        uint8_t parent = (i - 1) / 2;
+        if (schedulerHeap[parent].deadline <= schedulerHeap[i].deadline) break;
+        schedulerSwap(parent, i);
+        i = parent;
+    }
+}
+
+void schedulerSiftDown(uint8_t i) {
+    while (true) {
+        uint8_t left = 2 * i + 1;
+        uint8_t right = left + 1;
+        uint8_t smallest = i;
+        if (left < schedulerCount && schedulerHeap[left].deadline < schedulerHeap[smallest].deadline) smallest = left;
+        if (right < schedulerCount && schedulerHeap[right].deadline < schedulerHeap[smallest].deadline) smallest = right;
+        if (smallest == i) break;
+        schedulerSwap(i, smallest);
+        i = smallest;
+    }
+}
+
+void schedulerRemoveAt(uint8_t i) {
+    schedulerCount--;
+    if (i == schedulerCount) return;
+    schedulerHeap[i] = schedulerHeap[schedulerCount];
+    schedulerSiftUp(i);
+    schedulerSiftDown(i);
+}
+
+// ---------------------------------------------------------------------------
+// Deadlines
+
+// Timebase deadline for a wall-clock time (now, if it has passed)
+uint64_t schedulerDeadlineAt(int64_t wall) {
+    uint64_t now = timebaseMillis();
+    int64_t ahead = wall * 1000 - clockEpochMillis();
+    return ahead > 0 ? now + ahead : now;
+}
+
+// Next local time of day `secondOfDay`, strictly after now
+int64_t schedulerNextAlarm(uint32_t secondOfDay) {
+    int64_t now = clockEpochNow();
+    int64_t wall = now - ((now % 86400) + 86400) % 86400 + secondOfDay;
+    if (wall <= now) wall += 86400;
+    return wall;
+}
+
+// Work out one event's deadline from its wall time after the clock changed
+void schedulerRebaseEvent(ScheduledEvent& e) {
+    // Scheduled against the clock as it was, rather than restored at boot
+    bool live = e.wall != 0 && e.deadline != SCHEDULER_UNSCHEDULED;
+    if (!timeInitialized) {
+        // Wall-clock events wait; countdowns keep running on the timebase
+        if (e.wall != 0 || e.kind == SCHEDULE_ALARM) e.deadline = SCHEDULER_UNSCHEDULED;
+        return;
+    }
+    if (e.wall == 0 && e.kind != SCHEDULE_ALARM) {
+        // Set before the clock was known: pin it to the wall clock from now on
+        uint64_t now = timebaseMillis();
+        e.wall = clockEpochNow() + (int64_t)(e.deadline - min(e.deadline, now)) / 1000;
+        return;
+    }
+
+    int64_t now = clockEpochNow();
+    if (e.kind == SCHEDULE_ALARM) {
+        // Stepped past it: leave it due now, schedulerPoll() moves it on.
+        // Stepped back: the occurrence before e.wall has already fired
+        // unless the step was more than a day.
+        int64_t next = schedulerNextAlarm(e.period);
+        if (!live || e.wall > next + 86400) e.wall = next;
+    } else if (e.kind == SCHEDULE_EVERY && e.wall <= now) {
+        // Skip the repeats missed while off
+        e.wall += ((now - e.wall) / e.period + 1) * e.period;
+    }
+    // A timer that came due while off fires straight away
+    e.deadline = schedulerDeadlineAt(e.wall);
+}
+
+void schedulerSave();
+
+void schedulerRebase() {
+    schedulerClockGeneration = clockGeneration;
+    bool pinned = false;
+    for (uint8_t i = 0; i < schedulerCount; i++) {
+        bool hadWall = schedulerHeap[i].wall != 0;
+        schedulerRebaseEvent(schedulerHeap[i]);
+        if (!hadWall && schedulerHeap[i].wall != 0) pinned = true;
+    }
+    for (int8_t i = schedulerCount / 2 - 1; i >= 0; i--) {
+        schedulerSiftDown(i);
+    }
+    // Wall times are what a reboot restores, so store newly pinned ones
+    if (pinned) schedulerSave();
+}
+
+// ---------------------------------------------------------------------------
+// Persistence
+
+// Events are stored as one blob. Wall times are what matter after a
+// reboot; for events without one the deadline field holds the ms that
+// were left instead.
+void schedulerSave() {
+    ScheduledEvent saved[SCHEDULER_CAPACITY];
+    uint64_t now = timebaseMillis();
+    for (uint8_t i = 0; i < schedulerCount; i++) {
+        saved[i] = schedulerHeap[i];
+        if (saved[i].wall == 0 && saved[i].deadline != SCHEDULER_UNSCHEDULED) {
+            saved[i].deadline -= min(saved[i].deadline, now);
+        }
+    }
+    schedulerPrefs.putUChar("version", SCHEDULER_PREFS_VERSION);
+    schedulerPrefs.putUChar("next_id", schedulerNextId);
+    schedulerPrefs.putBytes("events", saved, schedulerCount * sizeof(ScheduledEvent));
+}
+
+void initScheduler() {
+    schedulerPrefs.begin("scheduler", false);
+    schedulerCount = 0;
+    if (schedulerPrefs.getUChar("version", 0) != SCHEDULER_PREFS_VERSION) return;
+
+    schedulerNextId = schedulerPrefs.getUChar("next_id", 1);
+    size_t bytes = schedulerPrefs.getBytes("events", schedulerHeap, sizeof(schedulerHeap));
+    schedulerCount = bytes / sizeof(ScheduledEvent);
+
+    uint64_t now = timebaseMillis();
+    for (uint8_t i = 0; i < schedulerCount; i++) {
+        ScheduledEvent& e = schedulerHeap[i];
+        if (e.wall != 0 || e.kind == SCHEDULE_ALARM) {
+            e.deadline = SCHEDULER_UNSCHEDULED;   // Rebased once the clock is known
+        } else if (e.deadline != SCHEDULER_UNSCHEDULED) {
+            e.deadline += now;
+        }
+    }
+    schedulerClockGeneration = UINT32_MAX;
+    schedulerRebase();
+
+    Serial.print("Scheduler: restored ");
+    Serial.print(schedulerCount);
+    Serial.println(" events");
+}
+
+// ---------------------------------------------------------------------------
+// Public API
+
+// Add an event; returns its id, or 0 if the scheduler is full or an alarm
+// was asked for before the clock is set
+uint8_t schedulerAdd(uint8_t kind, uint32_t seconds, uint8_t action, const char* arg) {
+    if (schedulerClockGeneration != clockGeneration) schedulerRebase();
+    if (schedulerCount == SCHEDULER_CAPACITY) return 0;
+    if (kind == SCHEDULE_ALARM && !timeInitialized) return 0;
+
+    ScheduledEvent& e = schedulerHeap[schedulerCount];
+    e.kind = kind;
+    e.action = action;
+    e.period = seconds;
+    strncpy(e.arg, arg, SCHEDULER_ARG_MAX - 1);
+    e.arg[SCHEDULER_ARG_MAX - 1] = '\0';
+
+    // Ids are small for typing over BLE; skip any still in use
+    bool taken = true;
+    while (taken) {
+        e.id = schedulerNextId++;
+        if (schedulerNextId == 0) schedulerNextId = 1;
+        taken = false;
+        for (uint8_t i = 0; i < schedulerCount; i++) {
+            if (schedulerHeap[i].id == e.id) taken = true;
+        }
+    }
+
+    if (kind == SCHEDULE_ALARM) {
+        e.wall = schedulerNextAlarm(seconds);
+        e.deadline = schedulerDeadlineAt(e.wall);
+    } else {
+        e.deadline = timebaseMillis() + (uint64_t)seconds * 1000;
+        e.wall = timeInitialized ? clockEpochNow() + seconds : 0;
+    }
+    schedulerCount++;
+    schedulerSiftUp(schedulerCount - 1);
+    schedulerSave();
+    return e.id;
+}
+
+bool schedulerCancel(uint8_t id) {
+    for (uint8_t i = 0; i < schedulerCount; i++) {
+        if (schedulerHeap[i].id == id) {
+            schedulerRemoveAt(i);
+            schedulerSave();
+            return true;
+        }
+    }
+    return false;
+}
+
+void schedulerClear() {
+    schedulerCount = 0;
+    schedulerSave();
+}
+
+// Call every loop: if the earliest event is due, copy it to `fired`,
+// reschedule or drop it, and return true. Call again until it returns
+// false to catch up with several due at once.
+bool schedulerPoll(ScheduledEvent& fired) {
+    if (schedulerClockGeneration != clockGeneration) schedulerRebase();
+    if (schedulerCount == 0 || schedulerHeap[0].deadline > timebaseMillis()) return false;
+
+    fired = schedulerHeap[0];
+    ScheduledEvent& e = schedulerHeap[0];
+    if (e.kind == SCHEDULE_TIMER) {
+        schedulerRemoveAt(0);
+        schedulerSave();
+        return true;
+    }
+
+    // Repeating: the next occurrence keeps its wall-clock alignment.
+    // Neither needs saving, both are worked out again after a reboot.
+    if (e.kind == SCHEDULE_ALARM) {
+        e.wall = schedulerNextAlarm(e.period);
+        e.deadline = schedulerDeadlineAt(e.wall);
+    } else {
+        e.deadline += (uint64_t)e.period * 1000;
+        if (e.wall != 0) e.wall += e.period;
+        if (e.deadline <= timebaseMillis()) {
+            e.deadline = timebaseMillis() + (uint64_t)e.period * 1000;   // Don't burst after a stall
+        }
+    }
+    schedulerSiftDown(0);
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Commands
+
+// Duration "SS", "MM:SS" or "HH:MM:SS" in seconds, or -1
+long schedulerParseDuration(TextSpan text) {
+    long total = 0;
+    uint8_t fields = 0;
+    TextSpan field;
+    while (spanSplit(text, ':', field)) {
+        long value;
+        if (++fields > 3 || field.length == 0 || field.data[0] == '-' || field.data[0] == '+' ||
+            !spanToLong(field, value) || value > 86400) {
+            return -1;
+        }
+        total = total * 60 + value;
+    }
+    return total;
+}
+
+const char* scheduleKindName(uint8_t kind) {
+    switch (kind) {
+        case SCHEDULE_ALARM: return "alarm";
+        case SCHEDULE_EVERY: return "every";
+        default: return "timer";
+    }
+}
+
+const char* scheduleActionName(uint8_t action) {
+    switch (action) {
+        case SCHEDULE_ACTION_MOOD: return "mood";
+        case SCHEDULE_ACTION_ANIMATION: return "anim";
+        case SCHEDULE_ACTION_MELODY: return "melody";
+        default: return "msg";
+    }
+}
+
+String schedulerList() {
+    if (schedulerCount == 0) return "No events scheduled";
+    String list = "";
+    uint64_t now = timebaseMillis();
+    for (uint8_t i = 0; i < schedulerCount; i++) {
+        const ScheduledEvent& e = schedulerHeap[i];
+        if (i > 0) list += "\n";
+        list += "#" + String(e.id) + " " + scheduleKindName(e.kind);
+        if (e.deadline == SCHEDULER_UNSCHEDULED) {
+            list += " waiting for clock";
+        } else {
+            list += " in " + String((uint32_t)((e.deadline - min(e.deadline, now)) / 1000)) + " s";
+        }
+        list += " " + String(scheduleActionName(e.action)) + "=" + e.arg;
+    }
+    return list;
+}
+
+// Handle "timer:", "alarm:" and "every:" commands. The payload is a time
+// ("SS", "MM:SS" or "HH:MM:SS"; alarms take "HH:MM") optionally followed
+// by an action: mood=<name>, anim=<name>, melody=<name> or msg=<text>.
+// Without one the event beeps and shows a message.
+bool schedulerCommand(uint8_t kind, TextSpan payload, String& reply) {
+    TextSpan what = spanTrim(payload);
+    TextSpan when;
+    spanSplit(what, ' ', when);
+    what = spanTrim(what);
+
+    long seconds;
+    if (kind == SCHEDULE_ALARM) {
+        long hour, minute;
+        if (!spanNextLong(when, ':', hour) || !spanNextLong(when, ':', minute) || !spanExhausted(when) ||
+            hour < 0 || hour > 23 || minute < 0 || minute > 59) {
+            reply = "Invalid alarm time. Use: alarm:HH:MM [action]";
+            return false;
+        }
+        if (!timeInitialized) {
+            reply = "Set the clock first (time: or ntp:)";
+            return false;
+        }
+        seconds = hour * 3600 + minute * 60;
+    } else {
+        seconds = schedulerParseDuration(when);
+        long minimum = kind == SCHEDULE_EVERY ? SCHEDULER_MIN_PERIOD : 1;
+        if (seconds < minimum) {
+            reply = String("Invalid duration. Use: ") + scheduleKindName(kind) + ":SS|MM:SS|HH:MM:SS [action]";
+            return false;
+        }
+    }
+
+    uint8_t action = SCHEDULE_ACTION_MESSAGE;
+    char arg[SCHEDULER_ARG_MAX];
+    strcpy(arg, kind == SCHEDULE_ALARM ? "Alarm!" : "Time's up!");
+    if (!spanEmpty(what)) {
+        TextSpan key;
+        spanSplit(what, '=', key);
+        if (spanEquals(key, "mood")) action = SCHEDULE_ACTION_MOOD;
+        else if (spanEquals(key, "anim")) action = SCHEDULE_ACTION_ANIMATION;
+        else if (spanEquals(key, "melody")) action = SCHEDULE_ACTION_MELODY;
+        else if (spanEquals(key, "msg")) action = SCHEDULE_ACTION_MESSAGE;
+        else {
+            reply = "Unknown action. Use: mood=<name>, anim=<name>, melody=<name> or msg=<text>";
+            return false;
+        }
+        size_t length = spanCopy(what, arg, sizeof(arg));
+        if (action != SCHEDULE_ACTION_MESSAGE) {
+            for (size_t i = 0; i < length; i++) arg[i] = spanLower(arg[i]);
+        }
+        if (length == 0 || !scheduleActionValid(action, arg)) {
+            reply = "Unknown " + String(scheduleActionName(action)) + ": " + arg;
+            return false;
+        }
+    }
+
+    uint8_t id = schedulerAdd(kind, seconds, action, arg);
+    if (id == 0) {
+        reply = "Scheduler full (" + String(SCHEDULER_CAPACITY) + " events)";
+        return false;
+    }
+    reply = String(scheduleKindName(kind)) + " #" + String(id) + " set";
+    return true;
+}
+
+// Handle "schedule:" commands: list, cancel <id>, clear
+bool schedulerManageCommand(TextSpan payload, String& reply) {
+    payload = spanTrim(payload);
+    if (spanEmpty(payload) || spanEquals(payload, "list")) {
+        reply = schedulerList();
+        return true;
+    }
+    if (spanEquals(payload, "clear")) {
+        schedulerClear();
+        reply = "All events cancelled";
+        return true;
+    }
+    if (spanStartsWith(payload, "cancel")) {
+        TextSpan idText = spanTrim(spanSkip(payload, 6));
+        if (spanStartsWith(idText, "#")) idText = spanSkip(idText, 1);
+        long id;
+        if (spanToLong(idText, id) && id > 0 && id < 256 && schedulerCancel(id)) {
+            reply = "Event #" + String(id) + " cancelled";
+            return true;
+        }
+        reply = "No event #" + spanString(idText);
+        return false;
+    }
+    reply = "Use: schedule:list, schedule:cancel <id> or schedule:clear";
+    return false;
+}
+
+#endif // SCHEDULER_H
@@ -0,0 +1,338 @@
+#ifndef SNTP_H
+#define SNTP_H
+
+#include <WiFi.h>
+#include <WiFiUdp.h>
+#include "clock.h"
+#include "tokenizer.h"
+
+// SNTP client with oscillator drift compensation.
+//
+// While WiFi is up, ntpUpdate() (called every loop) sends one 48-byte
+// request at a time and steps the clock to the server's time from the
+// reply. It doesn't wait for replies. The one thing that can block is the
+// DNS lookup of the server's name, so that is done once and the address
+// kept: again only after WiFi reconnects, the server changes, or a request
+// goes unanswered (pool servers come and go). An IP address as the server
+// needs no lookup at all. Successive syncs also give the ratio of
+// server seconds to local timebase seconds; that drift estimate goes into
+// timeDriftPpb, so clockEpochMillis() keeps time between syncs. Once the
+// drift is known the clock stays close on its own, the poll interval
+// doubles while the residual error stays small, and the radio is used
+// rarely. The server and port are settable with "ntp:host[:port]", so a
+// local NTP server on a development machine can stand in for the pool.
+//
+// NTP is UTC. The clock shows local time, so an offset is added: set with
+// "ntp:tz=+HH:MM", or taken from the first sync after a manual "time:"
+// command (rounded to the nearest quarter hour).
+
+#define NTP_DEFAULT_HOST       "pool.ntp.org"
+#define NTP_DEFAULT_PORT       123
+#define NTP_LOCAL_PORT         2390
+#define NTP_PACKET_SIZE        48
+#define NTP_UNIX_OFFSET        2208988800ULL  // Seconds from 1900 to 1970
+#define NTP_TIMEOUT_MS         2000
+#define NTP_MAX_RTT_MS         1000           // Slower replies are too uncertain
+#define NTP_MIN_INTERVAL       64             // s, poll interval bounds
+#define NTP_MAX_INTERVAL       65536          // s (~18 h)
+#define NTP_RETRY_INTERVAL     15             // s, first retry after a failure
+#define NTP_DRIFT_MIN_SPAN     900            // s between syncs for a drift sample
+#define NTP_DRIFT_LIMIT_PPB    500000         // Clamp estimates to +-500 ppm
+#define NTP_GOOD_OFFSET_MS     50             // Residual that lets the interval grow
+#define NTP_BAD_OFFSET_MS      500            // Residual that shrinks it
+
+WiFiUDP ntpUdp;
+char ntpHost[64] = NTP_DEFAULT_HOST;
+uint16_t ntpPort = NTP_DEFAULT_PORT;
+IPAddress ntpServerIp;
+bool ntpServerResolved = false;     // ntpServerIp is ntpHost's address
+bool ntpSocketOpen = false;
+
+bool ntpWaiting = false;            // A request is in flight
+uint64_t ntpSentMicros = 0;         // Timebase when it went out (also the cookie)
+uint64_t ntpNextSyncMillis = 0;     // Timebase of the next request
+uint32_t ntpInterval = NTP_MIN_INTERVAL;
+uint32_t ntpRetryInterval = NTP_RETRY_INTERVAL;
+
+bool ntpSynced = false;
+bool ntpOffsetKnown = false;
+int32_t ntpUtcOffset = 0;           // Seconds added to UTC for display
+uint64_t ntpLastLocalMicros = 0;    // Timebase at the last good sync
+int64_t ntpLastServerMicros = 0;    // Server UTC (us since 1970) at that moment
+uint64_t ntpDriftBaseLocal = 0;     // Start of the span the next drift sample covers
+int64_t ntpDriftBaseServer = 0;
+bool ntpDriftKnown = false;
+int32_t ntpLastResidualMs = 0;      // Clock error found by the last sync
+
+// 64-bit NTP timestamp at `p` as microseconds since 1970
+int64_t ntpReadTimestamp(const uint8_t* p) {
+    uint32_t seconds = ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+    uint32_t fraction = ((uint32_t)p[4] << 24) | ((uint32_t)p[5] << 16) | ((uint32_t)p[6] << 8) | p[7];
+    return ((int64_t)seconds - (int64_t)NTP_UNIX_OFFSET) * 1000000 +
+           (int64_t)(((uint64_t)fraction * 1000000) >> 32);
+}
+
+void ntpWriteU64(uint8_t* p, uint64_t v) {
+    for (int8_t i = 7; i >= 0; i--) {
+        p[i] = (uint8_t)v;
+        v >>= 8;
+    }
+}
+
+void ntpScheduleNext(uint32_t seconds) {
+    ntpNextSyncMillis = timebaseMillis() + (uint64_t)seconds * 1000;
+}
+
+// Force a sync on the next loop (new server, or asked for)
+void ntpSyncNow() {
+    ntpWaiting = false;
+    ntpNextSyncMillis = 0;
+}
+
+void ntpSetServer(const char* host, uint16_t port) {
+    strncpy(ntpHost, host, sizeof(ntpHost) - 1);
+    ntpHost[sizeof(ntpHost) - 1] = '\0';
+    ntpPort = port;
+    ntpServerResolved = false;
+    // A different server is a different reference: start the drift
+    // measurement again but keep the current correction
+    ntpSynced = false;
+    ntpInterval = NTP_MIN_INTERVAL;
+    ntpSyncNow();
+}
+
+void ntpSetUtcOffset(int32_t seconds) {
+    ntpUtcOffset = seconds;
+    ntpOffsetKnown = true;
+    if (ntpSynced) ntpSyncNow();   // Re-step the clock into the new zone
+}
+
+bool ntpSendRequest() {
+    uint8_t packet[NTP_PACKET_SIZE];
+    memset(packet, 0, sizeof(packet));
+    packet[0] = 0x23;                  // LI 0, version 4, mode 3 (client)
+    ntpSentMicros = timebaseMicros();
+    // The transmit timestamp comes back as the originate timestamp, which
+    // ties the reply to this request; the local timebase is as good a
+    // cookie as any
+    ntpWriteU64(packet + 40, ntpSentMicros);
+
+    if (!ntpServerResolved) {
+        if (!WiFi.hostByName(ntpHost, ntpServerIp)) return false;
+        ntpServerResolved = true;
+    }
+    if (!ntpUdp.beginPacket(ntpServerIp, ntpPort)) return false;
+    ntpUdp.write(packet, sizeof(packet));
+    return ntpUdp.endPacket();
+}
+
+void ntpFailed(const char* reason) {
+    Serial.print("NTP: ");
+    Serial.println(reason);
+    ntpWaiting = false;
+    ntpScheduleNext(ntpRetryInterval);
+    ntpRetryInterval = min(ntpRetryInterval * 2, ntpInterval);
+}
+
+// Handle a valid reply: server UTC was `serverMicros` at timebase `localMicros`
+void ntpApply(int64_t serverMicros, uint64_t localMicros) {
+    // Drift from the span since the base sample, measured on the raw
+    // timebase so manual time changes in between don't matter
+    if (ntpSynced) {
+        int64_t localSpan = (int64_t)(localMicros - ntpDriftBaseLocal);
+        if (localSpan >= (int64_t)NTP_DRIFT_MIN_SPAN * 1000000) {
+            int64_t serverSpan = serverMicros - ntpDriftBaseServer;
+            int64_t sample = (serverSpan - localSpan) * 1000000000LL / localSpan;
+            sample = constrain(sample, -(int64_t)NTP_DRIFT_LIMIT_PPB, (int64_t)NTP_DRIFT_LIMIT_PPB);
+            if (ntpDriftKnown) {
+                timeDriftPpb += (int32_t)(sample - timeDriftPpb) / 4;   // Smooth out jitter
+            } else {
+                timeDriftPpb = (int32_t)sample;
+                ntpDriftKnown = true;
+            }
+            ntpDriftBaseLocal = localMicros;
+            ntpDriftBaseServer = serverMicros;
+        }
+    } else {
+        ntpDriftBaseLocal = localMicros;
+        ntpDriftBaseServer = serverMicros;
+    }
+
+    // Local time the server says it is, as of now
+    uint64_t nowMillis = timebaseMillis();
+    int64_t utcMillis = serverMicros / 1000 + (int64_t)(nowMillis - localMicros / 1000);
+    if (!ntpOffsetKnown && timeInitialized) {
+        // Keep the zone a manual "time:" command implied
+        int64_t offset = (clockEpochMillis() - utcMillis) / 1000;
+        offset = (offset >= 0 ? offset + 450 : offset - 450) / 900 * 900;
+        if (offset >= -14 * 3600 && offset <= 14 * 3600) ntpUtcOffset = offset;
+    }
+    ntpOffsetKnown = true;
+    int64_t localMillis = utcMillis + (int64_t)ntpUtcOffset * 1000;
+
+    int64_t residual = timeInitialized ? localMillis - clockEpochMillis() : 0;
+    ntpLastResidualMs = (int32_t)constrain(residual, -86400000LL, 86400000LL);
+    clockSync(localMillis, nowMillis);
+
+    // Confirm the first step quickly, then wait long enough for a drift
+    // sample. After that, poll less often while the corrected clock holds
+    // and more often when it doesn't.
+    int32_t error = abs(ntpLastResidualMs);
+    if (!ntpSynced) {
+        ntpInterval = NTP_MIN_INTERVAL;
+    } else if (!ntpDriftKnown) {
+        ntpInterval = NTP_DRIFT_MIN_SPAN;
+    } else if (error <= NTP_GOOD_OFFSET_MS) {
+        ntpInterval = min((uint32_t)NTP_MAX_INTERVAL, ntpInterval * 2);
+    } else if (error >= NTP_BAD_OFFSET_MS) {
+        ntpInterval = max((uint32_t)NTP_MIN_INTERVAL, ntpInterval / 2);
+    }
+
+    ntpSynced = true;
+    ntpLastLocalMicros = localMicros;
+    ntpLastServerMicros = serverMicros;
+    ntpRetryInterval = NTP_RETRY_INTERVAL;
+    ntpScheduleNext(ntpInterval);
+
+    Serial.print("NTP: synced, error ");
+    Serial.print(ntpLastResidualMs);
+    Serial.print(" ms, drift ");
+    Serial.print(timeDriftPpb / 1000.0, 2);
+    Serial.print(" ppm, next in ");
+    Serial.print(ntpInterval);
+    Serial.println(" s");
+}
+
+// Check for the reply to the request in flight
+void ntpPollReply() {
+    int size = ntpUdp.parsePacket();
+    if (size <= 0) {
+        if (timebaseMicros() - ntpSentMicros > (uint64_t)NTP_TIMEOUT_MS * 1000) {
+            ntpServerResolved = false;     // Look the name up again next time
+            ntpFailed("no reply");
+        }
+        return;
+    }
+
+    uint64_t receivedMicros = timebaseMicros();
+    uint8_t packet[NTP_PACKET_SIZE];
+    if (size < NTP_PACKET_SIZE || ntpUdp.read(packet, NTP_PACKET_SIZE) < NTP_PACKET_SIZE) {
+        return;   // Not ours; keep waiting
+    }
+
+    uint8_t cookie[8];
+    ntpWriteU64(cookie, ntpSentMicros);
+    if ((packet[0] & 0x07) != 4 || memcmp(packet + 24, cookie, 8) != 0) {
+        return;   // Not a server reply to this request
+    }
+    ntpWaiting = false;
+    uint8_t stratum = packet[1];
+    if ((packet[0] >> 6) == 3 || stratum == 0 || stratum > 15) {
+        ntpFailed("server unsynchronized");
+        return;
+    }
+
+    // Round trip minus the server's own processing time; the reply left
+    // the server half the network delay ago
+    int64_t serverReceive = ntpReadTimestamp(packet + 32);
+    int64_t serverTransmit = ntpReadTimestamp(packet + 40);
+    int64_t delay = (int64_t)(receivedMicros - ntpSentMicros) - (serverTransmit - serverReceive);
+    if (delay < 0) delay = 0;
+    if (delay > (int64_t)NTP_MAX_RTT_MS * 1000) {
+        ntpFailed("round trip too slow");
+        return;
+    }
+    ntpApply(serverTransmit + delay / 2, receivedMicros);
+}
+
+// Call every loop. Does nothing without WiFi.
+void ntpUpdate() {
+    if (WiFi.status() != WL_CONNECTED) {
+        if (ntpSocketOpen) {
+            ntpUdp.stop();
+            ntpSocketOpen = false;
+            ntpWaiting = false;
+            ntpServerResolved = false;   // Maybe another network next time
+        }
+        return;
+    }
+    if (!ntpSocketOpen) {
+        ntpSocketOpen = ntpUdp.begin(NTP_LOCAL_PORT);
+        if (!ntpSocketOpen) return;
+    }
+
+    if (ntpWaiting) {
+        ntpPollReply();
+    } else if (timebaseMillis() >= ntpNextSyncMillis) {
+        if (ntpSendRequest()) {
+            ntpWaiting = true;
+        } else {
+            ntpFailed("send failed");
+        }
+    }
+}
+
+// One-line status for the "ntp:" command
+String ntpStatus() {
+    String status = "NTP " + String(ntpHost) + ":" + String(ntpPort);
+    if (WiFi.status() != WL_CONNECTED) return status + ", waiting for WiFi";
+    if (!ntpSynced) return status + ", not synced yet";
+    status += ", synced " + String((uint32_t)((timebaseMicros() - ntpLastLocalMicros) / 1000000)) + " s ago";
+    status += ", error " + String(ntpLastResidualMs) + " ms";
+    status += ", drift " + (ntpDriftKnown ? String(timeDriftPpb / 1000.0, 2) + " ppm" : String("unknown"));
+    status += ", interval " + String(ntpInterval) + " s";
+    return status;
+}
+
+// Handle the payload of an "ntp:" command:
+//   ""              report status and sync now
+//   "tz=+HH:MM"     set the UTC offset
+//   "host[:port]"   use another server
+bool ntpCommand(TextSpan payload, String& reply) {
+    payload = spanTrim(payload);
+    if (spanEmpty(payload)) {
+        ntpSyncNow();
+        reply = ntpStatus();
+        return true;
+    }
+
+    if (spanStartsWith(payload, "tz=")) {
+        TextSpan tz = spanTrim(spanSkip(payload, 3));
+        int sign = 1;
+        if (spanStartsWith(tz, "-")) sign = -1;
+        if (spanStartsWith(tz, "-") || spanStartsWith(tz, "+")) tz = spanSkip(tz, 1);
+        long hours, minutes = 0;
+        bool valid = spanNextLong(tz, ':', hours) && (spanExhausted(tz) || spanNextLong(tz, ':', minutes)) &&
+                     spanExhausted(tz);
+        if (!valid || hours < 0 || hours > 14 || minutes < 0 || minutes > 59) {
+            reply = "Invalid offset. Use: ntp:tz=+HH:MM";
+            return false;
+        }
+        ntpSetUtcOffset(sign * (hours * 3600 + minutes * 60));
+        reply = "UTC offset set to " + String(ntpUtcOffset / 60) + " min";
+        return true;
+    }
+
+    uint16_t port = NTP_DEFAULT_PORT;
+    TextSpan host;
+    spanSplit(payload, ':', host);
+    if (!spanExhausted(payload)) {
+        long value;
+        if (!spanToLong(spanTrim(payload), value) || value <= 0 || value > 65535) {
+            reply = "Invalid port. Use: ntp:host[:port]";
+            return false;
+        }
+        port = value;
+    }
+    char hostName[sizeof(ntpHost)];
+    if (spanEmpty(host) || host.length >= sizeof(hostName)) {
+        reply = "Invalid host. Use: ntp:host[:port]";
+        return false;
+    }
+    spanCopy(host, hostName, sizeof(hostName));
+    ntpSetServer(hostName, port);
+    reply = "NTP server set to " + String(ntpHost) + ":" + String(ntpPort);
+    return true;
+}
+
+#endif // SNTP_H
@@ -0,0 +1,76 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <Arduino.h>
+#include <atomic>
+
+// Lock-free single-producer/single-consumer byte ring.
+//
+// One task only ever writes (advances head), another only ever reads
+// (advances tail). Both indices are free-running 32-bit counters, so
+// head - tail is the fill level even across wrap-around, and the size
+// must be a power of two. The producer copies data in first and then
+// publishes it with a release store of head; the consumer's acquire load
+// of head guarantees it sees the bytes. Nothing allocates and nothing
+// blocks, so it is safe between the Bluedroid task and loop().
+//
+// Writes are all-or-nothing: a record either fits completely or is
+// refused, so the consumer never sees half of one.
+
+template <uint16_t N>
+struct SpscByteRing {
+    static_assert((N & (N - 1)) == 0, "ring size must be a power of two");
+    uint8_t data[N];
+    std::atomic<uint32_t> head{0};   // Advanced by the producer only
+    std::atomic<uint32_t> tail{0};   // Advanced by the consumer only
+};
+
+// Producer side --------------------------------------------------------------
+
+template <uint16_t N>
+inline uint32_t spscFree(const SpscByteRing<N>& ring) {
+    return N - (ring.head.load(std::memory_order_relaxed) - ring.tail.load(std::memory_order_acquire));
+}
+
+// Copy `length` bytes to `offset` bytes past the current head without
+// publishing them
+template <uint16_t N>
+inline void spscStage(SpscByteRing<N>& ring, uint32_t offset, const uint8_t* src, uint32_t length) {
+    uint32_t pos = ring.head.load(std::memory_order_relaxed) + offset;
+    for (uint32_t i = 0; i < length; i++) {
+        ring.data[(pos + i) & (N - 1)] = src[i];
+    }
+}
+
+// Make `length` staged bytes visible to the consumer
+template <uint16_t N>
+inline void spscPublish(SpscByteRing<N>& ring, uint32_t length) {
+    ring.head.store(ring.head.load(std::memory_order_relaxed) + length, std::memory_order_release);
+}
+
+// Consumer side --------------------------------------------------------------
+
+template <uint16_t N>
+inline uint32_t spscAvailable(const SpscByteRing<N>& ring) {
+    return ring.head.load(std::memory_order_acquire) - ring.tail.load(std::memory_order_relaxed);
+}
+
+// Byte `offset` past the tail; offset must be below spscAvailable()
+template <uint16_t N>
+inline uint8_t spscPeek(const SpscByteRing<N>& ring, uint32_t offset) {
+    return ring.data[(ring.tail.load(std::memory_order_relaxed) + offset) & (N - 1)];
+}
+
+// Hand `length` bytes back to the producer
+template <uint16_t N>
+inline void spscConsume(SpscByteRing<N>& ring, uint32_t length) {
+    ring.tail.store(ring.tail.load(std::memory_order_relaxed) + length, std::memory_order_release);
+}
+
+// Drop everything published so far (consumer side, e.g. on disconnect)
+template <uint16_t N>
+inline void spscDiscard(SpscByteRing<N>& ring) {
+    ring.tail.store(ring.head.load(std::memory_order_acquire), std::memory_order_release);
+}
+
+#endif // SPSC_RING_H
@@ -0,0 +1,154 @@
+#ifndef TEXT_LAYOUT_H
+#define TEXT_LAYOUT_H
+
+#include "framebuffer.h"
+#include "font_5x8.h"
+
+// Word-wrapping text layout without heap allocations.
+//
+// A layout is a fixed table of (start, length) spans into the caller's
+// UTF-8 text, built in one forward scan; widths are counted in code points
+// and lines are drawn from the font5x8 glyph atlas. textLayoutFit() picks
+// the largest text size (3, 2 or 1) the text fits at without losing lines
+// or splitting words.
+
+#define TEXT_MAX_LINES  8
+#define TEXT_GLYPH_W    (FONT_5X8_WIDTH + 1)  // Advance at size 1
+#define TEXT_GLYPH_H    8
+#define TEXT_MAX_SIZE   3
+
+struct TextLine {
+    uint16_t start;      // Byte offset
+    uint8_t length;      // Bytes
+    uint8_t glyphs;      // Code points
+};
+
+struct TextLayout {
+    TextLine lines[TEXT_MAX_LINES];
+    uint8_t count;
+    uint8_t size;        // Text size the layout was made for
+    uint8_t perLine;     // Glyphs per line at that size
+    bool truncated;      // Text didn't fit, last line gets "..."
+    bool splitWord;      // A word longer than a line had to be broken
+};
+
+// Wrap `text` (length bytes) at text size `size`
+void textLayoutWrap(TextLayout& layout, const char* text, uint16_t length, uint8_t size) {
+    uint8_t perLine = FB_WIDTH / (TEXT_GLYPH_W * size);
+    uint8_t maxLines = FB_HEIGHT / (TEXT_GLYPH_H * size);
+    if (maxLines > TEXT_MAX_LINES) maxLines = TEXT_MAX_LINES;
+
+    layout.count = 0;
+    layout.size = size;
+    layout.perLine = perLine;
+    layout.truncated = false;
+    layout.splitWord = false;
+
+    const char* textEnd = text + length;
+    uint16_t start = 0;
+    while (start < length) {
+        if (layout.count == maxLines) {
+            layout.truncated = true;
+            break;
+        }
+
+        // Take as many glyphs as fit, remembering the last space
+        int16_t lastSpace = -1;
+        uint8_t spaceGlyphs = 0;
+        uint8_t glyphs = 0;
+        const char* p = text + start;
+        while (p < textEnd && *p != '\n' && glyphs < perLine) {
+            if (*p == ' ') {
+                lastSpace = p - text;
+                spaceGlyphs = glyphs;
+            }
+            utf8Next(p, textEnd);
+            glyphs++;
+        }
+        uint16_t i = p - text;
+
+        uint16_t end, next;
+        if (i >= length || text[i] == '\n' || text[i] == ' ') {
+            end = i;             // Rest fits, explicit newline, or the break lands on a space
+            next = i + 1;
+        } else if (lastSpace > (int16_t)start) {
+            end = lastSpace;     // Break at the last word boundary
+            next = lastSpace + 1;
+            glyphs = spaceGlyphs;
+        } else {
+            end = i;             // One long word: hard break
+            next = i;
+            layout.splitWord = true;
+        }
+
+        layout.lines[layout.count].start = start;
+        layout.lines[layout.count].length = end - start;
+        layout.lines[layout.count].glyphs = glyphs;
+        layout.count++;
+        start = next;
+    }
+}
+
+// Largest text size that shows everything without splitting words
+void textLayoutFit(TextLayout& layout, const char* text, uint16_t length) {
+    for (uint8_t size = TEXT_MAX_SIZE; size > 1; size--) {
+        textLayoutWrap(layout, text, length, size);
+        if (!layout.truncated && !layout.splitWord) return;
+    }
+    textLayoutWrap(layout, text, length, 1);
+}
+
+// Draw a layout into a cleared framebuffer. A single line is centred, more
+// lines are left-aligned and the block is centred vertically.
+void textLayoutRender(const TextLayout& layout, const char* text) {
+    display.clearDisplay();
+
+    uint8_t advance = glyphAdvance(font5x8, layout.size);
+    uint8_t lineHeight = TEXT_GLYPH_H * layout.size;
+    int16_t y = (FB_HEIGHT - layout.count * lineHeight) / 2;
+
+    for (uint8_t n = 0; n < layout.count; n++) {
+        const TextLine& line = layout.lines[n];
+        uint8_t length = line.length;
+        uint8_t glyphs = line.glyphs;
+        bool ellipsis = layout.truncated && n == layout.count - 1;
+        if (ellipsis && glyphs > layout.perLine - 3) {
+            glyphs = layout.perLine - 3;
+            length = utf8Prefix(text + line.start, length, glyphs);
+        }
+
+        int16_t x = 0;
+        if (layout.count == 1) {
+            x = (FB_WIDTH - glyphs * advance) / 2;
+        }
+        x = glyphDrawText(font5x8, x, y, text + line.start, length, layout.size);
+        if (ellipsis) glyphDrawText(font5x8, x, y, "...", 3, layout.size);
+        y += lineHeight;
+    }
+}
+
+// FNV-1a hash of a C string; also returns its length
+uint32_t textHash(const char* text, uint16_t& length) {
+    uint32_t hash = 2166136261UL;
+    length = 0;
+    while (text[length] != '\0') {
+        hash = (hash ^ (uint8_t)text[length]) * 16777619UL;
+        length++;
+    }
+    return hash;
+}
+
+// Last text shown by display_text(), with its layout and rendered frame
+struct TextLayoutCache {
+    bool valid;
+    uint32_t hash;
+    uint16_t length;
+    uint32_t presentedSerial;   // fbFrameSerial right after we pushed it
+    bool marquee;               // Too long to wrap, shown by marquee.h instead
+    TextLayout layout;
+    uint32_t frame[FB_SIZE / 4];
+};
+
+TextLayoutCache textCache;
+
+#endif // TEXT_LAYOUT_H
@@ -0,0 +1,128 @@
+#ifndef TIMEBASE_H
+#define TIMEBASE_H
+
+#include <Arduino.h>
+#ifdef ESP32
+#include <esp_timer.h>
+#endif
+
+// Monotonic 64-bit time and calendar arithmetic for the clock.
+//
+// millis() is 32 bits and wraps after 49.7 days, so anything that measures
+// long spans (the clock, timers, alarms) reads timebaseMillis() instead. On
+// the ESP32 that is esp_timer, which already counts microseconds in 64 bits
+// since boot; elsewhere millis() is widened by counting its wraps, which
+// only needs a call at least once per wrap period (loop() does far more).
+//
+// The calendar side converts between seconds since 1970 (UTC, no DST, as
+// setTime() always assumed) and broken-down dates with plain integer
+// arithmetic, so the clock never calls localtime() or mktime().
+
+uint64_t timebaseMillis() {
+#ifdef ESP32
+    return (uint64_t)esp_timer_get_time() / 1000;
+#else
+    static uint32_t last = 0;
+    static uint32_t wraps = 0;
+    uint32_t now = millis();
+    if (now < last) wraps++;
+    last = now;
+    return ((uint64_t)wraps << 32) | now;
+#endif
+}
+
+// Microsecond timebase for short precise intervals (network round trips).
+// Only the ESP32 counts these in 64 bits; elsewhere it has millisecond
+// resolution.
+uint64_t timebaseMicros() {
+#ifdef ESP32
+    return (uint64_t)esp_timer_get_time();
+#else
+    return timebaseMillis() * 1000;
+#endif
+}
+
+// ---------------------------------------------------------------------------
+// Calendar
+
+struct CalendarTime {
+    int64_t epoch;       // Seconds since 1970-01-01 00:00:00
+    int16_t year;
+    uint8_t month;       // 1-12
+    uint8_t day;         // 1-31
+    uint8_t hour;
+    uint8_t minute;
+    uint8_t second;
+    uint8_t weekday;     // 0 = Sunday
+};
+
+inline bool calendarLeapYear(int16_t year) {
+    return (year % 4 == 0 && year % 100 != 0) || (year % 400 == 0);
+}
+
+inline uint8_t calendarDaysInMonth(int16_t year, uint8_t month) {
+    static const uint8_t days[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    return (month == 2 && calendarLeapYear(year)) ? 29 : days[month - 1];
+}
+
+// Days since 1970-01-01 for a date in the proleptic Gregorian calendar.
+// Counts from March so the leap day is the last day of the year.
+int32_t calendarDaysFromCivil(int16_t year, uint8_t month, uint8_t day) {
+    int32_t y = year - (month <= 2);
+    int32_t era = (y >= 0 ? y : y - 399) / 400;
+    uint32_t yoe = y - era * 400;                                   // 0-399
+    uint32_t doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;  // 0-365
+    uint32_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;           // 0-146096
+    return era * 146097 + (int32_t)doe - 719468;
+}
+
+// Inverse of calendarDaysFromCivil()
+void calendarCivilFromDays(int32_t days, int16_t& year, uint8_t& month, uint8_t& day) {
+    days += 719468;
+    int32_t era = (days >= 0 ? days : days - 146096) / 146097;
+    uint32_t doe = days - era * 146097;
+    uint32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    uint32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    uint32_t mp = (5 * doy + 2) / 153;
+    day = doy - (153 * mp + 2) / 5 + 1;
+    month = mp < 10 ? mp + 3 : mp - 9;
+    year = (int32_t)yoe + era * 400 + (month <= 2);
+}
+
+int64_t calendarToEpoch(int16_t year, uint8_t month, uint8_t day,
+                        uint8_t hour, uint8_t minute, uint8_t second) {
+    return (int64_t)calendarDaysFromCivil(year, month, day) * 86400 +
+           hour * 3600L + minute * 60L + second;
+}
+
+// Full conversion from seconds since 1970
+void calendarFromEpoch(int64_t epoch, CalendarTime& t) {
+    int32_t days = epoch >= 0 ? epoch / 86400 : (epoch - 86399) / 86400;
+    int32_t secs = epoch - (int64_t)days * 86400;
+    t.epoch = epoch;
+    calendarCivilFromDays(days, t.year, t.month, t.day);
+    t.hour = secs / 3600;
+    t.minute = secs / 60 % 60;
+    t.second = secs % 60;
+    t.weekday = (uint8_t)(((days % 7) + 11) % 7);   // 1970-01-01 was a Thursday
+}
+
+// Move `t` forward to `epoch`. Steps within the same day only carry
+// seconds into minutes and hours; crossing midnight (or a jump of a day or
+// more, or backwards) falls back to the full conversion.
+void calendarAdvance(CalendarTime& t, int64_t epoch) {
+    int64_t delta = epoch - t.epoch;
+    if (delta == 0) return;
+    uint32_t secondOfDay = t.hour * 3600UL + t.minute * 60UL + t.second;
+    if (delta < 0 || delta >= 86400 - (int64_t)secondOfDay) {
+        calendarFromEpoch(epoch, t);
+        return;
+    }
+    secondOfDay += delta;
+    t.epoch = epoch;
+    t.hour = secondOfDay / 3600;
+    t.minute = secondOfDay / 60 % 60;
+    t.second = secondOfDay % 60;
+}
+
+#endif // TIMEBASE_H
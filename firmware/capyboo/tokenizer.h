@@ -0,0 +1,194 @@
+#ifndef TOKENIZER_H
+#define TOKENIZER_H
+
+#include <Arduino.h>
+
+// Zero-copy command parsing.
+//
+// A TextSpan points into the received command; nothing is copied, nothing
+// is allocated and the text does not have to be NUL-terminated. Parsers
+// walk a command once, peeling fields off the front with spanSplit(), and
+// convert fields with spanToLong()/spanToFloat(), which accept the whole
+// field or nothing. No function reads past data[length - 1].
+
+struct TextSpan {
+    const char* data;
+    uint16_t length;
+};
+
+inline TextSpan spanOf(const char* text, size_t length) {
+    return TextSpan{text, (uint16_t)min(length, (size_t)UINT16_MAX)};
+}
+
+inline TextSpan spanOf(const char* text) {
+    return spanOf(text, strlen(text));
+}
+
+inline bool spanEmpty(TextSpan s) {
+    return s.length == 0;
+}
+
+inline char spanLower(char c) {
+    return (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+}
+
+inline bool spanIsSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+TextSpan spanTrim(TextSpan s) {
+    while (s.length > 0 && spanIsSpace(s.data[0])) { s.data++; s.length--; }
+    while (s.length > 0 && spanIsSpace(s.data[s.length - 1])) s.length--;
+    return s;
+}
+
+// Position of the first `c`, or -1
+int spanIndexOf(TextSpan s, char c) {
+    for (uint16_t i = 0; i < s.length; i++) {
+        if (s.data[i] == c) return i;
+    }
+    return -1;
+}
+
+// Case-insensitive comparison against a lowercase word
+bool spanEquals(TextSpan s, const char* word) {
+    uint16_t i = 0;
+    for (; i < s.length; i++) {
+        if (word[i] == '\0' || spanLower(s.data[i]) != word[i]) return false;
+    }
+    return word[i] == '\0';
+}
+
+bool spanStartsWith(TextSpan s, const char* prefix) {
+    for (uint16_t i = 0; prefix[i] != '\0'; i++) {
+        if (i >= s.length || spanLower(s.data[i]) != prefix[i]) return false;
+    }
+    return true;
+}
+
+// Drop the first `count` characters (all of them if there are fewer)
+inline TextSpan spanSkip(TextSpan s, uint16_t count) {
+    count = min(count, s.length);
+    return TextSpan{s.data + count, (uint16_t)(s.length - count)};
+}
+
+// Take the field before the first `delimiter` into `field` and advance
+// `rest` past the delimiter. Without a delimiter the whole of `rest` is
+// the field and `rest` is marked exhausted. Returns false once every
+// field has been handed out, so `while (spanSplit(rest, ':', field))`
+// visits each one, including empty ones between adjacent delimiters.
+bool spanSplit(TextSpan& rest, char delimiter, TextSpan& field) {
+    if (rest.data == nullptr) return false;
+    int at = spanIndexOf(rest, delimiter);
+    if (at < 0) {
+        field = rest;
+        rest = TextSpan{nullptr, 0};
+    } else {
+        field = TextSpan{rest.data, (uint16_t)at};
+        rest = TextSpan{rest.data + at + 1, (uint16_t)(rest.length - at - 1)};
+    }
+    return true;
+}
+
+// True once spanSplit() has handed out the last field
+inline bool spanExhausted(TextSpan rest) {
+    return rest.data == nullptr;
+}
+
+// Whole field as a signed decimal integer; false on anything else,
+// including overflow past +/-2^31
+bool spanToLong(TextSpan s, long& value) {
+    uint16_t i = 0;
+    bool negative = false;
+    if (i < s.length && (s.data[i] == '-' || s.data[i] == '+')) {
+        negative = s.data[i] == '-';
+        i++;
+    }
+    if (i == s.length) return false;
+
+    int64_t result = 0;
+    for (; i < s.length; i++) {
+        if (s.data[i] < '0' || s.data[i] > '9') return false;
+        result = result * 10 + (s.data[i] - '0');
+        if (result > 2147483647LL) return false;
+    }
+    value = (long)(negative ? -result : result);
+    return true;
+}
+
+// Whole field as 1-8 hex digits, either case ("1F", "deadbeef")
+bool spanToHex(TextSpan s, uint32_t& value) {
+    if (s.length == 0 || s.length > 8) return false;
+    uint32_t result = 0;
+    for (uint16_t i = 0; i < s.length; i++) {
+        char c = spanLower(s.data[i]);
+        if (c >= '0' && c <= '9') result = result << 4 | (c - '0');
+        else if (c >= 'a' && c <= 'f') result = result << 4 | (c - 'a' + 10);
+        else return false;
+    }
+    value = result;
+    return true;
+}
+
+// Whole field as a decimal number with an optional fraction ("-3", "21.5")
+bool spanToFloat(TextSpan s, float& value) {
+    uint16_t i = 0;
+    bool negative = false;
+    if (i < s.length && (s.data[i] == '-' || s.data[i] == '+')) {
+        negative = s.data[i] == '-';
+        i++;
+    }
+
+    float result = 0;
+    float scale = 1;
+    bool fraction = false;
+    bool digits = false;
+    for (; i < s.length; i++) {
+        char c = s.data[i];
+        if (c == '.' && !fraction) {
+            fraction = true;
+        } else if (c >= '0' && c <= '9') {
+            digits = true;
+            if (!fraction) {
+                result = result * 10 + (c - '0');
+            } else {
+                scale *= 0.1f;
+                result += (c - '0') * scale;
+            }
+        } else {
+            return false;
+        }
+    }
+    if (!digits || result > 1e9f) return false;
+    value = negative ? -result : result;
+    return true;
+}
+
+// Split off the next field and parse it (surrounding spaces allowed)
+bool spanNextLong(TextSpan& rest, char delimiter, long& value) {
+    TextSpan field;
+    return spanSplit(rest, delimiter, field) && spanToLong(spanTrim(field), value);
+}
+
+bool spanNextFloat(TextSpan& rest, char delimiter, float& value) {
+    TextSpan field;
+    return spanSplit(rest, delimiter, field) && spanToFloat(spanTrim(field), value);
+}
+
+// Copy into a C string, truncating to fit; returns the length copied
+size_t spanCopy(TextSpan s, char* dest, size_t capacity) {
+    if (capacity == 0) return 0;
+    size_t length = min((size_t)s.length, capacity - 1);
+    if (length > 0) memcpy(dest, s.data, length);
+    dest[length] = '\0';
+    return length;
+}
+
+// For the few places that have to keep text in a String
+String spanString(TextSpan s) {
+    String text;
+    if (s.length > 0) text.concat(s.data, s.length);
+    return text;
+}
+
+#endif // TOKENIZER_H
@@ -0,0 +1,172 @@
+#ifndef TRANSITION_H
+#define TRANSITION_H
+
+#include "framebuffer.h"
+#include "tween.h"
+
+// Screen transitions between modes.
+//
+// transitionBegin() snapshots the outgoing screen. Frames the new mode
+// presents afterwards are captured instead of pushed, and transitionTick()
+// composes outgoing and incoming into the framebuffer with page/word-wide
+// copies, pushes the result and puts the incoming frame back. Progress is
+// driven by the clock, not the frame count, and a frame is only composed
+// every TRANSITION_FRAME_MS, so a transition costs a bounded slice of each
+// loop() and never holds up BLE or touch handling.
+
+#define TRANSITION_DURATION  320   // ms
+#define TRANSITION_FRAME_MS  33    // Frame budget: at most ~30 composed frames/s
+#define TRANSITION_WAIT_MS   1200  // Give up if the new mode hasn't drawn by then
+
+enum TransitionEffect {
+    TRANSITION_NONE,
+    TRANSITION_WIPE,        // Incoming screen uncovered left to right
+    TRANSITION_SLIDE_LEFT,  // Incoming screen pushes the old one out to the left
+    TRANSITION_SLIDE_UP,    // Incoming screen pushes the old one up
+    TRANSITION_DISSOLVE     // Ordered-dither dissolve
+};
+
+uint32_t transitionFrom[FB_SIZE / 4];   // Outgoing screen
+uint32_t transitionTo[FB_SIZE / 4];     // Latest frame of the incoming screen
+uint8_t transitionEffect = TRANSITION_NONE;
+bool transitionHaveTo = false;          // Incoming screen has drawn at least once
+unsigned long transitionBegan = 0;
+unsigned long transitionStart = 0;      // Time of the first incoming frame
+unsigned long transitionLastFrame = 0;
+
+bool transitionActive() {
+    return transitionEffect != TRANSITION_NONE;
+}
+
+// Start a transition from whatever is in the framebuffer now
+void transitionBegin(uint8_t effect) {
+    if (effect == TRANSITION_NONE) {
+        transitionEffect = TRANSITION_NONE;
+        return;
+    }
+    memcpy(transitionFrom, fbBuffer(), FB_SIZE);
+    transitionEffect = effect;
+    transitionHaveTo = false;
+    transitionBegan = millis();
+}
+
+// Slide both screens up by `rows` (0..64): output page j shows rows
+// j*8+rows.. of the outgoing screen stacked on top of the incoming one. Each
+// output byte is built from two source pages; a 32-bit word covers four
+// columns, with lane masks keeping the shifts from bleeding between them.
+void transitionComposeSlideUp(uint32_t* out, uint8_t rows) {
+    uint8_t q = rows >> 3;
+    uint8_t r = rows & 7;
+    const uint32_t loMask = 0x01010101UL * (uint8_t)(0xFF >> r);
+    const uint32_t hiMask = ~loMask;
+    const uint8_t wordsPerPage = FB_WIDTH / 4;
+
+    for (uint8_t page = 0; page < FB_PAGES; page++) {
+        uint8_t a = page + q;
+        uint8_t b = a + 1;
+        const uint32_t* srcA = a < FB_PAGES ? transitionFrom + a * wordsPerPage : transitionTo + (a - FB_PAGES) * wordsPerPage;
+        const uint32_t* srcB = nullptr;
+        if (r != 0 && b < 2 * FB_PAGES) {
+            srcB = b < FB_PAGES ? transitionFrom + b * wordsPerPage : transitionTo + (b - FB_PAGES) * wordsPerPage;
+        }
+        uint32_t* dst = out + page * wordsPerPage;
+        for (uint8_t i = 0; i < wordsPerPage; i++) {
+            uint32_t v = (srcA[i] >> r) & loMask;
+            if (srcB) v |= (srcB[i] << (8 - r)) & hiMask;
+            dst[i] = v;
+        }
+    }
+}
+
+// Compose the frame for progress 0..256 into `out` (an FB_SIZE buffer)
+void transitionCompose(uint8_t* out, uint16_t progress) {
+    const uint8_t* from = (const uint8_t*)transitionFrom;
+    const uint8_t* to = (const uint8_t*)transitionTo;
+    uint16_t eased = tweenEase(TWEEN_EASE_IN_OUT, progress);
+
+    switch (transitionEffect) {
+        case TRANSITION_WIPE: {
+            uint8_t edge = (uint16_t)progress * FB_WIDTH >> 8;
+            for (uint8_t page = 0; page < FB_PAGES; page++) {
+                uint16_t row = page * FB_WIDTH;
+                memcpy(out + row, to + row, edge);
+                memcpy(out + row + edge, from + row + edge, FB_WIDTH - edge);
+            }
+            break;
+        }
+        case TRANSITION_SLIDE_LEFT: {
+            uint8_t shift = eased * FB_WIDTH >> 8;
+            for (uint8_t page = 0; page < FB_PAGES; page++) {
+                uint16_t row = page * FB_WIDTH;
+                memcpy(out + row, from + row + shift, FB_WIDTH - shift);
+                memcpy(out + row + FB_WIDTH - shift, to + row, shift);
+            }
+            break;
+        }
+        case TRANSITION_SLIDE_UP:
+            transitionComposeSlideUp((uint32_t*)out, eased * FB_HEIGHT >> 8);
+            break;
+        case TRANSITION_DISSOLVE:
+            // Dither mask pixels show the incoming screen
+            memcpy(out, to, FB_SIZE);
+            fbDitherBlend(out, from, progress >> 4);
+            break;
+    }
+}
+
+// Compose and push the next frame if one is due. Call from loop(); frames
+// presented by the new mode also land here via transitionCapture().
+void transitionTick() {
+    if (!transitionActive()) return;
+    unsigned long now = millis();
+
+    if (!transitionHaveTo) {
+        if (now - transitionBegan >= TRANSITION_WAIT_MS) {
+            transitionEffect = TRANSITION_NONE;
+        }
+        return;
+    }
+
+    uint8_t* fb = fbBuffer();
+    unsigned long elapsed = now - transitionStart;
+    if (elapsed >= TRANSITION_DURATION) {
+        // Finish on the exact incoming frame
+        memcpy(fb, transitionTo, FB_SIZE);
+        fbPushPages(fb, 0, FB_PAGES - 1, 0, FB_WIDTH - 1);
+        transitionEffect = TRANSITION_NONE;
+        return;
+    }
+    if (now - transitionLastFrame < TRANSITION_FRAME_MS) return;
+    transitionLastFrame = now;
+
+    uint16_t progress = (elapsed << 8) / TRANSITION_DURATION;
+    transitionCompose(fb, progress);
+    if (transitionEffect == TRANSITION_WIPE) {
+        // Right of the edge the panel already shows the outgoing screen
+        uint8_t edge = (uint16_t)progress * FB_WIDTH >> 8;
+        if (edge > 0) fbPushPages(fb, 0, FB_PAGES - 1, 0, edge - 1);
+    } else {
+        fbPushPages(fb, 0, FB_PAGES - 1, 0, FB_WIDTH - 1);
+    }
+
+    // Leave the incoming frame in the framebuffer for renderers that draw
+    // on top of what they drew last time
+    memcpy(fb, transitionTo, FB_SIZE);
+}
+
+// Called by display_present(): takes the frame just drawn as the latest
+// incoming screen. Returns true if the transition owns the panel, in which
+// case the caller must not push.
+bool transitionCapture() {
+    if (!transitionActive()) return false;
+    memcpy(transitionTo, fbBuffer(), FB_SIZE);
+    if (!transitionHaveTo) {
+        transitionHaveTo = true;
+        transitionStart = millis();
+        transitionLastFrame = transitionStart - TRANSITION_FRAME_MS;
+    }
+    transitionTick();
+    return true;
+}
+
+#endif // TRANSITION_H
@@ -0,0 +1,83 @@
+#ifndef TWEEN_H
+#define TWEEN_H
+
+#include <Arduino.h>
+
+// Small curve-based tween engine for animating integer parameters.
+// Progress and curve outputs are Q8 fixed point (0..256 = 0..1), so
+// evaluating a tween is a handful of integer multiplies.
+
+enum TweenCurve {
+    TWEEN_LINEAR,
+    TWEEN_EASE_IN,      // Quadratic, slow start
+    TWEEN_EASE_OUT,     // Quadratic, slow end
+    TWEEN_EASE_IN_OUT,  // Smoothstep
+    TWEEN_BACK_OUT      // Overshoots the target slightly, then settles
+};
+
+struct Tween {
+    int16_t from;
+    int16_t to;
+    unsigned long start;
+    uint16_t duration;  // ms, 0 = jump straight to `to`
+    uint8_t curve;
+};
+
+// Map linear progress t (0..256) through a curve (result may leave 0..256
+// for overshooting curves)
+int16_t tweenEase(uint8_t curve, int16_t t) {
+    switch (curve) {
+        case TWEEN_EASE_IN:
+            return (t * t) >> 8;
+        case TWEEN_EASE_OUT:
+            return 256 - (((256 - t) * (256 - t)) >> 8);
+        case TWEEN_EASE_IN_OUT:
+            // 3t^2 - 2t^3
+            return (int16_t)(((int32_t)t * t * (768 - 2 * t)) >> 16);
+        case TWEEN_BACK_OUT: {
+            // 1 + (s+1)(t-1)^3 + s(t-1)^2 with s ~= 1.7
+            int32_t u = t - 256;
+            int32_t u2 = (u * u) >> 8;
+            int32_t u3 = (u2 * u) >> 8;
+            return (int16_t)(256 + ((691 * u3) >> 8) + ((435 * u2) >> 8));
+        }
+        case TWEEN_LINEAR:
+        default:
+            return t;
+    }
+}
+
+// Current value of a tween at time `now`
+int16_t tweenValue(const Tween& tw, unsigned long now) {
+    unsigned long elapsed = now - tw.start;
+    if (tw.duration == 0 || elapsed >= tw.duration) {
+        return tw.to;
+    }
+    int16_t t = (int16_t)((elapsed << 8) / tw.duration);
+    int16_t k = tweenEase(tw.curve, t);
+    return tw.from + (int16_t)(((int32_t)(tw.to - tw.from) * k) >> 8);
+}
+
+bool tweenDone(const Tween& tw, unsigned long now) {
+    return (now - tw.start) >= tw.duration;
+}
+
+// Retarget a tween, starting from wherever it currently is
+void tweenTo(Tween& tw, int16_t to, uint16_t duration, uint8_t curve, unsigned long now) {
+    tw.from = tweenValue(tw, now);
+    tw.to = to;
+    tw.start = now;
+    tw.duration = duration;
+    tw.curve = curve;
+}
+
+// Snap a tween to a value with no animation
+void tweenSet(Tween& tw, int16_t value) {
+    tw.from = value;
+    tw.to = value;
+    tw.start = 0;
+    tw.duration = 0;
+    tw.curve = TWEEN_LINEAR;
+}
+
+#endif // TWEEN_H
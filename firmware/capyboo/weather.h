@@ -50,7 +50,7 @@ void getWeatherData() {
     for (int i = 0; i < 3; i++) {
         display.fillRect(75 + i * 8, 25, 4, 4, SH110X_WHITE);
     }
-    display.display();
+    display_present();
     
     http.begin(serverPath);
     int httpResponseCode = http.GET();
@@ -114,7 +114,7 @@ void getWeatherData() {
     display.println(httpResponseCode);
     display.setCursor(15, 50);
     display.println("Check API key");
-    display.display();
+    display_present();
   }
   
   http.end();
@@ -127,10 +127,10 @@ void displayWeatherOnOLED(String city, float temp, float feelsLike, int humidity
   display.drawRect(0, 0, 128, 64, SH110X_WHITE);
   display.drawLine(0, 12, 128, 12, SH110X_WHITE);
   
-  // City name (top, centered)
-  display.setTextSize(1);
-  display.setCursor(64 - (city.length() * 3), 2);
-  display.print(city);
+  // City name (top, centered); drawn from the glyph atlas so non-ASCII
+  // names from the app come out right
+  uint16_t cityGlyphs = utf8Length(city.c_str(), city.length());
+  glyphDrawText(font5x8, 64 - (cityGlyphs * 3), 2, city.c_str(), city.length(), 1);
   
   // Temperature (large, left side with icon)
   display.setTextSize(3);
@@ -138,9 +138,7 @@ void displayWeatherOnOLED(String city, float temp, float feelsLike, int humidity
   display.print(temp, 0);
   
   // Degree symbol and unit
-  display.setTextSize(1);
-  display.setCursor(45, 20);
-  display.print("o");
+  glyphDraw(font5x8, 44, 18, 0x00B0, 1);
   display.setCursor(50, 18);
   display.setTextSize(2);
   display.print("C");
@@ -151,7 +149,7 @@ void displayWeatherOnOLED(String city, float temp, float feelsLike, int humidity
   display.print("Feels");
   display.setCursor(85, 28);
   display.print(feelsLike, 0);
-  display.print("o");
+  glyphDraw(font5x8, display.getCursorX(), 28, 0x00B0, 1);
   
   // Humidity with icon (bottom left)
   display.setCursor(5, 48);
@@ -160,19 +158,18 @@ void displayWeatherOnOLED(String city, float temp, float feelsLike, int humidity
   display.print("%");
   
   // Weather description (bottom right, truncated if needed)
-  display.setCursor(50, 48);
   String shortDesc = desc;
-  if (shortDesc.length() > 12) {
-    shortDesc = shortDesc.substring(0, 9) + "...";
+  if (utf8Length(shortDesc.c_str(), shortDesc.length()) > 12) {
+    shortDesc = shortDesc.substring(0, utf8Prefix(shortDesc.c_str(), shortDesc.length(), 9)) + "...";
   }
   // Capitalize first letter
   if (shortDesc.length() > 0) {
     shortDesc = String((char)toupper(shortDesc[0])) + shortDesc.substring(1);
   }
-  display.print(shortDesc);
+  glyphDrawText(font5x8, 50, 48, shortDesc.c_str(), shortDesc.length(), 1);
   
   // Draw separator line
   display.drawLine(0, 42, 128, 42, SH110X_WHITE);
   
-  display.display();
+  display_present();
 }
@@ -0,0 +1,133 @@
+// asset_upload.h: replacing an asset that already exists
+
+#define BLE_TRANSPORT_POSIX
+#include "asset_upload.h"
+#include "check.h"
+
+// Frames filled with `fill`
+void makeFile(uint8_t* data, uint32_t size, uint8_t fill) {
+    for (uint32_t i = 0; i < size; i++) data[i] = fill + i / ASSET_FRAME_BYTES;
+}
+
+bool begin(const char* name, const uint8_t* data, uint32_t size) {
+    char command[64];
+    snprintf(command, sizeof(command), "upload:%s:%u:%x:100", name, (unsigned)size,
+             (unsigned)crc32Update(data, size));
+    return assetCommand(spanOf(command));
+}
+
+// Send bytes from the upload's offset up to `end` in 200-byte chunks
+void sendTo(const uint8_t* data, uint32_t end) {
+    while (assetUpload.active && assetUpload.offset < end) {
+        uint32_t offset = assetUpload.offset;
+        uint16_t length = min((uint32_t)200, end - offset);
+        assetChunk[0] = offset;
+        assetChunk[1] = offset >> 8;
+        assetChunk[2] = offset >> 16;
+        assetChunk[3] = offset >> 24;
+        uint16_t crc = crc16Ccitt(data + offset, length);
+        assetChunk[4] = crc;
+        assetChunk[5] = crc >> 8;
+        memcpy(assetChunk + ASSET_CHUNK_HEADER, data + offset, length);
+        assetUploadChunk(0, ASSET_CHUNK_HEADER + length);
+    }
+}
+
+bool upload(const char* name, const uint8_t* data, uint32_t size) {
+    if (!begin(name, data, size)) return false;
+    sendTo(data, size);
+    return !assetUpload.active && assetFind(spanOf(name)) >= 0;
+}
+
+// The named asset plays frames starting with `fill`
+bool holds(const char* name, uint8_t fill) {
+    int slot = assetFind(spanOf(name));
+    uint8_t frame[ASSET_FRAME_BYTES];
+    return slot >= 0 && assetReadFrame(slot, 0, frame) && frame[0] == fill &&
+           assetReadFrame(slot, assets[slot].frames - 1, frame) &&
+           frame[0] == (uint8_t)(fill + assets[slot].frames - 1);
+}
+
+uint8_t oldFile[3 * ASSET_FRAME_BYTES];
+uint8_t newFile[2 * ASSET_FRAME_BYTES];
+
+void reset() {
+    assetInit();
+    esp_partition_erase_range(assetPartition, 0, assetPartition->size);
+    assetInit();
+    makeFile(oldFile, sizeof(oldFile), 0x10);
+    makeFile(newFile, sizeof(newFile), 0x80);
+    CHECK(upload("walk", oldFile, sizeof(oldFile)));
+}
+
+// Cancelled, failed or interrupted, a replacement leaves the old asset
+void testReplacementAbandoned() {
+    reset();
+    int oldSlot = assetFind(spanOf("walk"));
+
+    CHECK(begin("walk", newFile, sizeof(newFile)));
+    CHECK(assetUpload.slot != oldSlot);
+    sendTo(newFile, ASSET_FRAME_BYTES);
+    CHECK(holds("walk", 0x10));
+    CHECK(assetCommand(spanOf("cancel")));
+    CHECK(holds("walk", 0x10));
+
+    // Announced with the wrong CRC: fails once the last byte is in
+    char command[64];
+    snprintf(command, sizeof(command), "upload:walk:%u:%x:100", (unsigned)sizeof(newFile),
+             (unsigned)crc32Update(newFile, sizeof(newFile)) ^ 1);
+    CHECK(assetCommand(spanOf(command)));
+    sendTo(newFile, sizeof(newFile));
+    CHECK(!assetUpload.active);
+    CHECK(holds("walk", 0x10));
+
+    // Power lost half way
+    CHECK(begin("walk", newFile, sizeof(newFile)));
+    sendTo(newFile, ASSET_FRAME_BYTES);
+    assetUpload.active = false;
+    assetInit();
+    CHECK(holds("walk", 0x10));
+    CHECK_EQ(assetCount(), 1);
+}
+
+// Once the new file checks out it takes over and the old slot is freed
+void testReplacementDone() {
+    reset();
+    int oldSlot = assetFind(spanOf("walk"));
+
+    CHECK(upload("walk", newFile, sizeof(newFile)));
+    CHECK(holds("walk", 0x80));
+    CHECK(!assets[oldSlot].valid);
+    CHECK_EQ(assetCount(), 1);
+
+    assetInit();
+    CHECK(holds("walk", 0x80));
+    CHECK_EQ(assetCount(), 1);
+}
+
+// With every slot taken the replacement can only go over the old one
+void testReplacementInPlace() {
+    reset();
+    for (uint8_t i = 1; i < assetSlotCount; i++) {
+        char name[8];
+        snprintf(name, sizeof(name), "a%u", i);
+        CHECK(upload(name, oldFile, ASSET_FRAME_BYTES));
+    }
+    CHECK_EQ(assetCount(), assetSlotCount);
+    CHECK(!begin("new", newFile, sizeof(newFile)));
+
+    int oldSlot = assetFind(spanOf("walk"));
+    CHECK(upload("walk", newFile, sizeof(newFile)));
+    CHECK_EQ(assetFind(spanOf("walk")), oldSlot);
+    CHECK(holds("walk", 0x80));
+    CHECK_EQ(assetCount(), assetSlotCount);
+}
+
+int main() {
+    bleConnections[0].open = true;
+    commandSource = COMMAND_SOURCE_BLE;
+    testReplacementAbandoned();
+    testReplacementDone();
+    testReplacementInPlace();
+    return checkExit("asset_upload_test");
+}
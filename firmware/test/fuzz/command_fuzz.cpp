@@ -0,0 +1,114 @@
+// Fuzz target for the command parsers: the tokenizer, setTimeFromText()
+// and messageQueueCommand().
+//
+// Each input is copied into a heap block of exactly its size, with no
+// terminator, so AddressSanitizer catches any read past the end of a
+// span - the tokenizer promises never to make one. Beyond not crashing,
+// the tokenizer's results are checked against the C library on a
+// terminated copy.
+//
+// Built with -fsanitize=fuzzer,address,undefined under Clang (libFuzzer
+// supplies main); elsewhere fuzz_main.cpp drives it. See ../CMakeLists.txt.
+
+#include <stdlib.h>
+
+#include "clock.h"
+#include "message_queue.h"
+#include "tokenizer.h"
+
+#define FUZZ_CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, #condition); \
+            abort(); \
+        } \
+    } while (0)
+
+static void fuzzTokenizer(TextSpan input, const char* terminated) {
+    // Fields joined with their delimiters give back the input
+    const char delimiters[] = {' ', ':', '/', '=', ','};
+    for (char delimiter : delimiters) {
+        TextSpan rest = input;
+        TextSpan field;
+        size_t total = 0;
+        uint16_t fields = 0;
+        while (spanSplit(rest, delimiter, field)) {
+            FUZZ_CHECK(field.data == input.data + total);
+            FUZZ_CHECK(spanIndexOf(field, delimiter) < 0);
+            total += field.length + 1;
+            fields++;
+
+            long l;
+            float f;
+            uint32_t h;
+            spanToLong(field, l);
+            spanToFloat(field, f);
+            spanToHex(field, h);
+            spanEquals(field, "show");
+            spanStartsWith(field, "ttl");
+        }
+        FUZZ_CHECK(total == (size_t)input.length + 1);
+        FUZZ_CHECK(fields >= 1);
+
+        rest = input;
+        long l;
+        float f;
+        while (spanNextLong(rest, delimiter, l) || spanNextFloat(rest, delimiter, f)) {
+        }
+    }
+
+    TextSpan trimmed = spanTrim(input);
+    FUZZ_CHECK(trimmed.data >= input.data && trimmed.data + trimmed.length <= input.data + input.length);
+
+    // A number spanToLong() accepts is the one strtol() reads from all of it
+    long value;
+    if (spanToLong(input, value)) {
+        char* end;
+        FUZZ_CHECK(strtol(terminated, &end, 10) == value && end == terminated + input.length);
+    }
+    uint32_t hex;
+    if (spanToHex(input, hex)) {
+        char* end;
+        FUZZ_CHECK(strtoul(terminated, &end, 16) == hex && end == terminated + input.length);
+    }
+
+    char copy[24];
+    size_t copied = spanCopy(input, copy, sizeof(copy));
+    FUZZ_CHECK(copied == std::min((size_t)input.length, sizeof(copy) - 1) && copy[copied] == '\0');
+    FUZZ_CHECK(spanString(input).length() == input.length);
+}
+
+extern "C" int LLVMFuzzerInitialize(int*, char***) {
+    hostSerialEcho = false;
+    hostClockManual(true);
+    return 0;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    if (size > 1024) return 0;   // Commands are far shorter; BLE writes top out at 512
+    char* text = (char*)malloc(size ? size : 1);
+    memcpy(text, data, size);
+    char* terminated = (char*)malloc(size + 1);
+    memcpy(terminated, data, size);
+    terminated[size] = '\0';
+    TextSpan input = spanOf(text, size);
+
+    fuzzTokenizer(input, terminated);
+
+    if (setTimeFromText(input)) {
+        ClockTime t = getCurrentTime();
+        FUZZ_CHECK(t.year >= 2020 && t.year <= 2099 && t.month >= 1 && t.month <= 12);
+    }
+
+    String reply;
+    messageQueueCommand(input, reply);
+    FUZZ_CHECK(reply.length() > 0);
+    FUZZ_CHECK(messageCount() <= MESSAGE_QUEUE_SLOTS);
+    const char* shown = messageUpdate();
+    if (shown) FUZZ_CHECK(strlen(shown) < MESSAGE_TEXT_MAX);
+    hostClockAdvance(1000000);
+
+    free(terminated);
+    free(text);
+    return 0;
+}
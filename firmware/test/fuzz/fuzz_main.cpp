@@ -0,0 +1,112 @@
+// Stand-in for libFuzzer's main where it isn't available (GCC). Runs
+// every corpus file given, then `-runs=N` inputs mutated from them: byte
+// flips, inserts and deletions, splices and command-syntax tokens. No
+// coverage feedback, but the same target under the same sanitizers.
+//
+//   command_fuzz [-runs=N] [-seed=N] [-max_len=N] corpus-dir-or-file...
+
+#include <dirent.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+extern "C" int LLVMFuzzerInitialize(int* argc, char*** argv);
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+
+static const char* const tokens[] = {
+    "[", "]", " ", "=", ":", "/", "p=", "ttl=", "show=", "high", "low", "-", "+", ".", "0", "9", "59", "2099",
+    "4294967295", "2147483648", "\t", "\r\n", "\xc3\xa9", "\xe2\x82",
+};
+
+static void addFile(std::vector<std::string>& corpus, const std::string& path) {
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f) return;
+    std::string data;
+    char buffer[4096];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), f)) > 0) data.append(buffer, n);
+    fclose(f);
+    corpus.push_back(data);
+}
+
+static void addPath(std::vector<std::string>& corpus, const std::string& path) {
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0) {
+        fprintf(stderr, "command_fuzz: cannot read %s\n", path.c_str());
+        exit(1);
+    }
+    if (!S_ISDIR(info.st_mode)) {
+        addFile(corpus, path);
+        return;
+    }
+    DIR* dir = opendir(path.c_str());
+    while (dirent* entry = readdir(dir)) {
+        if (entry->d_name[0] != '.') addFile(corpus, path + "/" + entry->d_name);
+    }
+    closedir(dir);
+}
+
+static std::string mutate(const std::vector<std::string>& corpus, std::mt19937& random, size_t maxLength) {
+    std::string data = corpus[random() % corpus.size()];
+    int steps = 1 + random() % 8;
+    for (int i = 0; i < steps; i++) {
+        size_t at = data.empty() ? 0 : random() % (data.size() + 1);
+        switch (random() % 6) {
+            case 0:
+                if (!data.empty()) data[random() % data.size()] ^= 1 << (random() % 8);
+                break;
+            case 1:
+                data.insert(at, 1, (char)(random() % 256));
+                break;
+            case 2:
+                if (!data.empty()) data.erase(random() % data.size(), 1 + random() % 8);
+                break;
+            case 3:
+                data.insert(at, tokens[random() % (sizeof(tokens) / sizeof(tokens[0]))]);
+                break;
+            case 4: {
+                const std::string& other = corpus[random() % corpus.size()];
+                size_t from = other.empty() ? 0 : random() % other.size();
+                data.insert(at, other, from, random() % 32);
+                break;
+            }
+            default:
+                if (!data.empty()) data.resize(random() % data.size());
+        }
+    }
+    if (data.size() > maxLength) data.resize(maxLength);
+    return data;
+}
+
+int main(int argc, char** argv) {
+    LLVMFuzzerInitialize(&argc, &argv);
+    long runs = 100000;
+    unsigned seed = 1;
+    size_t maxLength = 512;
+    std::vector<std::string> corpus;
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "-runs=", 6) == 0) runs = atol(argv[i] + 6);
+        else if (strncmp(argv[i], "-seed=", 6) == 0) seed = strtoul(argv[i] + 6, nullptr, 10);
+        else if (strncmp(argv[i], "-max_len=", 9) == 0) maxLength = strtoul(argv[i] + 9, nullptr, 10);
+        else if (argv[i][0] == '-') fprintf(stderr, "command_fuzz: ignoring %s\n", argv[i]);
+        else addPath(corpus, argv[i]);
+    }
+    corpus.push_back("");
+
+    for (const std::string& input : corpus) {
+        LLVMFuzzerTestOneInput((const uint8_t*)input.data(), input.size());
+    }
+    std::mt19937 random(seed);
+    for (long run = 0; run < runs; run++) {
+        std::string input = mutate(corpus, random, maxLength);
+        LLVMFuzzerTestOneInput((const uint8_t*)input.data(), input.size());
+    }
+    printf("command_fuzz: %zu corpus inputs, %ld mutated runs, seed %u\n", corpus.size(), runs, seed);
+    return 0;
+}
@@ -0,0 +1,56 @@
+#ifndef HOST_ADAFRUIT_GFX_H
+#define HOST_ADAFRUIT_GFX_H
+
+#include "Arduino.h"
+
+// Drawing calls the firmware still makes through the library. They don't
+// draw: the host has no panel, and what the tests look at goes through the
+// firmware's own framebuffer.
+class Adafruit_GFX : public Print {
+public:
+    Adafruit_GFX(int16_t w, int16_t h) : WIDTH(w), HEIGHT(h) {}
+    const int16_t WIDTH, HEIGHT;
+
+    virtual void drawPixel(int16_t, int16_t, uint16_t) {}
+    void drawBitmap(int16_t, int16_t, const uint8_t*, int16_t, int16_t, uint16_t) {}
+    void drawBitmap(int16_t, int16_t, const uint8_t*, int16_t, int16_t, uint16_t, uint16_t) {}
+    void drawRect(int16_t, int16_t, int16_t, int16_t, uint16_t) {}
+    void fillRect(int16_t, int16_t, int16_t, int16_t, uint16_t) {}
+    void drawRoundRect(int16_t, int16_t, int16_t, int16_t, int16_t, uint16_t) {}
+    void fillRoundRect(int16_t, int16_t, int16_t, int16_t, int16_t, uint16_t) {}
+    void drawLine(int16_t, int16_t, int16_t, int16_t, uint16_t) {}
+    void drawFastHLine(int16_t, int16_t, int16_t, uint16_t) {}
+    void drawFastVLine(int16_t, int16_t, int16_t, uint16_t) {}
+    void drawCircle(int16_t, int16_t, int16_t, uint16_t) {}
+    void fillCircle(int16_t, int16_t, int16_t, uint16_t) {}
+    void drawChar(int16_t, int16_t, unsigned char, uint16_t, uint16_t, uint8_t) {}
+
+    void setCursor(int16_t x, int16_t y) { cursorX = x; cursorY = y; }
+    int16_t getCursorX() const { return cursorX; }
+    int16_t getCursorY() const { return cursorY; }
+    void setTextColor(uint16_t) {}
+    void setTextColor(uint16_t, uint16_t) {}
+    void setTextSize(uint8_t size) { textSize = size ? size : 1; }
+    void setTextWrap(bool) {}
+    // Bounds of text in the built-in 6x8 font, no wrapping
+    void getTextBounds(const char* text, int16_t x, int16_t y, int16_t* x1, int16_t* y1, uint16_t* w, uint16_t* h) {
+        *x1 = x;
+        *y1 = y;
+        *w = strlen(text) * 6 * textSize;
+        *h = 8 * textSize;
+    }
+    void getTextBounds(const String& text, int16_t x, int16_t y, int16_t* x1, int16_t* y1, uint16_t* w, uint16_t* h) {
+        getTextBounds(text.c_str(), x, y, x1, y1, w, h);
+    }
+    size_t write(uint8_t) override { cursorX += 6 * textSize; return 1; }
+    using Print::write;
+
+    int16_t width() const { return WIDTH; }
+    int16_t height() const { return HEIGHT; }
+
+protected:
+    int16_t cursorX = 0, cursorY = 0;
+    uint8_t textSize = 1;
+};
+
+#endif // HOST_ADAFRUIT_GFX_H
@@ -0,0 +1,39 @@
+#ifndef HOST_ADAFRUIT_SH110X_H
+#define HOST_ADAFRUIT_SH110X_H
+
+#include "Adafruit_GFX.h"
+#include "Wire.h"
+
+#define SH110X_BLACK   0
+#define SH110X_WHITE   1
+#define SH110X_INVERSE 2
+
+// The panel driver: a 1 KB page-layout buffer like the real one, and a
+// display() that goes nowhere
+class Adafruit_SH1106G : public Adafruit_GFX {
+public:
+    Adafruit_SH1106G(uint16_t w, uint16_t h, TwoWire*, int8_t) : Adafruit_GFX(w, h) {}
+    bool begin(uint8_t = 0x3C, bool = true) { return true; }
+    void clearDisplay() { memset(buffer, 0, sizeof(buffer)); }
+    void display() {}
+    uint8_t* getBuffer() { return buffer; }
+    void drawPixel(int16_t x, int16_t y, uint16_t color) override {
+        if (x < 0 || y < 0 || x >= WIDTH || y >= HEIGHT) return;
+        uint8_t& b = buffer[(y / 8) * WIDTH + x];
+        uint8_t bit = 1 << (y & 7);
+        if (color == SH110X_WHITE) b |= bit;
+        else if (color == SH110X_INVERSE) b ^= bit;
+        else b &= ~bit;
+    }
+    bool getPixel(int16_t x, int16_t y) {
+        if (x < 0 || y < 0 || x >= WIDTH || y >= HEIGHT) return false;
+        return buffer[(y / 8) * WIDTH + x] & (1 << (y & 7));
+    }
+    void setContrast(uint8_t) {}
+    void oled_command(uint8_t) {}
+
+private:
+    uint8_t buffer[128 * 64 / 8];
+};
+
+#endif // HOST_ADAFRUIT_SH110X_H
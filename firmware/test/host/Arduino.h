@@ -0,0 +1,276 @@
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+// Just enough of the Arduino core to build the firmware headers on a PC
+// (see firmware/test/README.md). Only what the sketch uses is here, and it
+// behaves like the ESP32 core where the firmware can tell the difference:
+// millis() is 32 bits and wraps, String and Print format numbers the same
+// way, Serial writes go to stdout.
+//
+// ESP32 is deliberately not defined, so timebase.h takes its portable
+// path and the wrap counting in it gets exercised.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdarg.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <ctype.h>
+#include <math.h>
+#include <algorithm>
+#include <string>
+#include <type_traits>
+
+#define PROGMEM
+#define F(x) x
+#define pgm_read_byte(p)  (*(const uint8_t*)(p))
+#define pgm_read_word(p)  (*(const uint16_t*)(p))
+#define pgm_read_dword(p) (*(const uint32_t*)(p))
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define BIN 2
+#define OCT 8
+#define DEC 10
+#define HEX 16
+#define PI 3.1415926535897932384626433832795
+#define constrain(x, low, high) ((x) < (low) ? (low) : ((x) > (high) ? (high) : (x)))
+
+typedef uint8_t byte;
+using std::min;
+using std::max;
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+long random(long howBig);
+long random(long howSmall, long howBig);
+void randomSeed(unsigned long seed);
+
+void pinMode(int pin, int mode);
+int digitalRead(int pin);
+void digitalWrite(int pin, int value);
+int analogRead(int pin);
+void analogWrite(int pin, int value);
+
+inline bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+// ---------------------------------------------------------------------------
+// Host controls, for the tests and the simulator only
+
+// Manual: time stands still except for hostClockAdvance() and delay().
+// Otherwise millis() follows the real clock from program start and delay()
+// sleeps for hostDelayScale times the time asked for.
+void hostClockManual(bool manual);
+void hostClockAdvance(uint64_t us);
+uint64_t hostClockMicros();
+extern double hostDelayScale;
+
+extern bool hostSerialEcho;         // Serial output goes to stdout
+extern int hostPinLevel[64];        // What digitalRead() returns per pin
+
+// ---------------------------------------------------------------------------
+// String
+
+class String {
+public:
+    String(const char* text = "") : s(text ? text : "") {}
+    String(const std::string& text) : s(text) {}
+    explicit String(char c) : s(1, c) {}
+    explicit String(unsigned char value, unsigned char base = DEC) : s(number(value, base)) {}
+    explicit String(int value, unsigned char base = DEC) : s(number(value, base)) {}
+    explicit String(unsigned int value, unsigned char base = DEC) : s(number(value, base)) {}
+    explicit String(long value, unsigned char base = DEC) : s(number(value, base)) {}
+    explicit String(unsigned long value, unsigned char base = DEC) : s(number(value, base)) {}
+    explicit String(long long value, unsigned char base = DEC) : s(number(value, base)) {}
+    explicit String(unsigned long long value, unsigned char base = DEC) : s(number(value, base)) {}
+    explicit String(float value, unsigned char decimals = 2) : s(fixed(value, decimals)) {}
+    explicit String(double value, unsigned char decimals = 2) : s(fixed(value, decimals)) {}
+
+    unsigned int length() const { return s.size(); }
+    bool isEmpty() const { return s.empty(); }
+    const char* c_str() const { return s.c_str(); }
+    void reserve(unsigned int size) { s.reserve(size); }
+
+    char charAt(unsigned int i) const { return i < s.size() ? s[i] : 0; }
+    char operator[](unsigned int i) const { return charAt(i); }
+    char& operator[](unsigned int i) { return s[i]; }
+
+    bool concat(const String& other) { s += other.s; return true; }
+    bool concat(const char* text) { if (!text) return false; s += text; return true; }
+    bool concat(const char* text, unsigned int length) { if (!text) return false; s.append(text, length); return true; }
+    bool concat(char c) { s += c; return true; }
+    template <class T, class = typename std::enable_if<std::is_arithmetic<T>::value>::type>
+    bool concat(T value) { s += String(value).s; return true; }
+
+    template <class T>
+    String& operator+=(const T& value) { concat(value); return *this; }
+
+    friend String operator+(const String& a, const String& b) { return String(a.s + b.s); }
+    friend String operator+(const String& a, const char* b) { return String(a.s + b); }
+    friend String operator+(const char* a, const String& b) { return String(a + b.s); }
+    friend String operator+(const String& a, char b) { return String(a.s + b); }
+    template <class T, class = typename std::enable_if<std::is_arithmetic<T>::value>::type>
+    friend String operator+(const String& a, T b) { return String(a.s + String(b).s); }
+
+    bool equals(const String& other) const { return s == other.s; }
+    bool equalsIgnoreCase(const String& other) const {
+        return s.size() == other.s.size() && strncasecmp(s.c_str(), other.s.c_str(), s.size()) == 0;
+    }
+    bool operator==(const String& other) const { return s == other.s; }
+    bool operator==(const char* other) const { return s == (other ? other : ""); }
+    bool operator!=(const String& other) const { return s != other.s; }
+    bool operator!=(const char* other) const { return !(*this == other); }
+    bool operator<(const String& other) const { return s < other.s; }
+    int compareTo(const String& other) const { return s.compare(other.s); }
+    bool startsWith(const String& prefix) const { return s.compare(0, prefix.s.size(), prefix.s) == 0; }
+    bool endsWith(const String& suffix) const {
+        return s.size() >= suffix.s.size() && s.compare(s.size() - suffix.s.size(), suffix.s.size(), suffix.s) == 0;
+    }
+
+    int indexOf(char c, unsigned int from = 0) const { return found(s.find(c, from)); }
+    int indexOf(const String& text, unsigned int from = 0) const { return found(s.find(text.s, from)); }
+    int lastIndexOf(char c) const { return found(s.rfind(c)); }
+    int lastIndexOf(char c, unsigned int from) const { return found(s.rfind(c, from)); }
+    String substring(unsigned int from) const { return from >= s.size() ? String() : String(s.substr(from)); }
+    String substring(unsigned int from, unsigned int to) const {
+        if (from > to) std::swap(from, to);
+        return from >= s.size() ? String() : String(s.substr(from, to - from));
+    }
+
+    void trim() {
+        size_t first = s.find_first_not_of(" \t\r\n\f\v");
+        if (first == std::string::npos) { s.clear(); return; }
+        s = s.substr(first, s.find_last_not_of(" \t\r\n\f\v") - first + 1);
+    }
+    void toLowerCase() { for (char& c : s) c = tolower((unsigned char)c); }
+    void toUpperCase() { for (char& c : s) c = toupper((unsigned char)c); }
+    void replace(const String& find, const String& with) {
+        if (find.s.empty()) return;
+        for (size_t at = s.find(find.s); at != std::string::npos; at = s.find(find.s, at + with.s.size())) {
+            s.replace(at, find.s.size(), with.s);
+        }
+    }
+    void remove(unsigned int index) { if (index < s.size()) s.erase(index); }
+    void remove(unsigned int index, unsigned int count) { if (index < s.size()) s.erase(index, count); }
+
+    long toInt() const { return atol(s.c_str()); }
+    float toFloat() const { return atof(s.c_str()); }
+    void toCharArray(char* buffer, unsigned int size) const {
+        if (size == 0) return;
+        size_t n = std::min<size_t>(size - 1, s.size());
+        memcpy(buffer, s.data(), n);
+        buffer[n] = 0;
+    }
+
+private:
+    std::string s;
+
+    static int found(size_t at) { return at == std::string::npos ? -1 : (int)at; }
+
+    template <class T>
+    static std::string number(T value, unsigned char base) {
+        if (base < 2 || base > 36) base = DEC;
+        bool negative = std::is_signed<T>::value && value < 0 && base == DEC;
+        // Other bases print the two's complement, like the ESP32 core
+        unsigned long long n = negative ? 0ULL - (unsigned long long)(long long)value
+                                        : (unsigned long long)(typename std::make_unsigned<T>::type)value;
+        char digits[72];
+        char* p = digits + sizeof(digits);
+        *--p = 0;
+        do {
+            unsigned d = n % base;
+            *--p = d < 10 ? '0' + d : 'a' + d - 10;
+            n /= base;
+        } while (n);
+        if (negative) *--p = '-';
+        return p;
+    }
+
+    static std::string fixed(double value, unsigned char decimals) {
+        if (isnan(value)) return "nan";
+        if (isinf(value)) return "inf";
+        char text[64];
+        snprintf(text, sizeof(text), "%.*f", decimals, value);
+        return text;
+    }
+};
+
+// ---------------------------------------------------------------------------
+// Print, Stream, Serial
+
+class Print;
+
+class Printable {
+public:
+    virtual ~Printable() {}
+    virtual size_t printTo(Print& out) const = 0;
+};
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t) { return 1; }
+    virtual size_t write(const uint8_t* data, size_t length) {
+        size_t n = 0;
+        while (length--) n += write(*data++);
+        return n;
+    }
+    size_t write(const char* text, size_t length) { return write((const uint8_t*)text, length); }
+    size_t write(const char* text) { return text ? write(text, strlen(text)) : 0; }
+
+    size_t print(const char* text) { return write(text); }
+    size_t print(const String& text) { return write(text.c_str(), text.length()); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(unsigned char value, int base = DEC) { return print(String(value, base)); }
+    size_t print(int value, int base = DEC) { return print(String(value, base)); }
+    size_t print(unsigned int value, int base = DEC) { return print(String(value, base)); }
+    size_t print(long value, int base = DEC) { return print(String(value, base)); }
+    size_t print(unsigned long value, int base = DEC) { return print(String(value, base)); }
+    size_t print(long long value, int base = DEC) { return print(String(value, base)); }
+    size_t print(unsigned long long value, int base = DEC) { return print(String(value, base)); }
+    size_t print(double value, int decimals = 2) { return print(String(value, decimals)); }
+    size_t print(const Printable& value) { return value.printTo(*this); }
+
+    size_t println() { return write("\r\n"); }
+    template <class T>
+    size_t println(const T& value) { return print(value) + println(); }
+    template <class T>
+    size_t println(const T& value, int format) { return print(value, format) + println(); }
+
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3))) {
+        char text[256];
+        va_list args;
+        va_start(args, format);
+        int n = vsnprintf(text, sizeof(text), format, args);
+        va_end(args);
+        return n < 0 ? 0 : write(text, std::min<size_t>(n, sizeof(text) - 1));
+    }
+};
+
+class Stream : public Print {
+public:
+    virtual int available() { return 0; }
+    virtual int read() { return -1; }
+    virtual int peek() { return -1; }
+};
+
+class HardwareSerial : public Stream {
+public:
+    void begin(unsigned long) {}
+    operator bool() const { return true; }
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* data, size_t length) override;
+    using Print::write;
+};
+
+extern HardwareSerial Serial;
+
+#endif // HOST_ARDUINO_H
@@ -0,0 +1,71 @@
+#ifndef HOST_PREFERENCES_H
+#define HOST_PREFERENCES_H
+
+#include "Arduino.h"
+#include <map>
+#include <vector>
+
+// NVS in memory: one map shared by every Preferences, keyed by
+// "namespace/key", that lasts as long as the process
+std::map<std::string, std::vector<uint8_t>>& hostNvs();
+
+class Preferences {
+public:
+    bool begin(const char* name, bool = false) { space = name; return true; }
+    void end() {}
+    bool clear();
+    bool remove(const char* key) { return hostNvs().erase(path(key)) > 0; }
+    bool isKey(const char* key) { return hostNvs().count(path(key)) > 0; }
+
+    size_t putBytes(const char* key, const void* value, size_t length) { return put(key, value, length); }
+    size_t getBytes(const char* key, void* value, size_t length) { return get(key, value, length); }
+    size_t getBytesLength(const char* key) {
+        auto it = hostNvs().find(path(key));
+        return it == hostNvs().end() ? 0 : it->second.size();
+    }
+
+    size_t putString(const char* key, const char* value) { return put(key, value, strlen(value) + 1) - 1; }
+    size_t putString(const char* key, const String& value) { return putString(key, value.c_str()); }
+    String getString(const char* key, const String& fallback = String()) {
+        auto it = hostNvs().find(path(key));
+        if (it == hostNvs().end() || it->second.empty()) return fallback;
+        return String(std::string(it->second.begin(), it->second.end() - 1));
+    }
+
+    size_t putBool(const char* key, bool value) { return put(key, &value, 1); }
+    bool getBool(const char* key, bool fallback = false) { get(key, &fallback, 1); return fallback; }
+    size_t putUChar(const char* key, uint8_t value) { return put(key, &value, 1); }
+    uint8_t getUChar(const char* key, uint8_t fallback = 0) { get(key, &fallback, 1); return fallback; }
+    size_t putShort(const char* key, int16_t value) { return put(key, &value, 2); }
+    int16_t getShort(const char* key, int16_t fallback = 0) { get(key, &fallback, 2); return fallback; }
+    size_t putInt(const char* key, int32_t value) { return put(key, &value, 4); }
+    int32_t getInt(const char* key, int32_t fallback = 0) { get(key, &fallback, 4); return fallback; }
+    size_t putUInt(const char* key, uint32_t value) { return put(key, &value, 4); }
+    uint32_t getUInt(const char* key, uint32_t fallback = 0) { get(key, &fallback, 4); return fallback; }
+    size_t putLong(const char* key, int32_t value) { return put(key, &value, 4); }
+    int32_t getLong(const char* key, int32_t fallback = 0) { get(key, &fallback, 4); return fallback; }
+    size_t putULong(const char* key, uint32_t value) { return put(key, &value, 4); }
+    uint32_t getULong(const char* key, uint32_t fallback = 0) { get(key, &fallback, 4); return fallback; }
+    size_t putFloat(const char* key, float value) { return put(key, &value, 4); }
+    float getFloat(const char* key, float fallback = NAN) { get(key, &fallback, 4); return fallback; }
+
+private:
+    std::string space;
+
+    std::string path(const char* key) const { return space + "/" + key; }
+    size_t put(const char* key, const void* value, size_t length) {
+        const uint8_t* bytes = (const uint8_t*)value;
+        hostNvs()[path(key)].assign(bytes, bytes + length);
+        return length;
+    }
+    // Fixed-size values are only read back at the size they were stored
+    size_t get(const char* key, void* value, size_t length) {
+        auto it = hostNvs().find(path(key));
+        if (it == hostNvs().end()) return 0;
+        size_t n = std::min(length, it->second.size());
+        memcpy(value, it->second.data(), n);
+        return n;
+    }
+};
+
+#endif // HOST_PREFERENCES_H
@@ -0,0 +1,78 @@
+#ifndef HOST_WIFI_H
+#define HOST_WIFI_H
+
+#include "Arduino.h"
+
+// The station interface. It never associates: status() reports whatever
+// hostWifiStatus says, so a test can pretend to be online while the
+// firmware's UDP socket (WiFiUdp.h) runs over the host's network stack.
+// TCP clients and servers never connect.
+
+typedef enum {
+    WL_IDLE_STATUS = 0,
+    WL_NO_SSID_AVAIL = 1,
+    WL_SCAN_COMPLETED = 2,
+    WL_CONNECTED = 3,
+    WL_CONNECT_FAILED = 4,
+    WL_CONNECTION_LOST = 5,
+    WL_DISCONNECTED = 6
+} wl_status_t;
+
+#define WIFI_OFF  0
+#define WIFI_STA  1
+#define WIFI_AP   2
+
+extern wl_status_t hostWifiStatus;
+extern int hostDnsLookups;          // Calls to WiFi.hostByName()
+
+class IPAddress : public Printable {
+public:
+    IPAddress() : octets{0, 0, 0, 0} {}
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : octets{a, b, c, d} {}
+    uint8_t operator[](int i) const { return octets[i]; }
+    String toString() const {
+        return String((int)octets[0]) + "." + String((int)octets[1]) + "." +
+               String((int)octets[2]) + "." + String((int)octets[3]);
+    }
+    size_t printTo(Print& out) const override { return out.print(toString()); }
+
+private:
+    uint8_t octets[4];
+};
+
+class WiFiClass {
+public:
+    wl_status_t status() { return hostWifiStatus; }
+    bool mode(int) { return true; }
+    wl_status_t begin(const char*, const char* = nullptr) { return hostWifiStatus; }
+    bool disconnect(bool = false) { return true; }
+    IPAddress localIP() { return hostWifiStatus == WL_CONNECTED ? IPAddress(127, 0, 0, 1) : IPAddress(); }
+    // 1 on success, like the ESP32's; resolves with getaddrinfo()
+    int hostByName(const char* host, IPAddress& result);
+};
+
+extern WiFiClass WiFi;
+
+class Client : public Stream {
+public:
+    virtual int connect(const char*, uint16_t) { return 0; }
+    virtual bool connected() { return false; }
+    virtual void stop() {}
+    int read(uint8_t*, size_t) { return 0; }
+    using Stream::read;
+    void setNoDelay(bool) {}
+    explicit operator bool() { return connected(); }
+};
+
+class WiFiClient : public Client {};
+
+class WiFiServer {
+public:
+    explicit WiFiServer(uint16_t) {}
+    void begin() {}
+    void setNoDelay(bool) {}
+    WiFiClient available() { return WiFiClient(); }
+    WiFiClient accept() { return WiFiClient(); }
+};
+
+#endif // HOST_WIFI_H
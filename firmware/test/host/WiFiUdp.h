@@ -0,0 +1,43 @@
+#ifndef HOST_WIFI_UDP_H
+#define HOST_WIFI_UDP_H
+
+#include "WiFi.h"
+
+// A real, non-blocking UDP socket. Only the subset the firmware uses:
+// one datagram in and one out at a time.
+class WiFiUDP : public Stream {
+public:
+    ~WiFiUDP() { stop(); }
+
+    // Binds `port`, or any free port if that one is taken (several test
+    // processes may run at once; only the server side cares which it is)
+    uint8_t begin(uint16_t port);
+    void stop();
+
+    int beginPacket(const char* host, uint16_t port);
+    int beginPacket(IPAddress ip, uint16_t port);
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* data, size_t length) override;
+    using Print::write;
+    int endPacket();
+
+    // Size of the next datagram, 0 if none has arrived
+    int parsePacket();
+    int available() override { return received - readAt; }
+    int read() override { return readAt < received ? incoming[readAt++] : -1; }
+    int read(uint8_t* data, size_t length);
+    int peek() override { return readAt < received ? incoming[readAt] : -1; }
+    void flush() {}
+
+private:
+    int fd = -1;
+    uint8_t destination[16];        // sockaddr_in of beginPacket()
+    bool haveDestination = false;
+    uint8_t outgoing[1472];
+    size_t outgoingLength = 0;
+    uint8_t incoming[1472];
+    int received = 0;
+    int readAt = 0;
+};
+
+#endif // HOST_WIFI_UDP_H
@@ -0,0 +1,265 @@
+// Host implementations behind the stand-in headers in this directory
+
+#include "Arduino.h"
+#include "Preferences.h"
+#include "WiFi.h"
+#include "WiFiUdp.h"
+#include "Wire.h"
+#include "esp_partition.h"
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <thread>
+
+HardwareSerial Serial;
+TwoWire Wire;
+WiFiClass WiFi;
+
+// ---------------------------------------------------------------------------
+// Time
+
+double hostDelayScale = 1.0;
+static std::atomic<bool> hostManual(false);
+static std::atomic<uint64_t> hostManualMicros(0);
+static const std::chrono::steady_clock::time_point hostStart = std::chrono::steady_clock::now();
+
+void hostClockManual(bool manual) {
+    if (manual) hostManualMicros = hostClockMicros();
+    hostManual = manual;
+}
+
+void hostClockAdvance(uint64_t us) {
+    hostManualMicros += us;
+}
+
+uint64_t hostClockMicros() {
+    if (hostManual) return hostManualMicros;
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - hostStart).count();
+}
+
+// 32 bits, like the ESP32's, so it wraps after 49.7 days
+unsigned long millis() {
+    return (uint32_t)(hostClockMicros() / 1000);
+}
+
+unsigned long micros() {
+    return (uint32_t)hostClockMicros();
+}
+
+void delay(unsigned long ms) {
+    if (hostManual) {
+        hostClockAdvance((uint64_t)ms * 1000);
+    } else if (hostDelayScale > 0) {
+        std::this_thread::sleep_for(std::chrono::microseconds((int64_t)(ms * 1000 * hostDelayScale)));
+    } else {
+        std::this_thread::yield();
+    }
+}
+
+void delayMicroseconds(unsigned int us) {
+    if (hostManual) hostClockAdvance(us);
+}
+
+void yield() {
+    std::this_thread::yield();
+}
+
+// ---------------------------------------------------------------------------
+// Random numbers, pins
+
+static std::mt19937 hostRandom(1);
+
+long random(long howBig) {
+    return howBig <= 0 ? 0 : (long)(hostRandom() % (unsigned long)howBig);
+}
+
+long random(long howSmall, long howBig) {
+    return howSmall >= howBig ? howSmall : howSmall + random(howBig - howSmall);
+}
+
+void randomSeed(unsigned long seed) {
+    hostRandom.seed(seed);
+}
+
+int hostPinLevel[64];
+
+void pinMode(int, int) {}
+void digitalWrite(int, int) {}
+void analogWrite(int, int) {}
+int analogRead(int) { return 0; }
+
+int digitalRead(int pin) {
+    return pin >= 0 && pin < 64 ? hostPinLevel[pin] : LOW;
+}
+
+// ---------------------------------------------------------------------------
+// Serial
+
+bool hostSerialEcho = true;
+
+size_t HardwareSerial::write(uint8_t c) {
+    if (hostSerialEcho && c != '\r') fputc(c, stdout);
+    return 1;
+}
+
+size_t HardwareSerial::write(const uint8_t* data, size_t length) {
+    for (size_t i = 0; i < length; i++) write(data[i]);
+    return length;
+}
+
+// ---------------------------------------------------------------------------
+// Preferences
+
+std::map<std::string, std::vector<uint8_t>>& hostNvs() {
+    static std::map<std::string, std::vector<uint8_t>> nvs;
+    return nvs;
+}
+
+bool Preferences::clear() {
+    std::string prefix = space + "/";
+    auto& nvs = hostNvs();
+    for (auto it = nvs.lower_bound(prefix); it != nvs.end() && it->first.compare(0, prefix.size(), prefix) == 0;) {
+        it = nvs.erase(it);
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Flash
+
+uint8_t hostFlash[HOST_FLASH_SIZE];
+uint32_t hostFlashErases = 0;
+static esp_partition_t hostPartition = {ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_DATA_SPIFFS, 0x290000,
+                                        HOST_FLASH_SIZE, "spiffs"};
+
+const esp_partition_t* esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype,
+                                                const char*) {
+    static bool erased = false;
+    if (!erased) {
+        memset(hostFlash, 0xFF, sizeof(hostFlash));
+        erased = true;
+    }
+    return type == hostPartition.type && subtype == hostPartition.subtype ? &hostPartition : nullptr;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t* partition, size_t offset, void* dst, size_t size) {
+    if (partition != &hostPartition || offset + size > partition->size) return ESP_ERR_INVALID_SIZE;
+    memcpy(dst, hostFlash + offset, size);
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t* partition, size_t offset, const void* src, size_t size) {
+    if (partition != &hostPartition || offset + size > partition->size) return ESP_ERR_INVALID_SIZE;
+    const uint8_t* bytes = (const uint8_t*)src;
+    for (size_t i = 0; i < size; i++) hostFlash[offset + i] &= bytes[i];
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t* partition, size_t offset, size_t size) {
+    if (partition != &hostPartition || offset + size > partition->size) return ESP_ERR_INVALID_SIZE;
+    if (offset % HOST_FLASH_SECTOR || size % HOST_FLASH_SECTOR) return ESP_ERR_INVALID_ARG;
+    memset(hostFlash + offset, 0xFF, size);
+    hostFlashErases++;
+    return ESP_OK;
+}
+
+// ---------------------------------------------------------------------------
+// WiFi and UDP
+
+wl_status_t hostWifiStatus = WL_DISCONNECTED;
+int hostDnsLookups = 0;
+
+int WiFiClass::hostByName(const char* host, IPAddress& result) {
+    hostDnsLookups++;
+    addrinfo hints = {};
+    hints.ai_family = AF_INET;
+    addrinfo* found = nullptr;
+    if (getaddrinfo(host, nullptr, &hints, &found) != 0 || !found) return 0;
+    uint32_t address = ntohl(((sockaddr_in*)found->ai_addr)->sin_addr.s_addr);
+    freeaddrinfo(found);
+    result = IPAddress(address >> 24, address >> 16, address >> 8, address);
+    return 1;
+}
+
+uint8_t WiFiUDP::begin(uint16_t port) {
+    stop();
+    fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) return 0;
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    sockaddr_in local = {};
+    local.sin_family = AF_INET;
+    local.sin_addr.s_addr = htonl(INADDR_ANY);
+    local.sin_port = htons(port);
+    if (bind(fd, (sockaddr*)&local, sizeof(local)) < 0) {
+        local.sin_port = 0;
+        if (bind(fd, (sockaddr*)&local, sizeof(local)) < 0) {
+            stop();
+            return 0;
+        }
+    }
+    return 1;
+}
+
+void WiFiUDP::stop() {
+    if (fd >= 0) close(fd);
+    fd = -1;
+    received = readAt = 0;
+}
+
+int WiFiUDP::beginPacket(const char* host, uint16_t port) {
+    addrinfo hints = {};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+    addrinfo* found = nullptr;
+    if (getaddrinfo(host, nullptr, &hints, &found) != 0 || !found) return 0;
+    sockaddr_in address = *(sockaddr_in*)found->ai_addr;
+    freeaddrinfo(found);
+    address.sin_port = htons(port);
+    static_assert(sizeof(address) <= sizeof(destination), "sockaddr_in");
+    memcpy(destination, &address, sizeof(address));
+    haveDestination = true;
+    outgoingLength = 0;
+    return 1;
+}
+
+int WiFiUDP::beginPacket(IPAddress ip, uint16_t port) {
+    return beginPacket(ip.toString().c_str(), port);
+}
+
+size_t WiFiUDP::write(const uint8_t* data, size_t length) {
+    length = std::min(length, sizeof(outgoing) - outgoingLength);
+    memcpy(outgoing + outgoingLength, data, length);
+    outgoingLength += length;
+    return length;
+}
+
+int WiFiUDP::endPacket() {
+    if (fd < 0 || !haveDestination) return 0;
+    ssize_t sent = sendto(fd, outgoing, outgoingLength, 0, (const sockaddr*)destination, sizeof(sockaddr_in));
+    outgoingLength = 0;
+    return sent >= 0;
+}
+
+int WiFiUDP::parsePacket() {
+    received = readAt = 0;
+    if (fd < 0) return 0;
+    ssize_t n = recv(fd, incoming, sizeof(incoming), 0);
+    if (n <= 0) return 0;
+    received = n;
+    return n;
+}
+
+int WiFiUDP::read(uint8_t* data, size_t length) {
+    int n = std::min<int>(length, received - readAt);
+    memcpy(data, incoming + readAt, n);
+    readAt += n;
+    return n;
+}
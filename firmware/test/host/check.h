@@ -0,0 +1,45 @@
+#ifndef HOST_CHECK_H
+#define HOST_CHECK_H
+
+#include <stdio.h>
+
+// Minimal assertions for the host tests: a failed CHECK prints where and
+// what, and the test carries on; checkExit() turns the tally into the
+// process exit code ctest looks at.
+
+inline int checkFailures = 0;
+
+#define CHECK(condition) \
+    checkRecord((condition), __FILE__, __LINE__, #condition)
+
+#define CHECK_EQ(actual, expected) \
+    checkRecordEqual((long long)(actual), (long long)(expected), __FILE__, __LINE__, #actual, #expected)
+
+inline bool checkRecord(bool ok, const char* file, int line, const char* what) {
+    if (!ok) {
+        checkFailures++;
+        fprintf(stderr, "%s:%d: CHECK(%s) failed\n", file, line, what);
+    }
+    return ok;
+}
+
+inline bool checkRecordEqual(long long actual, long long expected, const char* file, int line,
+                             const char* actualText, const char* expectedText) {
+    if (actual != expected) {
+        checkFailures++;
+        fprintf(stderr, "%s:%d: %s == %lld, expected %s == %lld\n", file, line, actualText, actual, expectedText,
+                expected);
+    }
+    return actual == expected;
+}
+
+inline int checkExit(const char* name) {
+    if (checkFailures) {
+        fprintf(stderr, "%s: %d check(s) failed\n", name, checkFailures);
+        return 1;
+    }
+    printf("%s: ok\n", name);
+    return 0;
+}
+
+#endif // HOST_CHECK_H
@@ -0,0 +1,15 @@
+#ifndef SECRETS_H
+#define SECRETS_H
+
+// Placeholders for host builds; the host never goes on the network
+
+const char* WIFI_SSID = "host";
+const char* WIFI_PASSWORD = "";
+
+const char* MQTT_BROKER = "localhost";
+const char* MQTT_USERNAME = "";
+const char* MQTT_PASSWORD = "";
+
+const char* WEATHER_API_KEY = "";
+
+#endif // SECRETS_H
@@ -0,0 +1,79 @@
+// message_queue.h: "message:" options and expiry
+
+#include "message_queue.h"
+#include "check.h"
+
+void advanceSeconds(uint32_t seconds) {
+    hostClockAdvance((uint64_t)seconds * 1000000);
+}
+
+String reply;
+
+bool queue(const char* command) {
+    reply = "";
+    return messageQueueCommand(spanOf(command), reply);
+}
+
+// Shown now, and still there after `seconds`
+bool aliveAfter(uint32_t seconds) {
+    advanceSeconds(seconds);
+    return messageUpdate() != nullptr;
+}
+
+void testDefaultTtl() {
+    messageClearAll();
+    CHECK(queue("hello"));
+    CHECK(aliveAfter(MESSAGE_DEFAULT_TTL / 1000 - 1));
+    CHECK(!aliveAfter(1));
+}
+
+// Longer than a day is a day: on the device 2147484 s and more would
+// expire at once, and more than 4294967 s would wrap the ms count
+void testLargeTtl() {
+    const char* commands[] = {"[ttl=86401] a", "[ttl=2147484] b", "[ttl=4294968] c", "[ttl=2147483647] d"};
+    for (const char* command : commands) {
+        messageClearAll();
+        CHECK(queue(command));
+        CHECK(aliveAfter(1));
+        CHECK(aliveAfter(MESSAGE_MAX_TTL - 2));
+        CHECK(!aliveAfter(1));
+    }
+
+    messageClearAll();
+    CHECK(queue("[ttl=30] short"));
+    CHECK(aliveAfter(29));
+    CHECK(!aliveAfter(1));
+}
+
+// Each way a message can fail gets its own reply
+void testReplies() {
+    messageClearAll();
+    CHECK(!queue("[p=low]"));
+    CHECK(reply == "Message text is empty");
+    CHECK(!queue("[p=high ttl=5]   "));
+    CHECK(reply == "Message text is empty");
+    CHECK_EQ(messageCount(), 0);
+
+    for (int i = 0; i < MESSAGE_QUEUE_SLOTS; i++) {
+        String text = "high " + String(i);
+        CHECK(queue(("[p=high] " + text).c_str()));
+    }
+    CHECK(reply == "Message queued (8 in queue)");
+    CHECK(!queue("[p=low] lost"));
+    CHECK(reply == "Message dropped: queue full of higher priority messages");
+
+    CHECK(queue(""));
+    CHECK(reply == "Messages cleared");
+    CHECK_EQ(messageCount(), 0);
+}
+
+int main() {
+    hostClockManual(true);
+    // Close to where a 32-bit millis() wraps
+    hostClockAdvance((uint64_t)(UINT32_MAX - 3600000) * 1000);
+
+    testDefaultTtl();
+    testLargeTtl();
+    testReplies();
+    return checkExit("message_queue_test");
+}
@@ -0,0 +1,64 @@
+// mqtt.h: reconnecting from loop() with the broker down, up and dropping
+
+#include "mqtt.h"
+#include "check.h"
+
+// Runs handleMQTT() like loop() does for `seconds`; the connection
+// attempts it made
+int runFor(uint32_t seconds) {
+    int before = hostMqttConnects;
+    for (uint32_t ms = 0; ms < seconds * 1000; ms += 100) {
+        handleMQTT();
+        hostClockAdvance(100000);
+    }
+    return hostMqttConnects - before;
+}
+
+void testNoWifi() {
+    hostWifiStatus = WL_DISCONNECTED;
+    CHECK_EQ(runFor(60), 0);
+    hostWifiStatus = WL_CONNECTED;
+}
+
+// 5, 10, 20 ... s apart, then every 300 s
+void testBackoff() {
+    CHECK_EQ(runFor(1), 1);
+    CHECK_EQ(runFor(5), 1);
+    CHECK_EQ(runFor(10), 1);
+    CHECK_EQ(runFor(20), 1);
+    CHECK_EQ(runFor(40), 1);
+    CHECK_EQ(runFor(80), 1);
+    CHECK_EQ(runFor(160), 1);
+    CHECK_EQ(runFor(3150), 10);
+    CHECK(!mqttConnected);
+
+    // Publishing doesn't try to connect
+    int before = hostMqttConnects;
+    CHECK(!publishStatus("hello"));
+    CHECK_EQ(hostMqttConnects, before);
+}
+
+void testReconnect() {
+    hostMqttBrokerUp = true;
+    CHECK_EQ(runFor(300), 1);
+    CHECK(mqttConnected);
+    CHECK(publishStatus("hello"));
+
+    // A dropped connection is retried at once, then backs off from the start
+    hostMqttBrokerUp = false;
+    CHECK_EQ(runFor(1), 1);
+    CHECK_EQ(runFor(5), 1);
+    CHECK_EQ(runFor(10), 1);
+    CHECK(!mqttConnected);
+}
+
+int main() {
+    hostClockManual(true);
+    hostSerialEcho = false;
+    initMQTT();
+
+    testNoWifi();
+    testBackoff();
+    testReconnect();
+    return checkExit("mqtt_test");
+}
@@ -0,0 +1,148 @@
+// scheduler.h: alarms, timers and repeats across clock steps
+
+#include "scheduler.h"
+#include "check.h"
+
+// Defined in capyboo.ino
+bool scheduleActionValid(uint8_t action, const char* arg) {
+    return true;
+}
+
+// Runs schedulerPoll() like loop() does; the number of events that fired
+int poll() {
+    ScheduledEvent fired;
+    int count = 0;
+    while (schedulerPoll(fired)) count++;
+    return count;
+}
+
+void advanceSeconds(uint32_t seconds) {
+    hostClockAdvance((uint64_t)seconds * 1000000);
+}
+
+// Steps the wall clock by `ms` without time passing on the timebase
+void stepClock(int64_t ms) {
+    clockSync(clockEpochMillis() + ms, timebaseMillis());
+}
+
+void reset(int hour, int minute, int second) {
+    schedulerClear();
+    CHECK(setTime(hour, minute, second, 1, 6, 2025));
+    poll();
+}
+
+void testAlarmFires() {
+    reset(6, 59, 0);
+    CHECK(schedulerAdd(SCHEDULE_ALARM, 7 * 3600, SCHEDULE_ACTION_MOOD, "happy") != 0);
+    advanceSeconds(59);
+    CHECK_EQ(poll(), 0);
+    advanceSeconds(1);
+    CHECK_EQ(poll(), 1);
+    CHECK_EQ(schedulerHeap[0].wall, calendarToEpoch(2025, 6, 2, 7, 0, 0));
+}
+
+// Stepped forward over the alarm: it fires once, then keeps to its time
+void testStepForwardOverAlarm() {
+    reset(6, 59, 0);
+    schedulerAdd(SCHEDULE_ALARM, 7 * 3600, SCHEDULE_ACTION_MOOD, "happy");
+    stepClock(3600 * 1000LL);
+    CHECK_EQ(poll(), 1);
+    CHECK_EQ(poll(), 0);
+    CHECK_EQ(schedulerHeap[0].wall, calendarToEpoch(2025, 6, 2, 7, 0, 0));
+
+    // Several days on still fires once
+    stepClock(3 * 86400 * 1000LL);
+    CHECK_EQ(poll(), 1);
+    CHECK_EQ(schedulerHeap[0].wall, calendarToEpoch(2025, 6, 5, 7, 0, 0));
+}
+
+// A small NTP correction across the alarm's second
+void testCorrectionOverAlarm() {
+    reset(6, 59, 59);
+    hostClockAdvance(980000);
+    schedulerAdd(SCHEDULE_ALARM, 7 * 3600, SCHEDULE_ACTION_MOOD, "happy");
+    stepClock(40);
+    CHECK_EQ(poll(), 1);
+}
+
+// An NTP correction pulls the clock back across an alarm that just fired
+void testStepBackAfterAlarm() {
+    reset(6, 59, 59);
+    schedulerAdd(SCHEDULE_ALARM, 7 * 3600, SCHEDULE_ACTION_MOOD, "happy");
+    advanceSeconds(1);
+    CHECK_EQ(poll(), 1);
+    hostClockAdvance(200000);
+    stepClock(-500);
+    CHECK_EQ(poll(), 0);
+    advanceSeconds(2);
+    CHECK_EQ(poll(), 0);
+    CHECK_EQ(schedulerHeap[0].wall, calendarToEpoch(2025, 6, 2, 7, 0, 0));
+
+    // A larger step back, still the same day: not again today either
+    stepClock(-3 * 3600 * 1000LL);
+    advanceSeconds(4 * 3600);
+    CHECK_EQ(poll(), 0);
+    CHECK_EQ(schedulerHeap[0].wall, calendarToEpoch(2025, 6, 2, 7, 0, 0));
+
+    // Back more than a day: the next occurrence is the one to wait for
+    stepClock(-2 * 86400 * 1000LL);
+    CHECK_EQ(poll(), 0);
+    CHECK_EQ(schedulerHeap[0].wall, calendarToEpoch(2025, 5, 31, 7, 0, 0));
+}
+
+// Backwards, and forwards short of it: nothing fires early
+void testStepsShortOfAlarm() {
+    reset(6, 0, 0);
+    schedulerAdd(SCHEDULE_ALARM, 7 * 3600, SCHEDULE_ACTION_MOOD, "happy");
+    stepClock(-2 * 3600 * 1000LL);
+    CHECK_EQ(poll(), 0);
+    stepClock(2 * 3600 * 1000LL + 30 * 60 * 1000LL);
+    CHECK_EQ(poll(), 0);
+    CHECK_EQ(schedulerHeap[0].wall, calendarToEpoch(2025, 6, 1, 7, 0, 0));
+    advanceSeconds(30 * 60);
+    CHECK_EQ(poll(), 1);
+}
+
+// Restored from flash long after it was saved: no stale firing
+void testRestoredAlarm() {
+    reset(6, 59, 0);
+    schedulerAdd(SCHEDULE_ALARM, 7 * 3600, SCHEDULE_ACTION_MOOD, "happy");
+    timeInitialized = false;
+    initScheduler();
+    CHECK_EQ(schedulerCount, 1);
+    CHECK(setTime(12, 0, 0, 1, 6, 2025));
+    CHECK_EQ(poll(), 0);
+    CHECK_EQ(schedulerHeap[0].wall, calendarToEpoch(2025, 6, 2, 7, 0, 0));
+}
+
+void testTimersAndRepeats() {
+    reset(12, 0, 0);
+    schedulerAdd(SCHEDULE_TIMER, 600, SCHEDULE_ACTION_MOOD, "happy");
+    stepClock(3600 * 1000LL);
+    CHECK_EQ(poll(), 1);
+    CHECK_EQ(schedulerCount, 0);
+
+    // Keeps its alignment, skips the repeats stepped over
+    schedulerAdd(SCHEDULE_EVERY, 60, SCHEDULE_ACTION_MOOD, "happy");
+    int64_t first = schedulerHeap[0].wall;
+    stepClock(150 * 1000LL);
+    CHECK_EQ(poll(), 0);
+    CHECK_EQ(schedulerHeap[0].wall, first + 120);
+    advanceSeconds(30);
+    CHECK_EQ(poll(), 1);
+}
+
+int main() {
+    hostClockManual(true);
+    hostSerialEcho = false;
+    initScheduler();
+
+    testAlarmFires();
+    testStepForwardOverAlarm();
+    testCorrectionOverAlarm();
+    testStepBackAfterAlarm();
+    testStepsShortOfAlarm();
+    testRestoredAlarm();
+    testTimersAndRepeats();
+    return checkExit("scheduler_test");
+}
@@ -0,0 +1,442 @@
+// Runs the sketch on the PC with the BLE serial port on a TCP socket
+// (ble_transport_posix.h) and drives it like the phone app does: framed,
+// sequenced commands, several in flight, results taken from the batched
+// "ack:"/"nack:" lines. It reports throughput and per-command latency, and
+// checks the replies a session expects.
+//
+//   capyboo_sim [options] session.txt...
+//
+// A session is one command per line, sent as "#<id> <command>":
+//
+//   mode:clock              expects an ack
+//   !mode:bogus             expects a nack
+//   @wait 250               waits for everything in flight, then 250 ms
+//   @expect Clock face set  waits until a line containing the text arrives
+//   @absent Mood set to     fails if a line since the last @expect has it
+//   # comment
+//
+// --record writes the commands typed on stdin, with the pauses between
+// them, as a session that replays the same traffic. --connect drives a
+// device running ble_transport_tcp.h instead of the sketch built in here.
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Arduino.h"
+
+// The sketch, built from capyboo.ino with -DBLE_TRANSPORT_POSIX
+void setup();
+void loop();
+extern uint16_t blePosixPort;
+
+typedef std::chrono::steady_clock SimClock;
+
+struct SimOptions {
+    std::string host = "127.0.0.1";
+    uint16_t port = 0;
+    bool external = false;
+    double delayScale = 1.0;
+    int pipeline = 4;
+    int repeat = 1;
+    int timeoutMs = 5000;
+    bool verbose = false;
+    std::string record;
+    std::vector<std::string> sessions;
+};
+
+struct SimStep {
+    enum Kind { COMMAND, WAIT, EXPECT, ABSENT } kind;
+    std::string text;
+    bool expectOk = true;
+    int waitMs = 0;
+    std::string where;          // file:line, for failures
+};
+
+struct InFlight {
+    SimClock::time_point sent;
+    bool expectOk;
+    std::string command;
+    std::string where;
+};
+
+int simSocket = -1;
+std::string simInput;           // Received bytes not yet split into lines
+std::vector<std::string> simLines;  // Lines since the last @expect matched
+std::map<uint16_t, InFlight> simInFlight;
+std::vector<double> simLatencies;   // ms, one per acknowledged command
+uint16_t simNextId = 1;
+int simFailures = 0;
+bool simVerbose = false;
+
+// ---------------------------------------------------------------------------
+// Wire format
+
+uint16_t simCrc16(const uint8_t* data, size_t length, uint16_t crc) {
+    for (size_t i = 0; i < length; i++) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (int bit = 0; bit < 8; bit++) crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+    return crc;
+}
+
+// 0x02 | length | payload | CRC-16/CCITT-FALSE over length and payload
+std::string simFrame(const std::string& payload) {
+    std::string frame;
+    frame += '\x02';
+    frame += (char)(payload.size() & 0xFF);
+    frame += (char)(payload.size() >> 8);
+    frame += payload;
+    uint16_t crc = simCrc16((const uint8_t*)frame.data() + 1, frame.size() - 1, 0xFFFF);
+    frame += (char)(crc & 0xFF);
+    frame += (char)(crc >> 8);
+    return frame;
+}
+
+bool simSendAll(const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = send(simSocket, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) return false;
+        sent += n;
+    }
+    return true;
+}
+
+void simFail(const std::string& where, const std::string& what) {
+    std::cerr << where << ": " << what << "\n";
+    simFailures++;
+}
+
+// "1-3,7" after "ack:" or "nack:"
+void simTakeAcks(const std::string& list, bool ok, SimClock::time_point now) {
+    size_t at = 0;
+    while (at < list.size()) {
+        size_t comma = list.find(',', at);
+        if (comma == std::string::npos) comma = list.size();
+        std::string range = list.substr(at, comma - at);
+        size_t dash = range.find('-');
+        unsigned long first = strtoul(range.c_str(), nullptr, 10);
+        unsigned long last = dash == std::string::npos ? first : strtoul(range.c_str() + dash + 1, nullptr, 10);
+        for (unsigned long id = first; id <= last && id <= 0xFFFF; id++) {
+            auto found = simInFlight.find((uint16_t)id);
+            if (found == simInFlight.end()) {
+                simFail("device", "result for a command not in flight: " + std::to_string(id));
+                continue;
+            }
+            const InFlight& command = found->second;
+            simLatencies.push_back(std::chrono::duration<double, std::milli>(now - command.sent).count());
+            if (ok != command.expectOk) {
+                simFail(command.where, std::string(ok ? "ack" : "nack") + " for \"" + command.command + "\"");
+            }
+            simInFlight.erase(found);
+        }
+        at = comma + 1;
+    }
+}
+
+// Reads what has arrived within `waitMs`; false if the device hung up
+bool simReceive(int waitMs) {
+    pollfd p = {simSocket, POLLIN, 0};
+    if (poll(&p, 1, waitMs) <= 0) return true;
+    char buffer[4096];
+    ssize_t n = recv(simSocket, buffer, sizeof(buffer), 0);
+    if (n <= 0) return false;
+    simInput.append(buffer, n);
+
+    SimClock::time_point now = SimClock::now();
+    size_t newline;
+    while ((newline = simInput.find('\n')) != std::string::npos) {
+        std::string line = simInput.substr(0, newline);
+        simInput.erase(0, newline + 1);
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (simVerbose) std::cout << "< " << line << "\n";
+        if (line.compare(0, 4, "ack:") == 0) {
+            simTakeAcks(line.substr(4), true, now);
+        } else if (line.compare(0, 5, "nack:") == 0) {
+            simTakeAcks(line.substr(5), false, now);
+        } else {
+            simLines.push_back(line);
+        }
+    }
+    return true;
+}
+
+// Waits until no more than `limit` commands are in flight
+bool simDrain(size_t limit, int timeoutMs) {
+    SimClock::time_point deadline = SimClock::now() + std::chrono::milliseconds(timeoutMs);
+    while (simInFlight.size() > limit) {
+        if (SimClock::now() >= deadline) {
+            simFail(simInFlight.begin()->second.where,
+                    "no result for \"" + simInFlight.begin()->second.command + "\"");
+            simInFlight.clear();
+            return false;
+        }
+        if (!simReceive(10)) {
+            simFail("device", "disconnected");
+            return false;
+        }
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Sessions
+
+bool simLoad(const std::string& path, std::vector<SimStep>& steps) {
+    std::ifstream in(path);
+    if (!in) {
+        std::cerr << path << ": cannot open\n";
+        return false;
+    }
+    std::string line;
+    int number = 0;
+    while (std::getline(in, line)) {
+        number++;
+        size_t start = line.find_first_not_of(" \t");
+        if (start == std::string::npos || line[start] == '#') continue;
+        line = line.substr(start, line.find_last_not_of(" \t\r") + 1 - start);
+
+        SimStep step;
+        step.where = path + ":" + std::to_string(number);
+        if (line.compare(0, 6, "@wait ") == 0) {
+            step.kind = SimStep::WAIT;
+            step.waitMs = atoi(line.c_str() + 6);
+        } else if (line.compare(0, 8, "@expect ") == 0) {
+            step.kind = SimStep::EXPECT;
+            step.text = line.substr(8);
+        } else if (line.compare(0, 8, "@absent ") == 0) {
+            step.kind = SimStep::ABSENT;
+            step.text = line.substr(8);
+        } else if (line[0] == '@') {
+            std::cerr << step.where << ": unknown directive\n";
+            return false;
+        } else {
+            step.kind = SimStep::COMMAND;
+            step.expectOk = line[0] != '!';
+            step.text = step.expectOk ? line : line.substr(1);
+        }
+        steps.push_back(step);
+    }
+    return true;
+}
+
+bool simRun(const std::vector<SimStep>& steps, const SimOptions& options) {
+    for (const SimStep& step : steps) {
+        switch (step.kind) {
+            case SimStep::COMMAND: {
+                if (!simDrain(options.pipeline - 1, options.timeoutMs)) return false;
+                uint16_t id = simNextId++;
+                if (simNextId == 0) simNextId = 1;
+                simInFlight[id] = {SimClock::now(), step.expectOk, step.text, step.where};
+                if (!simSendAll(simFrame("#" + std::to_string(id) + " " + step.text))) {
+                    simFail(step.where, "send failed");
+                    return false;
+                }
+                break;
+            }
+            case SimStep::WAIT:
+                if (!simDrain(0, options.timeoutMs)) return false;
+                std::this_thread::sleep_for(std::chrono::milliseconds(step.waitMs));
+                break;
+            case SimStep::EXPECT: {
+                if (!simDrain(0, options.timeoutMs)) return false;
+                SimClock::time_point deadline = SimClock::now() + std::chrono::milliseconds(options.timeoutMs);
+                bool found = false;
+                while (!found) {
+                    for (size_t i = 0; i < simLines.size() && !found; i++) {
+                        found = simLines[i].find(step.text) != std::string::npos;
+                    }
+                    if (found) break;
+                    if (SimClock::now() >= deadline || !simReceive(10)) break;
+                }
+                if (!found) simFail(step.where, "no reply containing \"" + step.text + "\"");
+                simLines.clear();
+                break;
+            }
+            case SimStep::ABSENT:
+                // Replies come before the ack, so they are all in by now
+                if (!simDrain(0, options.timeoutMs)) return false;
+                for (const std::string& line : simLines) {
+                    if (line.find(step.text) != std::string::npos) {
+                        simFail(step.where, "unexpected reply \"" + line + "\"");
+                    }
+                }
+                break;
+        }
+    }
+    return simDrain(0, options.timeoutMs);
+}
+
+// Sends what is typed on stdin and writes it out as a session
+int simRecord(const SimOptions& options) {
+    std::ofstream out(options.record);
+    if (!out) {
+        std::cerr << options.record << ": cannot write\n";
+        return 1;
+    }
+    out << "# Recorded by capyboo_sim --record\n";
+    SimClock::time_point last = SimClock::now();
+    std::string line;
+    while (std::getline(std::cin, line)) {
+        if (line.empty()) continue;
+        SimClock::time_point now = SimClock::now();
+        int pause = (int)std::chrono::duration_cast<std::chrono::milliseconds>(now - last).count();
+        last = now;
+        if (pause > 0) out << "@wait " << pause << "\n";
+
+        uint16_t id = simNextId++;
+        simInFlight[id] = {now, true, line, "stdin"};
+        simSendAll(simFrame("#" + std::to_string(id) + " " + line));
+        simLines.clear();
+        simDrain(0, options.timeoutMs);
+        if (simFailures > 0) {
+            // Nacked: replay expects the same
+            out << "!";
+            simFailures = 0;
+        }
+        out << line << "\n";
+        for (const std::string& reply : simLines) std::cout << reply << "\n";
+    }
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+
+double simPercentile(std::vector<double>& sorted, double p) {
+    if (sorted.empty()) return 0;
+    size_t index = std::min(sorted.size() - 1, (size_t)(p * sorted.size()));
+    return sorted[index];
+}
+
+bool simConnect(const SimOptions& options, uint16_t port) {
+    addrinfo hints = {};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* found = nullptr;
+    if (getaddrinfo(options.host.c_str(), std::to_string(port).c_str(), &hints, &found) != 0) return false;
+    simSocket = socket(AF_INET, SOCK_STREAM, 0);
+    bool ok = simSocket >= 0 && connect(simSocket, found->ai_addr, found->ai_addrlen) == 0;
+    freeaddrinfo(found);
+    if (!ok) return false;
+    int on = 1;
+    setsockopt(simSocket, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    return true;
+}
+
+void simUsage() {
+    std::cerr <<
+        "usage: capyboo_sim [options] session.txt...\n"
+        "  --pipeline N        commands in flight at once (4)\n"
+        "  --repeat N          run the sessions N times (1)\n"
+        "  --timeout MS        longest wait for a result or an expected reply (5000)\n"
+        "  --delay-scale X     scale the sketch's delay() calls; 0 only yields (1)\n"
+        "  --port N            port for the built-in sketch; 0 picks a free one (0)\n"
+        "  --connect HOST:PORT drive a device on ble_transport_tcp.h instead\n"
+        "  --record FILE       send commands typed on stdin and save them as a session\n"
+        "  --verbose           show the sketch's serial output and every reply\n";
+}
+
+int simExit(int code) {
+    // The sketch's loop() never returns; leave without running destructors
+    std::cout.flush();
+    std::cerr.flush();
+    fflush(stdout);
+    _exit(code);
+}
+
+int main(int argc, char** argv) {
+    SimOptions options;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--pipeline" && hasValue) {
+            options.pipeline = std::max(1, atoi(argv[++i]));
+        } else if (arg == "--repeat" && hasValue) {
+            options.repeat = std::max(1, atoi(argv[++i]));
+        } else if (arg == "--timeout" && hasValue) {
+            options.timeoutMs = atoi(argv[++i]);
+        } else if (arg == "--delay-scale" && hasValue) {
+            options.delayScale = atof(argv[++i]);
+        } else if (arg == "--port" && hasValue) {
+            options.port = atoi(argv[++i]);
+        } else if (arg == "--connect" && hasValue) {
+            std::string target = argv[++i];
+            size_t colon = target.rfind(':');
+            if (colon == std::string::npos) {
+                simUsage();
+                return 2;
+            }
+            options.host = target.substr(0, colon);
+            options.port = atoi(target.c_str() + colon + 1);
+            options.external = true;
+        } else if (arg == "--record" && hasValue) {
+            options.record = argv[++i];
+        } else if (arg == "--verbose") {
+            options.verbose = true;
+        } else if (arg[0] != '-') {
+            options.sessions.push_back(arg);
+        } else {
+            simUsage();
+            return 2;
+        }
+    }
+    if (options.sessions.empty() == options.record.empty()) {
+        simUsage();
+        return 2;
+    }
+
+    std::vector<SimStep> steps;
+    for (const std::string& path : options.sessions) {
+        if (!simLoad(path, steps)) return 2;
+    }
+    simVerbose = options.verbose;
+
+    uint16_t port = options.port;
+    if (!options.external) {
+        hostDelayScale = options.delayScale;
+        hostSerialEcho = options.verbose;
+        blePosixPort = options.port;
+        setup();
+        port = blePosixPort;
+        std::thread([] {
+            for (;;) loop();
+        }).detach();
+    }
+    if (!simConnect(options, port)) {
+        std::cerr << "cannot connect to " << options.host << ":" << port << "\n";
+        return simExit(1);
+    }
+    if (!options.record.empty()) return simExit(simRecord(options));
+
+    SimClock::time_point start = SimClock::now();
+    bool completed = true;
+    for (int pass = 0; pass < options.repeat && completed; pass++) {
+        completed = simRun(steps, options);
+    }
+    double seconds = std::chrono::duration<double>(SimClock::now() - start).count();
+
+    std::sort(simLatencies.begin(), simLatencies.end());
+    size_t count = simLatencies.size();
+    printf("%zu commands in %.3f s: %.0f commands/s, pipeline %d\n",
+           count, seconds, seconds > 0 ? count / seconds : 0.0, options.pipeline);
+    printf("latency ms: p50 %.2f, p95 %.2f, p99 %.2f, max %.2f\n",
+           simPercentile(simLatencies, 0.50), simPercentile(simLatencies, 0.95),
+           simPercentile(simLatencies, 0.99), count ? simLatencies.back() : 0.0);
+    if (simFailures > 0) printf("%d failures\n", simFailures);
+    return simExit(completed && simFailures == 0 ? 0 : 1);
+}
@@ -0,0 +1,265 @@
+// sntp.h against an NTP server on the loopback interface.
+//
+// The server answers from a clock of its own that runs `driftPpb` faster
+// than the device's timebase, so offset steps and the drift estimate can
+// be checked against exact expected values. The device clock is the host's
+// manual clock: ntpUpdate() runs for hours of device time in milliseconds.
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "sntp.h"
+#include "check.h"
+
+struct NtpResponder {
+    int fd = -1;
+    uint16_t port = 0;
+    int64_t baseServer = 0;       // Server UTC, us since 1970, at device time baseLocal
+    uint64_t baseLocal = 0;
+    int32_t driftPpb = 0;
+    uint8_t stratum = 2;
+    bool echoCookie = true;
+    uint32_t requests = 0;
+
+    bool open() {
+        fd = socket(AF_INET, SOCK_DGRAM, 0);
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t length = sizeof(address);
+        if (fd < 0 || bind(fd, (sockaddr*)&address, length) < 0 ||
+            getsockname(fd, (sockaddr*)&address, &length) < 0) {
+            return false;
+        }
+        port = ntohs(address.sin_port);
+        return true;
+    }
+
+    // Server time at device timebase `local` (us)
+    int64_t serverMicros(uint64_t local) const {
+        int64_t span = (int64_t)(local - baseLocal);
+        return baseServer + span + span * driftPpb / 1000000000LL;
+    }
+
+    // Changes the rate from now on without stepping the server's clock
+    void setDrift(int32_t ppb) {
+        uint64_t now = hostClockMicros();
+        baseServer = serverMicros(now);
+        baseLocal = now;
+        driftPpb = ppb;
+    }
+
+    static void writeTimestamp(uint8_t* p, int64_t micros) {
+        uint64_t seconds = micros / 1000000 + NTP_UNIX_OFFSET;
+        uint64_t fraction = ((uint64_t)(micros % 1000000) << 32) / 1000000;
+        ntpWriteU64(p, seconds << 32 | fraction);
+    }
+
+    // Answers the request waiting on the socket, if any, as if it reached
+    // the server `oneWayMs` after the device sent it
+    bool answer(uint32_t oneWayMs) {
+        uint8_t packet[NTP_PACKET_SIZE];
+        sockaddr_in from;
+        socklen_t fromLength = sizeof(from);
+        ssize_t n = recvfrom(fd, packet, sizeof(packet), MSG_DONTWAIT, (sockaddr*)&from, &fromLength);
+        if (n != NTP_PACKET_SIZE || (packet[0] & 0x07) != 3) return false;
+        requests++;
+
+        uint8_t reply[NTP_PACKET_SIZE] = {};
+        reply[0] = 0x24;                    // LI 0, version 4, mode 4 (server)
+        reply[1] = stratum;
+        if (echoCookie) memcpy(reply + 24, packet + 40, 8);
+        int64_t arrived = serverMicros(hostClockMicros() + (uint64_t)oneWayMs * 1000);
+        writeTimestamp(reply + 32, arrived);
+        writeTimestamp(reply + 40, arrived);
+        sendto(fd, reply, sizeof(reply), 0, (sockaddr*)&from, fromLength);
+        return true;
+    }
+};
+
+NtpResponder server;
+int64_t maxClockError = 0;          // Largest |clock error| seen by runFor()
+
+// Device local time minus what the server says it is, in ms
+int64_t clockError() {
+    int64_t local = server.serverMicros(hostClockMicros()) / 1000 + (int64_t)ntpUtcOffset * 1000;
+    return clockEpochMillis() - local;
+}
+
+// Runs the client for `seconds` of device time. Requests are answered at
+// once and the reply arrives a round trip of `rttMs` after the request.
+void runFor(uint32_t seconds, uint32_t rttMs = 20) {
+    uint64_t end = hostClockMicros() + (uint64_t)seconds * 1000000;
+    while (hostClockMicros() < end) {
+        ntpUpdate();
+        if (ntpWaiting && server.answer(rttMs / 2)) {
+            hostClockAdvance((uint64_t)rttMs * 1000);
+            ntpUpdate();
+        } else if (ntpWaiting) {
+            hostClockAdvance(10000);            // Until it gives up
+        } else {
+            uint64_t next = std::max<uint64_t>(ntpNextSyncMillis * 1000, hostClockMicros() + 1000);
+            hostClockAdvance(std::min(next, end) - hostClockMicros());
+        }
+        if (ntpSynced) maxClockError = std::max(maxClockError, std::abs(clockError()));
+    }
+}
+
+void testNoWifi() {
+    hostWifiStatus = WL_DISCONNECTED;
+    runFor(5);
+    CHECK_EQ(server.requests, 0);
+    CHECK(!ntpSynced);
+    CHECK(strstr(ntpStatus().c_str(), "waiting for WiFi") != nullptr);
+    hostWifiStatus = WL_CONNECTED;
+}
+
+// A manual "time:" before the first sync implies the time zone
+void testFirstSync() {
+    int64_t serverNow = server.serverMicros(hostClockMicros()) / 1000000;
+    CalendarTime manual;
+    calendarFromEpoch(serverNow + 2 * 3600 + 37, manual);
+    CHECK(setTime(manual.hour, manual.minute, manual.second, manual.day, manual.month, manual.year));
+
+    runFor(1);
+    CHECK_EQ(server.requests, 1);
+    CHECK(ntpSynced);
+    CHECK_EQ(ntpUtcOffset, 2 * 3600);
+    CHECK(ntpLastResidualMs <= -36000 && ntpLastResidualMs >= -38000);
+    CHECK(std::abs(clockError()) <= 2);
+    CHECK_EQ(ntpInterval, NTP_MIN_INTERVAL);
+}
+
+// The clock steps by exactly the error the server shows
+void testOffsetStep() {
+    String reply;
+    CHECK(ntpCommand(spanOf("tz=-03:30"), reply));
+    runFor(1);
+    CHECK_EQ(ntpUtcOffset, -(3 * 3600 + 30 * 60));
+    CHECK(std::abs(ntpLastResidualMs + (2 * 3600 + 3 * 3600 + 30 * 60) * 1000) <= 2);
+    CHECK(std::abs(clockError()) <= 2);
+
+    clockSync(clockEpochMillis() + 1500, timebaseMillis());
+    CHECK_EQ(clockError(), 1500);
+    ntpSyncNow();
+    runFor(1);
+    CHECK(std::abs(ntpLastResidualMs + 1500) <= 2);
+    CHECK(std::abs(clockError()) <= 2);
+}
+
+// A server running 50 ppm fast: the estimate converges on it, the poll
+// interval backs off, and between syncs the clock stays well inside what
+// 50 ppm would add up to
+void testDrift() {
+    server.setDrift(50000);
+    uint32_t previousInterval = ntpInterval;
+    bool intervalShrank = false;
+    uint64_t end = hostClockMicros() + 12ULL * 3600 * 1000000;
+    while (hostClockMicros() < end) {
+        runFor(60);
+        if (ntpInterval < previousInterval) intervalShrank = true;
+        previousInterval = ntpInterval;
+    }
+    printf("drift %d ppb, interval %u s, residual %d ms\n", timeDriftPpb, ntpInterval, ntpLastResidualMs);
+    CHECK(ntpDriftKnown);
+    CHECK(std::abs(timeDriftPpb - 50000) <= 2000);
+    CHECK(!intervalShrank);
+    CHECK(ntpInterval >= 8 * NTP_DRIFT_MIN_SPAN);
+    CHECK(std::abs(ntpLastResidualMs) <= NTP_GOOD_OFFSET_MS);
+
+    // Six hours on without a sync
+    maxClockError = 0;
+    ntpNextSyncMillis = UINT64_MAX;
+    runFor(6 * 3600);
+    printf("max error without sync %lld ms\n", (long long)maxClockError);
+    CHECK(maxClockError <= 100);        // 50 ppm uncorrected: 1080 ms
+    ntpSyncNow();
+    runFor(1);
+}
+
+// The oscillator changes: samples pull the estimate over, smoothed
+void testDriftChange() {
+    server.setDrift(-30000);
+    runFor(7 * 24 * 3600);
+    printf("drift %d ppb, interval %u s\n", timeDriftPpb, ntpInterval);
+    CHECK(std::abs(timeDriftPpb + 30000) <= 3000);
+    CHECK(std::abs(clockError()) <= 100);
+}
+
+// One name lookup for all those syncs; again after a request goes
+// unanswered, after WiFi comes back and for a new server
+void testLookups() {
+    CHECK_EQ(hostDnsLookups, 1);
+
+    ntpSyncNow();
+    runFor(1);
+    CHECK_EQ(hostDnsLookups, 1);
+
+    uint32_t requests = server.requests;
+    ntpSyncNow();
+    ntpUpdate();
+    while (ntpWaiting) {
+        hostClockAdvance(10000);
+        ntpUpdate();
+    }
+    runFor(NTP_RETRY_INTERVAL + 1);
+    CHECK_EQ(hostDnsLookups, 2);
+    CHECK(server.requests > requests);
+
+    hostWifiStatus = WL_DISCONNECTED;
+    ntpUpdate();
+    hostWifiStatus = WL_CONNECTED;
+    ntpSyncNow();
+    runFor(1);
+    CHECK_EQ(hostDnsLookups, 3);
+
+    ntpSetServer("localhost", server.port);
+    runFor(1);
+    CHECK_EQ(hostDnsLookups, 4);
+    CHECK(ntpSynced);
+}
+
+// Replies that must not touch the clock
+void testRejected() {
+    uint32_t generation = clockGeneration;
+    server.stratum = 0;
+    ntpSyncNow();
+    runFor(1);
+    CHECK_EQ(clockGeneration, generation);
+    CHECK(!ntpWaiting);
+    server.stratum = 2;
+
+    server.echoCookie = false;
+    ntpSyncNow();
+    runFor(3);
+    CHECK_EQ(clockGeneration, generation);
+    server.echoCookie = true;
+
+    ntpSyncNow();
+    runFor(1, 1500);
+    CHECK_EQ(clockGeneration, generation);
+
+    ntpSyncNow();
+    runFor(1);
+    CHECK(clockGeneration != generation);
+    CHECK(std::abs(clockError()) <= 2);
+}
+
+int main() {
+    if (!CHECK(server.open())) return checkExit("sntp_test");
+    hostClockManual(true);
+    server.baseServer = calendarToEpoch(2025, 6, 1, 12, 0, 0) * 1000000 + 123456;
+    server.baseLocal = hostClockMicros();
+    ntpSetServer("127.0.0.1", server.port);
+
+    testNoWifi();
+    testFirstSync();
+    testOffsetStep();
+    testDrift();
+    testDriftChange();
+    testLookups();
+    testRejected();
+    return checkExit("sntp_test");
+}
@@ -0,0 +1,132 @@
+// timebase.h: the calendar against the C library, second by second, and
+// the millis() wrap counting.
+//
+//   timebase_test [first-year [last-year]]      (default 2020 2099)
+
+#include <time.h>
+#include <random>
+
+#include "timebase.h"
+#include "check.h"
+
+static bool sameAsLibc(const CalendarTime& t, const struct tm& tm) {
+    return t.year == tm.tm_year + 1900 && t.month == tm.tm_mon + 1 && t.day == tm.tm_mday &&
+           t.hour == tm.tm_hour && t.minute == tm.tm_min && t.second == tm.tm_sec && t.weekday == tm.tm_wday;
+}
+
+static bool sameCalendar(const CalendarTime& a, const CalendarTime& b) {
+    return a.epoch == b.epoch && a.year == b.year && a.month == b.month && a.day == b.day && a.hour == b.hour &&
+           a.minute == b.minute && a.second == b.second && a.weekday == b.weekday;
+}
+
+static void reportMismatch(const char* what, const CalendarTime& t, const struct tm& tm) {
+    fprintf(stderr, "%s at %lld: %04d-%02d-%02d %02d:%02d:%02d wd%d, libc %04d-%02d-%02d %02d:%02d:%02d wd%d\n",
+            what, (long long)t.epoch, t.year, t.month, t.day, t.hour, t.minute, t.second, t.weekday,
+            tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday, tm.tm_hour, tm.tm_min, tm.tm_sec, tm.tm_wday);
+}
+
+// Every second from the start of `firstYear` to the end of `lastYear`:
+// calendarAdvance() one second at a time, calendarFromEpoch() from
+// scratch and gmtime_r() must all agree
+static void testEverySecond(int firstYear, int lastYear) {
+    int64_t begin = calendarToEpoch(firstYear, 1, 1, 0, 0, 0);
+    int64_t end = calendarToEpoch(lastYear + 1, 1, 1, 0, 0, 0);
+    CalendarTime stepped;
+    calendarFromEpoch(begin, stepped);
+    long long mismatches = 0;
+
+    for (int64_t epoch = begin; epoch < end; epoch++) {
+        calendarAdvance(stepped, epoch);
+        CalendarTime full;
+        calendarFromEpoch(epoch, full);
+        time_t seconds = epoch;
+        struct tm tm;
+        gmtime_r(&seconds, &tm);
+
+        bool ok = sameAsLibc(full, tm) && sameCalendar(stepped, full);
+        if (!ok && mismatches++ < 10) {
+            reportMismatch("calendarFromEpoch", full, tm);
+            reportMismatch("calendarAdvance", stepped, tm);
+        }
+    }
+    CHECK_EQ(mismatches, 0);
+    printf("%lld seconds, %d-%d\n", (long long)(end - begin), firstYear, lastYear);
+}
+
+// Jumps of any size in either direction, as clock steps produce
+static void testJumps() {
+    std::mt19937_64 random(2020);
+    int64_t low = calendarToEpoch(2020, 1, 1, 0, 0, 0);
+    int64_t high = calendarToEpoch(2100, 1, 1, 0, 0, 0);
+    CalendarTime t;
+    calendarFromEpoch(low, t);
+    for (int i = 0; i < 1000000; i++) {
+        int64_t delta;
+        switch (random() % 4) {
+            case 0: delta = (int64_t)(random() % 120); break;                       // A few seconds
+            case 1: delta = (int64_t)(random() % 86400); break;                     // Within a day or over midnight
+            case 2: delta = (int64_t)(random() % (3 * 86400)) - 86400; break;       // Backwards too
+            default: delta = (int64_t)(random() % (high - low)) - (t.epoch - low);  // Anywhere
+        }
+        int64_t epoch = std::max(low, std::min(high - 1, t.epoch + delta));
+        calendarAdvance(t, epoch);
+        time_t seconds = epoch;
+        struct tm tm;
+        gmtime_r(&seconds, &tm);
+        if (!CHECK(t.epoch == epoch && sameAsLibc(t, tm))) {
+            reportMismatch("jump", t, tm);
+            return;
+        }
+    }
+}
+
+// Midnight of every day round trips through calendarToEpoch()
+static void testToEpoch(int firstYear, int lastYear) {
+    for (int year = firstYear; year <= lastYear; year++) {
+        for (int month = 1; month <= 12; month++) {
+            for (int day = 1; day <= calendarDaysInMonth(year, month); day++) {
+                struct tm tm = {};
+                tm.tm_year = year - 1900;
+                tm.tm_mon = month - 1;
+                tm.tm_mday = day;
+                if (!CHECK_EQ(calendarToEpoch(year, month, day, 0, 0, 0), timegm(&tm))) return;
+            }
+        }
+    }
+}
+
+// timebaseMillis() keeps counting where the 32-bit millis() wraps
+static void testMillisWrap() {
+    hostClockManual(true);
+    uint64_t start = hostClockMicros() / 1000;
+    CHECK_EQ(timebaseMillis(), start);
+
+    // Up to just short of the wrap, sampling well within each wrap period
+    uint64_t target = 0xFFFFFFFFULL - 2000;
+    while (hostClockMicros() / 1000 < target) {
+        hostClockAdvance(std::min<uint64_t>(target - hostClockMicros() / 1000, 3600000ULL) * 1000);
+        timebaseMillis();
+    }
+    uint64_t last = timebaseMillis();
+    for (int i = 0; i < 5000; i++) {
+        hostClockAdvance(1000);
+        uint64_t now = timebaseMillis();
+        if (!CHECK_EQ(now, last + 1)) return;
+        last = now;
+    }
+    CHECK(last > 0xFFFFFFFFULL);
+    CHECK_EQ(last, hostClockMicros() / 1000);
+    CHECK_EQ(timebaseMicros(), last * 1000);
+    hostClockManual(false);
+}
+
+int main(int argc, char** argv) {
+    int firstYear = argc > 1 ? atoi(argv[1]) : 2020;
+    int lastYear = argc > 2 ? atoi(argv[2]) : 2099;
+
+    testToEpoch(firstYear, lastYear);
+    testJumps();
+    testMillisWrap();
+    testEverySecond(firstYear, lastYear);
+    return checkExit("timebase_test");
+}
@@ -0,0 +1,59 @@
+#!/usr/bin/env python3
+"""Turn a sketch into C++ the way the Arduino builder does.
+
+The builder prepends #include <Arduino.h> and declares every function the
+.ino defines ahead of the first definition, so the sketch can call
+functions defined further down. This does the same for the host build:
+
+    ino2cpp.py capyboo.ino capyboo_sketch.cpp
+
+#line directives keep compiler messages pointing into the .ino.
+"""
+
+import re
+import sys
+
+# A function definition starting at column 0: return type, name, one-line
+# parameter list, opening brace on the same line
+DEFINITION = re.compile(r'^([A-Za-z_][\w:<>*& ]*?[\s*&]+)([A-Za-z_]\w*)\s*\(([^;{)]*)\)\s*(?:const\s*)?\{')
+NOT_TYPES = {'else', 'return', 'switch', 'if', 'while', 'for', 'do', 'case', 'struct', 'class', 'enum', 'union',
+             'typedef', 'namespace'}
+
+
+def main(source_path, output_path):
+    with open(source_path) as f:
+        lines = f.read().split('\n')
+
+    prototypes = []
+    first = None
+    depth = 0
+    for number, line in enumerate(lines):
+        match = DEFINITION.match(line) if depth == 0 else None
+        if match and match.group(1).split()[0] not in NOT_TYPES:
+            return_type, name, parameters = match.groups()
+            # Default arguments belong to the first declaration only
+            parameters = re.sub(r'\s*=[^,]*', '', parameters)
+            prototypes.append('%s%s(%s);' % (return_type, name, parameters))
+            if first is None:
+                first = number
+        # Only top-level definitions count; a rough brace count is enough
+        code = re.sub(r'"(\\.|[^"\\])*"|\'(\\.|[^\'\\])*\'|//.*', '', line)
+        depth += code.count('{') - code.count('}')
+
+    source = source_path.replace('\\', '/')
+    out = ['#include <Arduino.h>', '#line 1 "%s"' % source]
+    if first is None:
+        out += lines
+    else:
+        out += lines[:first]
+        out += prototypes
+        out.append('#line %d "%s"' % (first + 1, source))
+        out += lines[first:]
+    with open(output_path, 'w') as f:
+        f.write('\n'.join(out))
+
+
+if __name__ == '__main__':
+    if len(sys.argv) != 3:
+        sys.exit('usage: ino2cpp.py SKETCH.ino OUTPUT.cpp')
+    main(sys.argv[1], sys.argv[2])